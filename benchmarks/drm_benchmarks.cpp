@@ -0,0 +1,433 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Micro-benchmarks of the hot primitives of the library.
+
+    - Hexadecimal conversions of the DRM Controller SDK data converter.
+    - Register name from index and register offset from name.
+    - Register list read over an in-memory register bus.
+    - Register access messages, with the plain spdlog macro and with the RegTrace
+      guard, for several logging levels.
+    - JSON parsing and serialization of License Web Service payloads.
+    - DrmManager parameter dispatch and mailbox accesses, on the DRM Controller
+      simulator (tests/simulator).
+    - C API typed accessors compared with their JSON equivalents, on the
+      simulator.
+
+    The results are saved in JSON format in "drm_benchmarks.json" unless the
+    "--benchmark_out" option is given, so that they can be compared between
+    releases with the "compare.py" tool of Google Benchmark.
+*/
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "accelize/drm.h"
+#include "accelize/drmc.h"
+#include "DrmControllerDataConverter.hpp"
+#include "HAL/DrmControllerRegistersBase.hpp"
+#include "drm_controller_sim.h"
+#include "log.h"
+#include "utils.h"
+
+using namespace Accelize::DRM;
+using namespace DrmControllerLibrary;
+
+
+// Size of a license key with one activator, in 32 bits words
+static const uint32_t LICENSE_KEY_WORDS = 44;
+
+// Number of registers of a DRM Controller page
+static const uint32_t NB_PAGE_REGISTERS = 64;
+
+
+static std::string makeHexString( uint32_t nb_words ) {
+    std::string hex;
+    char word[9];
+    for( uint32_t i = 0; i < nb_words; i++ ) {
+        snprintf( word, sizeof( word ), "%08X", 0x9E3779B9u * ( i + 1 ) );
+        hex += word;
+    }
+    return hex;
+}
+
+static const std::string sLicenseKey = makeHexString( LICENSE_KEY_WORDS );
+
+// License Web Service response to a license request, as produced by tests/ws_mock.py
+static const std::string sLicenseResponse =
+    "{\"metering\": {\"healthPeriod\": 300, \"healthRetry\": 0, \"healthRetrySleep\": 10,"
+    " \"sessionId\": \"" + sLicenseKey.substr( 0, 16 ) + "\", \"timeoutSecond\": 3600},"
+    " \"license\": {\"" + makeHexString( 4 ) + "\": {\"key\": \"" + sLicenseKey + "\","
+    " \"licenseTimer\": \"" + makeHexString( 24 ) + "\"}}}";
+
+// Health request body
+static const std::string sHealthRequest =
+    "{\"request\": \"health\", \"sessionId\": \"" + sLicenseKey.substr( 0, 16 ) + "\","
+    " \"dna\": \"" + makeHexString( 4 ) + "\", \"drmVersion\": \"7.0.0\", \"lgdnVersion\": \"2.0.0\","
+    " \"meteringFile\": [\"" + makeHexString( 8 ) + "\", \"" + makeHexString( 8 ) + "\","
+    " \"" + makeHexString( 8 ) + "\", \"" + makeHexString( 8 ) + "\"],"
+    " \"saasChallenge\": \"" + makeHexString( 4 ) + "\", \"drm_frequency\": 125, \"mode\": 1}";
+
+
+/* DRM Controller SDK data converter */
+
+static void BM_HexStringToBinary( benchmark::State& state ) {
+    for( auto _: state )
+        benchmark::DoNotOptimize( DrmControllerDataConverter::hexStringToBinary( sLicenseKey ) );
+    state.SetBytesProcessed( state.iterations() * sLicenseKey.size() );
+}
+BENCHMARK( BM_HexStringToBinary );
+
+static void BM_BinaryToHexString( benchmark::State& state ) {
+    const std::vector<unsigned int> binary = DrmControllerDataConverter::hexStringToBinary( sLicenseKey );
+    for( auto _: state )
+        benchmark::DoNotOptimize( DrmControllerDataConverter::binaryToHexString( binary ) );
+    state.SetBytesProcessed( state.iterations() * binary.size() * sizeof( unsigned int ) );
+}
+BENCHMARK( BM_BinaryToHexString );
+
+static void BM_BinaryToHexStringList( benchmark::State& state ) {
+    const std::vector<unsigned int> binary = DrmControllerDataConverter::hexStringToBinary( sLicenseKey );
+    for( auto _: state )
+        benchmark::DoNotOptimize( DrmControllerDataConverter::binaryToHexStringList( binary, 4 ) );
+}
+BENCHMARK( BM_BinaryToHexStringList );
+
+
+/* Register names and offsets */
+
+/// In-memory register bus accessed by name like the DRM Controller SDK does, with the
+/// register offsets of the DrmManager callbacks
+class FakeRegisterBus: public DrmControllerRegistersBase {
+public:
+    FakeRegisterBus(): DrmControllerRegistersBase(
+            [this]( const std::string& name, unsigned int& value ) { return read( name, value ); },
+            [this]( const std::string& name, const unsigned int& value ) { return write( name, value ); } ) {
+        setIndexedRegisterName( "DrmRegisterLine" );
+        for( uint32_t i = 0; i < mRegisters.size(); i++ )
+            mRegisters[i] = i;
+    }
+
+private:
+    std::array<uint32_t, NB_PAGE_REGISTERS + 1> mRegisters;
+
+    unsigned int read( const std::string& name, unsigned int& value ) const {
+        uint32_t offset = getDrmRegisterOffset( name );
+        if ( offset / 4 >= mRegisters.size() )
+            return 1;
+        value = mRegisters[offset / 4];
+        return 0;
+    }
+
+    unsigned int write( const std::string& name, const unsigned int& value ) {
+        uint32_t offset = getDrmRegisterOffset( name );
+        if ( offset / 4 >= mRegisters.size() )
+            return 1;
+        mRegisters[offset / 4] = value;
+        return 0;
+    }
+};
+
+static void BM_RegisterNameFromIndex( benchmark::State& state ) {
+    FakeRegisterBus bus;
+    uint32_t index = 0;
+    for( auto _: state ) {
+        benchmark::DoNotOptimize( bus.registerNameFromIndex( index ) );
+        index = ( index + 1 ) % NB_PAGE_REGISTERS;
+    }
+}
+BENCHMARK( BM_RegisterNameFromIndex );
+
+static void BM_RegisterNameToOffset( benchmark::State& state ) {
+    FakeRegisterBus bus;
+    uint32_t index = 0;
+    for( auto _: state ) {
+        benchmark::DoNotOptimize( getDrmRegisterOffset( bus.registerNameFromIndex( index ) ) );
+        index = ( index + 1 ) % NB_PAGE_REGISTERS;
+    }
+}
+BENCHMARK( BM_RegisterNameToOffset );
+
+static void BM_ReadRegisterListFromIndex( benchmark::State& state ) {
+    FakeRegisterBus bus;
+    std::vector<unsigned int> values;
+    const unsigned int nb_registers = (unsigned int)state.range( 0 );
+    for( auto _: state ) {
+        if ( bus.readRegisterListFromIndex( 0, nb_registers, values ) )
+            state.SkipWithError( "Register read failed" );
+        benchmark::DoNotOptimize( values.data() );
+    }
+    state.SetItemsProcessed( state.iterations() * nb_registers );
+}
+BENCHMARK( BM_ReadRegisterListFromIndex )->Arg( 4 )->Arg( 16 )->Arg( NB_PAGE_REGISTERS );
+
+
+/* Register access messages */
+
+static volatile uint32_t sRegister = 0;
+
+static uint32_t readNoLog( uint32_t address ) {
+    return sRegister + address;
+}
+
+static uint32_t readDebug2( uint32_t address ) {
+    uint32_t value = sRegister + address;
+    Debug2( "Read DRM Ctrl address 0x{:x} = 0x{:08x}", address, value );
+    return value;
+}
+
+static uint32_t readRegTrace( uint32_t address ) {
+    uint32_t value = sRegister + address;
+    RegTrace( "Read DRM Ctrl address 0x{:x} = 0x{:08x}", address, value );
+    return value;
+}
+
+// Emit the message of a simulated register read at the logging level given as argument:
+// the messages are formatted but discarded so that only the logging cost is measured
+template<uint32_t (*Read)( uint32_t )> static void BM_RegisterLog( benchmark::State& state ) {
+    if ( !sLogger ) {
+        sLogger = std::make_shared<spdlog::logger>( "drmlib_logger", std::make_shared<spdlog::sinks::null_sink_mt>() );
+        spdlog::set_default_logger( sLogger );
+    }
+    setLogLevel( (spdlog::level::level_enum)state.range( 0 ) );
+    uint32_t address = 0;
+    for( auto _: state ) {
+        benchmark::DoNotOptimize( Read( address ) );
+        address = ( address + 4 ) & 0xFC;
+    }
+    state.SetLabel( spdlog::level::to_string_view( (spdlog::level::level_enum)state.range( 0 ) ).data() );
+}
+#define REGISTER_LOG_LEVELS Arg( spdlog::level::off )->Arg( spdlog::level::info )->Arg( spdlog::level::trace )
+BENCHMARK_TEMPLATE( BM_RegisterLog, readNoLog )->REGISTER_LOG_LEVELS;
+BENCHMARK_TEMPLATE( BM_RegisterLog, readDebug2 )->REGISTER_LOG_LEVELS;
+BENCHMARK_TEMPLATE( BM_RegisterLog, readRegTrace )->REGISTER_LOG_LEVELS;
+
+
+/* JSON payloads */
+
+static void BM_ParseLicenseResponse( benchmark::State& state ) {
+    for( auto _: state )
+        benchmark::DoNotOptimize( parseJsonString( sLicenseResponse ) );
+    state.SetBytesProcessed( state.iterations() * sLicenseResponse.size() );
+}
+BENCHMARK( BM_ParseLicenseResponse );
+
+static void BM_ParseHealthRequest( benchmark::State& state ) {
+    for( auto _: state )
+        benchmark::DoNotOptimize( parseJsonString( sHealthRequest ) );
+    state.SetBytesProcessed( state.iterations() * sHealthRequest.size() );
+}
+BENCHMARK( BM_ParseHealthRequest );
+
+static void BM_SaveLicenseResponse( benchmark::State& state ) {
+    const Json::Value license = parseJsonString( sLicenseResponse );
+    for( auto _: state )
+        benchmark::DoNotOptimize( saveJsonToString( license ) );
+}
+BENCHMARK( BM_SaveLicenseResponse );
+
+static void BM_SaveHealthRequest( benchmark::State& state ) {
+    const Json::Value request = parseJsonString( sHealthRequest );
+    for( auto _: state )
+        benchmark::DoNotOptimize( saveJsonToString( request ) );
+}
+BENCHMARK( BM_SaveHealthRequest );
+
+
+/* DrmManager parameters, on the DRM Controller simulator */
+
+/// DrmManager instance on a simulated DRM Controller, without session
+class DrmManagerFixture: public benchmark::Fixture {
+public:
+    void SetUp( const benchmark::State& ) override {
+        if ( mDrm )
+            return;
+        mDir = "/tmp/drm_benchmarks_" + std::to_string( getpid() );
+        makeDirs( mDir, 0700 );
+        // The Web Service is never contacted: no session is opened
+        saveJsonToFile( mDir + "/conf.json", parseJsonString(
+            "{\"licensing\": {\"url\": \"http://127.0.0.1:1\"}, \"drm\": {\"frequency_mhz\": 125},"
+            " \"settings\": {\"log_verbosity\": 6}}" ) );
+        saveJsonToFile( mDir + "/cred.json", parseJsonString(
+            "{\"client_id\": \"benchmark\", \"client_secret\": \"benchmark\"}" ) );
+        if ( DrmControllerSim_alloc( &mSim, "7.0.0", 1 ) )
+            throw std::runtime_error( "Cannot create the DRM Controller simulator" );
+        DrmControllerSim* sim = mSim;
+        mDrm.reset( new Accelize::DRM::DrmManager( mDir + "/conf.json", mDir + "/cred.json",
+            [sim]( uint32_t offset, uint32_t* value ) { return DrmControllerSim_read_register( sim, offset, value ); },
+            [sim]( uint32_t offset, uint32_t value ) { return DrmControllerSim_write_register( sim, offset, value ); },
+            []( const std::string& ) {} ) );
+    }
+
+    void TearDown( const benchmark::State& ) override {
+        mDrm.reset();
+        DrmControllerSim_free( &mSim );
+        unlink( ( mDir + "/conf.json" ).c_str() );
+        unlink( ( mDir + "/cred.json" ).c_str() );
+        rmdir( mDir.c_str() );
+    }
+
+protected:
+    std::string mDir;
+    DrmControllerSim* mSim = nullptr;
+    std::unique_ptr<Accelize::DRM::DrmManager> mDrm;
+};
+
+BENCHMARK_F( DrmManagerFixture, GetParameterByKey )( benchmark::State& state ) {
+    for( auto _: state )
+        benchmark::DoNotOptimize( mDrm->get<int32_t>( ParameterKey::log_verbosity ) );
+}
+
+BENCHMARK_F( DrmManagerFixture, SetParameterByKey )( benchmark::State& state ) {
+    for( auto _: state )
+        mDrm->set<int32_t>( ParameterKey::log_verbosity, 6 );
+}
+
+// Includes the parameter name lookup of findParameterKey
+BENCHMARK_F( DrmManagerFixture, GetParameterByName )( benchmark::State& state ) {
+    for( auto _: state ) {
+        std::string json_string = "{\"log_verbosity\": null, \"log_format\": null, \"frequency_detection_method\": null}";
+        mDrm->get( json_string );
+        benchmark::DoNotOptimize( json_string );
+    }
+}
+
+BENCHMARK_F( DrmManagerFixture, SetParameterByName )( benchmark::State& state ) {
+    const std::string json_string = "{\"log_verbosity\": 6}";
+    for( auto _: state )
+        mDrm->set( json_string );
+}
+
+BENCHMARK_F( DrmManagerFixture, MailboxReadWord )( benchmark::State& state ) {
+    for( auto _: state )
+        benchmark::DoNotOptimize( mDrm->get<uint32_t>( ParameterKey::custom_field ) );
+}
+
+BENCHMARK_F( DrmManagerFixture, MailboxWriteWord )( benchmark::State& state ) {
+    uint32_t value = 0;
+    for( auto _: state )
+        mDrm->set<uint32_t>( ParameterKey::custom_field, value++ );
+}
+
+BENCHMARK_F( DrmManagerFixture, MailboxReadUserData )( benchmark::State& state ) {
+    for( auto _: state ) {
+        std::string json_string = "{\"mailbox_data\": null}";
+        mDrm->get( json_string );
+        benchmark::DoNotOptimize( json_string );
+    }
+}
+
+
+/* C API typed accessors and their JSON equivalents, on the DRM Controller simulator */
+
+/// C API DrmManager instance on a simulated DRM Controller, without session
+class CDrmManagerFixture: public DrmManagerFixture {
+public:
+    void SetUp( const benchmark::State& state ) override {
+        if ( mCDrm )
+            return;
+        DrmManagerFixture::SetUp( state );
+        mDrm.reset();
+        if ( DrmManager_alloc( &mCDrm, ( mDir + "/conf.json" ).c_str(), ( mDir + "/cred.json" ).c_str(),
+                DrmControllerSim_read_register_callback, DrmControllerSim_write_register_callback,
+                []( const char*, void* ) {}, mSim ) )
+            throw std::runtime_error( mCDrm->error_message );
+    }
+
+    void TearDown( const benchmark::State& state ) override {
+        DrmManager_free( &mCDrm );
+        mCDrm = nullptr;
+        DrmManagerFixture::TearDown( state );
+    }
+
+protected:
+    ::DrmManager* mCDrm = nullptr;
+
+    void getJson( benchmark::State& state, const char* json_in ) {
+        for( auto _: state ) {
+            char* json_out = nullptr;
+            if ( DrmManager_get_json_string( mCDrm, json_in, &json_out ) )
+                state.SkipWithError( mCDrm->error_message );
+            benchmark::DoNotOptimize( json_out );
+            free( json_out );
+        }
+    }
+};
+
+BENCHMARK_F( CDrmManagerFixture, CGetLicenseStatus )( benchmark::State& state ) {
+    bool value = false;
+    for( auto _: state ) {
+        if ( DrmManager_get_bool( mCDrm, DRM__license_status, &value ) )
+            state.SkipWithError( mCDrm->error_message );
+        benchmark::DoNotOptimize( value );
+    }
+}
+
+BENCHMARK_F( CDrmManagerFixture, CGetLicenseStatusJson )( benchmark::State& state ) {
+    getJson( state, "{\"license_status\": null}" );
+}
+
+BENCHMARK_F( CDrmManagerFixture, CReadMetering )( benchmark::State& state ) {
+    uint64_t counts[8];
+    unsigned int nb_activators = 0;
+    for( auto _: state ) {
+        if ( DrmManager_read_metering( mCDrm, counts, 8, &nb_activators ) )
+            state.SkipWithError( mCDrm->error_message );
+        benchmark::DoNotOptimize( counts );
+    }
+}
+
+BENCHMARK_F( CDrmManagerFixture, CGetMeteredDataJson )( benchmark::State& state ) {
+    getJson( state, "{\"metered_data\": null}" );
+}
+
+BENCHMARK_F( CDrmManagerFixture, CGetLogVerbosity )( benchmark::State& state ) {
+    int value = 0;
+    for( auto _: state ) {
+        if ( DrmManager_get_int( mCDrm, DRM__log_verbosity, &value ) )
+            state.SkipWithError( mCDrm->error_message );
+        benchmark::DoNotOptimize( value );
+    }
+}
+
+
+int main( int argc, char** argv ) {
+    // Save the results in JSON format by default
+    std::vector<char*> args( argv, argv + argc );
+    bool has_out = false;
+    for( int i = 1; i < argc; i++ )
+        has_out |= std::string( argv[i] ).compare( 0, 16, "--benchmark_out=" ) == 0;
+    char out_arg[] = "--benchmark_out=drm_benchmarks.json";
+    char format_arg[] = "--benchmark_out_format=json";
+    if ( !has_out ) {
+        args.push_back( out_arg );
+        args.push_back( format_arg );
+    }
+    int nb_args = (int)args.size();
+    benchmark::Initialize( &nb_args, args.data() );
+    if ( benchmark::ReportUnrecognizedArguments( nb_args, args.data() ) )
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,405 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Drive many DrmManager instances against a License Web Service mock.
+
+    Each instance runs on its own DRM Controller simulator (tests/simulator), so
+    the licenses of the mock (tests/ws_mock.py) are accepted. The harness opens
+    the sessions, keeps them running for the requested duration and reports:
+    - the activate and deactivate latencies,
+    - the license renewal throughput and the license request latency, from the
+      runtime statistics of the library,
+    - the peak number of threads, the peak resident memory and the CPU usage of
+      the process.
+
+    Usage:
+        python3 tests/ws_mock.py --port 8080 --license-timeout 10 &
+        drm_load_test --url http://127.0.0.1:8080 --instances 200 --duration 60
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "accelize/drm.h"
+#include "drm_controller_sim.h"
+
+using namespace Accelize::DRM;
+
+typedef std::chrono::steady_clock TClock;
+
+
+struct Options {
+    std::string url;
+    std::string workDir;
+    std::string jsonPath;
+    std::string hdkVersion = "7.0.0";
+    uint32_t instances = 100;
+    uint32_t duration = 60;          // Seconds
+    uint32_t activators = 1;
+    uint32_t frequency = 125;        // MHz
+    uint32_t startThreads = 16;
+    uint32_t logVerbosity = 4;       // Error
+};
+
+
+struct Instance {
+    DrmControllerSim* sim = nullptr;
+    std::unique_ptr<DrmManager> drm;
+    std::atomic<uint32_t> asyncErrors{ 0 };
+    std::string error;
+
+    ~Instance() {
+        drm.reset();
+        DrmControllerSim_free( &sim );
+    }
+};
+
+
+struct ResourceUsage {
+    uint32_t threads = 0;
+    uint64_t rssKiB = 0;
+    double cpuSeconds = 0;
+};
+
+
+static ResourceUsage readResourceUsage() {
+    ResourceUsage usage;
+    std::ifstream status( "/proc/self/status" );
+    std::string line;
+    while( std::getline( status, line ) ) {
+        if ( line.compare( 0, 8, "Threads:" ) == 0 )
+            usage.threads = (uint32_t)std::stoul( line.substr( 8 ) );
+        else if ( line.compare( 0, 6, "VmRSS:" ) == 0 )
+            usage.rssKiB = std::stoull( line.substr( 6 ) );
+    }
+    struct rusage ru;
+    if ( getrusage( RUSAGE_SELF, &ru ) == 0 )
+        usage.cpuSeconds = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6
+                         + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+    return usage;
+}
+
+
+/// Return the quantiles of a list of durations in seconds
+static double quantile( std::vector<double> values, double q ) {
+    if ( values.empty() )
+        return 0;
+    std::sort( values.begin(), values.end() );
+    size_t index = (size_t)( q * ( values.size() - 1 ) + 0.5 );
+    return values[std::min( index, values.size() - 1 )];
+}
+
+
+/// Histogram read from the OpenMetrics text of the library
+struct MetricHistogramSamples {
+    std::vector<std::pair<std::string, uint64_t>> buckets;  // Upper bound and cumulative count
+    uint64_t count = 0;
+    double sum = 0;
+
+    /// Return the upper bound of the bucket containing the quantile
+    std::string quantile( double q ) const {
+        for( const auto& bucket: buckets )
+            if ( count && bucket.second >= q * count )
+                return bucket.first;
+        return "n/a";
+    }
+};
+
+
+static MetricHistogramSamples parseHistogram( const std::string& text, const std::string& name ) {
+    MetricHistogramSamples histogram;
+    std::istringstream lines( text );
+    std::string line;
+    const std::string bucket_prefix = name + "_bucket{le=\"";
+    while( std::getline( lines, line ) ) {
+        if ( line.compare( 0, bucket_prefix.size(), bucket_prefix ) == 0 ) {
+            size_t end = line.find( '"', bucket_prefix.size() );
+            histogram.buckets.emplace_back( line.substr( bucket_prefix.size(), end - bucket_prefix.size() ),
+                                            std::stoull( line.substr( line.rfind( ' ' ) + 1 ) ) );
+        } else if ( line.compare( 0, name.size() + 6, name + "_count" ) == 0 ) {
+            histogram.count = std::stoull( line.substr( line.rfind( ' ' ) + 1 ) );
+        } else if ( line.compare( 0, name.size() + 4, name + "_sum" ) == 0 ) {
+            histogram.sum = std::stod( line.substr( line.rfind( ' ' ) + 1 ) );
+        }
+    }
+    return histogram;
+}
+
+
+static uint64_t parseCounter( const std::string& text, const std::string& name ) {
+    std::istringstream lines( text );
+    std::string line;
+    while( std::getline( lines, line ) ) {
+        if ( line.compare( 0, name.size() + 7, name + "_total " ) == 0 )
+            return std::stoull( line.substr( line.rfind( ' ' ) + 1 ) );
+    }
+    return 0;
+}
+
+
+/// Run a function on each instance from a pool of threads, return the duration of each call in seconds
+template<typename F> std::vector<double> forEachInstance( std::vector<std::unique_ptr<Instance>>& instances,
+                                                          uint32_t nb_threads, F function ) {
+    std::vector<double> durations( instances.size(), -1 );
+    std::atomic<size_t> next( 0 );
+    std::vector<std::thread> threads;
+    for( uint32_t t = 0; t < std::min<size_t>( nb_threads, instances.size() ); t++ ) {
+        threads.emplace_back( [&]() {
+            size_t index;
+            while( ( index = next++ ) < instances.size() ) {
+                Instance& instance = *instances[index];
+                TClock::time_point start = TClock::now();
+                try {
+                    function( index, instance );
+                    durations[index] = std::chrono::duration<double>( TClock::now() - start ).count();
+                } catch( const std::exception& e ) {
+                    instance.error = e.what();
+                }
+            }
+        } );
+    }
+    for( std::thread& thread: threads )
+        thread.join();
+    durations.erase( std::remove( durations.begin(), durations.end(), -1 ), durations.end() );
+    return durations;
+}
+
+
+static void writeFile( const std::string& path, const std::string& content ) {
+    std::ofstream file( path );
+    if ( !file )
+        throw std::runtime_error( "Cannot write file " + path );
+    file << content;
+}
+
+
+static void usage( const char* program ) {
+    std::cerr << "Usage: " << program << " --url URL [options]\n"
+              << "  --url URL            License Web Service URL, for instance the one of tests/ws_mock.py\n"
+              << "  --instances N        Number of DrmManager instances (default: 100)\n"
+              << "  --duration S         Duration in seconds of the sessions (default: 60)\n"
+              << "  --hdk-version V      HDK version of the simulated DRM Controllers (default: 7.0.0)\n"
+              << "  --activators N       Number of activators per DRM Controller (default: 1)\n"
+              << "  --frequency MHZ      DRM frequency (default: 125)\n"
+              << "  --start-threads N    Number of threads activating and deactivating the sessions (default: 16)\n"
+              << "  --log-verbosity N    Console log verbosity of the library (default: 4)\n"
+              << "  --work-dir DIR       Directory of the generated configuration files (default: /tmp)\n"
+              << "  --json FILE          Save the results in a JSON file\n";
+}
+
+
+static Options parseOptions( int argc, char** argv ) {
+    static const struct option long_options[] = {
+        { "url", required_argument, nullptr, 'u' },
+        { "instances", required_argument, nullptr, 'n' },
+        { "duration", required_argument, nullptr, 'd' },
+        { "hdk-version", required_argument, nullptr, 'v' },
+        { "activators", required_argument, nullptr, 'a' },
+        { "frequency", required_argument, nullptr, 'f' },
+        { "start-threads", required_argument, nullptr, 't' },
+        { "log-verbosity", required_argument, nullptr, 'l' },
+        { "work-dir", required_argument, nullptr, 'w' },
+        { "json", required_argument, nullptr, 'j' },
+        { "help", no_argument, nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 }
+    };
+    Options options;
+    int opt;
+    while( ( opt = getopt_long( argc, argv, "", long_options, nullptr ) ) != -1 ) {
+        switch( opt ) {
+            case 'u': options.url = optarg; break;
+            case 'n': options.instances = (uint32_t)std::stoul( optarg ); break;
+            case 'd': options.duration = (uint32_t)std::stoul( optarg ); break;
+            case 'v': options.hdkVersion = optarg; break;
+            case 'a': options.activators = (uint32_t)std::stoul( optarg ); break;
+            case 'f': options.frequency = (uint32_t)std::stoul( optarg ); break;
+            case 't': options.startThreads = (uint32_t)std::max( 1ul, std::stoul( optarg ) ); break;
+            case 'l': options.logVerbosity = (uint32_t)std::stoul( optarg ); break;
+            case 'w': options.workDir = optarg; break;
+            case 'j': options.jsonPath = optarg; break;
+            default:
+                usage( argv[0] );
+                exit( opt == 'h' ? 0 : 1 );
+        }
+    }
+    if ( options.url.empty() ) {
+        usage( argv[0] );
+        exit( 1 );
+    }
+    if ( options.workDir.empty() )
+        options.workDir = "/tmp/drm_load_test_" + std::to_string( getpid() );
+    return options;
+}
+
+
+int main( int argc, char** argv ) {
+    Options options = parseOptions( argc, argv );
+
+    // Configuration shared by all the instances: the mock does not check the credentials
+    mkdir( options.workDir.c_str(), 0700 );
+    std::string conf_path = options.workDir + "/conf.json";
+    std::string cred_path = options.workDir + "/cred.json";
+    writeFile( conf_path,
+        "{\n"
+        "    \"licensing\": { \"url\": \"" + options.url + "\" },\n"
+        "    \"drm\": { \"frequency_mhz\": " + std::to_string( options.frequency ) + " },\n"
+        "    \"settings\": { \"log_verbosity\": " + std::to_string( options.logVerbosity ) + ", \"metrics\": true }\n"
+        "}\n" );
+    writeFile( cred_path, "{ \"client_id\": \"load_test\", \"client_secret\": \"load_test\" }\n" );
+
+    std::vector<std::unique_ptr<Instance>> instances;
+    for( uint32_t i = 0; i < options.instances; i++ ) {
+        instances.emplace_back( new Instance );
+        if ( DrmControllerSim_alloc( &instances.back()->sim, options.hdkVersion.c_str(), options.activators )
+          || DrmControllerSim_set_frequency( instances.back()->sim, options.frequency, 250 ) ) {
+            std::cerr << "Cannot create a simulator of HDK " << options.hdkVersion << std::endl;
+            return 1;
+        }
+    }
+    ResourceUsage initial_usage = readResourceUsage();
+
+    // Open the sessions
+    std::cout << "Activating " << options.instances << " instances on " << options.url << std::endl;
+    std::vector<double> activate_durations = forEachInstance( instances, options.startThreads,
+        [&]( size_t, Instance& instance ) {
+            DrmControllerSim* sim = instance.sim;
+            std::atomic<uint32_t>* errors = &instance.asyncErrors;
+            instance.drm.reset( new DrmManager( conf_path, cred_path,
+                [sim]( uint32_t offset, uint32_t* value ) { return DrmControllerSim_read_register( sim, offset, value ); },
+                [sim]( uint32_t offset, uint32_t value ) { return DrmControllerSim_write_register( sim, offset, value ); },
+                [errors]( const std::string& ) { (*errors)++; } ) );
+            instance.drm->activate();
+        } );
+    uint32_t failed = 0;
+    for( auto& instance: instances ) {
+        if ( !instance->error.empty() ) {
+            // Release the instances that could not open a session
+            instance->drm.reset();
+            failed++;
+        }
+    }
+
+    // Keep the sessions running and sample the resource usage
+    std::cout << "Running for " << options.duration << " seconds" << std::endl;
+    TClock::time_point run_start = TClock::now();
+    ResourceUsage run_start_usage = readResourceUsage();
+    ResourceUsage peak_usage = run_start_usage;
+    while( TClock::now() - run_start < std::chrono::seconds( options.duration ) ) {
+        std::this_thread::sleep_for( std::chrono::seconds( 1 ) );
+        ResourceUsage usage = readResourceUsage();
+        peak_usage.threads = std::max( peak_usage.threads, usage.threads );
+        peak_usage.rssKiB = std::max( peak_usage.rssKiB, usage.rssKiB );
+    }
+    double run_seconds = std::chrono::duration<double>( TClock::now() - run_start ).count();
+    ResourceUsage run_end_usage = readResourceUsage();
+
+    // Collect the results of the run
+    uint32_t active = 0;
+    uint64_t async_errors = 0;
+    std::string metrics;
+    for( auto& instance: instances ) {
+        async_errors += instance->asyncErrors;
+        if ( !instance->drm )
+            continue;
+        try {
+            if ( instance->drm->get<bool>( ParameterKey::license_status ) )
+                active++;
+            // The runtime statistics are shared by all the instances of the process
+            if ( metrics.empty() )
+                metrics = instance->drm->get<std::string>( ParameterKey::metrics );
+        } catch( const std::exception& e ) {
+            instance->error = e.what();
+        }
+    }
+
+    // Close the sessions
+    std::cout << "Deactivating" << std::endl;
+    std::vector<double> deactivate_durations = forEachInstance( instances, options.startThreads,
+        []( size_t, Instance& instance ) {
+            if ( instance.drm )
+                instance.drm->deactivate();
+        } );
+    for( auto& instance: instances ) {
+        if ( !instance->error.empty() ) {
+            std::cerr << "First instance error: " << instance->error << std::endl;
+            break;
+        }
+    }
+    instances.clear();
+
+    MetricHistogramSamples license_requests = parseHistogram( metrics, "drm_license_request_seconds" );
+    uint64_t license_retries = parseCounter( metrics, "drm_license_request_retries" );
+    uint64_t license_errors = parseCounter( metrics, "drm_license_request_errors" );
+    uint64_t licenses = parseCounter( metrics, "drm_licenses_loaded" );
+    uint64_t renewals = licenses > ( options.instances - failed ) ? licenses - ( options.instances - failed ) : 0;
+    double cpu_percent = 100.0 * ( run_end_usage.cpuSeconds - run_start_usage.cpuSeconds ) / run_seconds;
+
+    char report[4096];
+    snprintf( report, sizeof( report ),
+        "{\n"
+        "    \"instances\": %u,\n"
+        "    \"failed_activations\": %u,\n"
+        "    \"active_at_end\": %u,\n"
+        "    \"duration_s\": %.1f,\n"
+        "    \"activate_s\": { \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n"
+        "    \"deactivate_s\": { \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n"
+        "    \"licenses_loaded\": %llu,\n"
+        "    \"renewals_per_s\": %.2f,\n"
+        "    \"license_request_s\": { \"count\": %llu, \"mean\": %.4f, \"p50_le\": \"%s\", \"p99_le\": \"%s\", \"p999_le\": \"%s\" },\n"
+        "    \"license_request_retries\": %llu,\n"
+        "    \"license_request_errors\": %llu,\n"
+        "    \"async_errors\": %llu,\n"
+        "    \"threads\": { \"idle\": %u, \"peak\": %u },\n"
+        "    \"rss_kib\": { \"idle\": %llu, \"peak\": %llu },\n"
+        "    \"cpu_percent\": %.1f\n"
+        "}\n",
+        options.instances, failed, active, run_seconds,
+        quantile( activate_durations, 0.5 ), quantile( activate_durations, 0.9 ),
+        quantile( activate_durations, 0.99 ), quantile( activate_durations, 1 ),
+        quantile( deactivate_durations, 0.5 ), quantile( deactivate_durations, 0.9 ),
+        quantile( deactivate_durations, 0.99 ), quantile( deactivate_durations, 1 ),
+        (unsigned long long)licenses, renewals / run_seconds,
+        (unsigned long long)license_requests.count,
+        license_requests.count ? license_requests.sum / license_requests.count : 0.0,
+        license_requests.quantile( 0.5 ).c_str(), license_requests.quantile( 0.99 ).c_str(),
+        license_requests.quantile( 0.999 ).c_str(),
+        (unsigned long long)license_retries, (unsigned long long)license_errors,
+        (unsigned long long)async_errors,
+        initial_usage.threads, peak_usage.threads,
+        (unsigned long long)initial_usage.rssKiB, (unsigned long long)peak_usage.rssKiB,
+        cpu_percent );
+    std::cout << report;
+    if ( !options.jsonPath.empty() )
+        writeFile( options.jsonPath, report );
+    return failed ? 2 : 0;
+}
@@ -176,6 +176,23 @@ public:
     */
     void deactivate( const bool& pause_session_request = false );
 
+    /** \brief Read the metering counters of the activators.
+
+        This function reads the per-activator counters directly from the DRM
+        Controller metering file. Unlike the "metered_data" parameter, it
+        builds no JSON object, does not contact the Web Service and does not
+        affect the health requests. It is suited for frequent polling.
+
+        \param[out] counts : Array receiving the counter of each activator,
+        ordered by activator index.
+        \param[in] n : Number of elements in the counts array. Only the first
+        n counters are written.
+
+        \return The number of activators in the design, which can be greater
+        than n. Returns 0 when no session is running.
+    */
+    uint32_t read_metering( uint64_t* counts, size_t n ) const;
+
     /** \brief Get information from the DRM system.
 
         This function gives access to the internal parameter of the DRM system.
@@ -29,6 +29,7 @@ limitations under the License.
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 
 #define MAX_MSG_SIZE 2048
@@ -195,6 +196,28 @@ DRM_ErrorCode DrmManager_activate(DrmManager *m, bool resume_session_request ) D
 DRM_ErrorCode DrmManager_deactivate(DrmManager *m, bool pause_session_request ) DRM_EXPORT;
 
 
+/** \brief Read the metering counters of the activators.
+
+    This function reads the per-activator counters directly from the DRM
+    Controller metering file. Unlike the "metered_data" parameter, it builds no
+    JSON object, does not contact the Web Service and does not affect the
+    health requests. It is suited for frequent polling.
+
+    \param[in] m : Pointer to a DrmManager object.
+    \param[out] counts : Array receiving the counter of each activator,
+    ordered by activator index.
+    \param[in] n : Number of elements in the counts array. Only the first n
+    counters are written.
+    \param[out] p_nb_activators : Pointer receiving the number of activators in
+    the design, which can be greater than n. Set to 0 when no session is
+    running. Can be NULL.
+
+    \return An error code defined by the enumerator #DRM_ErrorCode indicating
+    the success or the cause of the error during the function execution.
+*/
+DRM_ErrorCode DrmManager_read_metering( DrmManager *m, uint64_t* counts, size_t n, unsigned int* p_nb_activators ) DRM_EXPORT;
+
+
 /** \brief Get information from the DRM system.
 
     This function gives access to the internal parameter of the DRM system.
@@ -212,6 +235,10 @@ DRM_ErrorCode DrmManager_deactivate(DrmManager *m, bool pause_session_request )
 
     \note The function will allocated the output string, \p json_out. This is
     the responsibility to the user to free it: free(json_out)
+
+    \note To poll a boolean or numerical parameter, prefer the typed
+    DrmManager_get_* functions: they read most of these parameters without
+    building any JSON object.
 */
 DRM_ErrorCode DrmManager_get_json_string( DrmManager *m, const char* json_in, char** json_out ) DRM_EXPORT;
 
@@ -0,0 +1,125 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Host-local daemon sharing a DRM Manager between processes
+*/
+
+#ifndef _H_ACCELIZE_DAEMON
+#define _H_ACCELIZE_DAEMON
+
+#include <cstdint>
+#include <string>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <sys/types.h>
+#include <json/json.h>
+
+
+namespace Accelize {
+namespace DRM {
+
+
+/** \brief Server side of the daemon protocol, listening on a Unix socket.
+
+    The protocol exchanges one JSON document per line. A request is an object with
+    a "cmd" member; the reply is either {"result": ...} or
+    {"error": {"code": <DRM_ErrorCode>, "message": "..."}}.
+
+    Each connection is served by its own thread and is identified by a unique
+    client ID, which is given to the handlers. The socket is created with the given
+    mode, and a connection is accepted only if the credentials of the peer process
+    are granted by this mode.
+*/
+class DaemonServer {
+
+public:
+    typedef std::function<Json::Value( uint64_t client_id, const Json::Value& request )> RequestHandler;
+    typedef std::function<void( uint64_t client_id )> DisconnectHandler;
+
+    DaemonServer( const std::string& socket_path, mode_t socket_mode,
+                  RequestHandler request_handler, DisconnectHandler disconnect_handler );
+    ~DaemonServer();
+
+    DaemonServer( const DaemonServer& ) = delete;
+    DaemonServer& operator=( const DaemonServer& ) = delete;
+
+    /// Stop accepting connections, close the connected clients and remove the socket
+    void stop();
+
+    const std::string& path() const { return mSocketPath; }
+
+private:
+    struct ClientThread {
+        std::thread thread;
+        std::atomic<bool> done{ false };
+    };
+
+    std::string mSocketPath;
+    mode_t mSocketMode;
+    RequestHandler mRequestHandler;
+    DisconnectHandler mDisconnectHandler;
+
+    int mServerFd = -1;
+    std::atomic<bool> mStop{ false };
+    std::thread mAcceptThread;
+
+    std::list<ClientThread> mClientThreads;     ///< Only accessed by the accept thread, then by stop()
+    uint64_t mNextClientId = 1;
+
+    void acceptLoop();
+    void reapClients();
+    bool isPeerAllowed( int fd ) const;
+    void serveClient( int fd, uint64_t client_id, std::atomic<bool>* done );
+
+};
+
+
+/** \brief Client side of the daemon protocol.
+
+    Calls are serialized: a single request is in flight at any time on the connection.
+    If the reply is not received before the timeout, the connection is closed.
+*/
+class DaemonClient {
+
+public:
+    DaemonClient( const std::string& socket_path, uint32_t timeout_ms );
+    ~DaemonClient();
+
+    DaemonClient( const DaemonClient& ) = delete;
+    DaemonClient& operator=( const DaemonClient& ) = delete;
+
+    /// Send a request and return the result, or throw the error returned by the daemon
+    Json::Value call( const Json::Value& request );
+
+    const std::string& path() const { return mSocketPath; }
+
+private:
+    std::string mSocketPath;
+    uint32_t mTimeoutMS;
+    int mFd = -1;
+    std::mutex mMutex;
+    std::string mBuffer;
+
+};
+
+
+}
+}
+
+#endif // _H_ACCELIZE_DAEMON
@@ -25,6 +25,7 @@ limitations under the License.
 #include <string.h>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 // SPDLOG_ACTIVE_LEVEL must be declared before the spdlog.h include
 #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
@@ -34,6 +35,7 @@ limitations under the License.
 #include "spdlog/sinks/null_sink.h"
 #include "spdlog/sinks/basic_file_sink.h"       // support for basic file logging
 #include "spdlog/sinks/rotating_file_sink.h"    // support for rotating file logging
+#include "spdlog/async.h"                       // support for asynchronous logging
 
 #include "accelize/drm/error.h"
 
@@ -50,6 +52,21 @@ namespace DRM {
 
     extern std::shared_ptr<spdlog::logger> sLogger;
 
+    // Thread pool of the asynchronous logger; null when logging is synchronous
+    extern std::shared_ptr<spdlog::details::thread_pool> sLogThreadPool;
+
+    // Flush the logger. With asynchronous logging, wait until the queued messages are written
+    void flushLog();
+
+    // Level of sLogger cached in an atomic: must be updated with setLogLevel
+    extern std::atomic<int> sLogLevel;
+
+    // Set the level of sLogger and of its cached value
+    void setLogLevel( spdlog::level::level_enum level );
+
+    // Cheap check of the logger level before evaluating the arguments of a message
+    #define LogEnabled( level ) ( sLogLevel.load( std::memory_order_relaxed ) <= (int)(level) )
+
     #define Debug2(...) SPDLOG_TRACE( __VA_ARGS__ )
 
     #define Debug(...) SPDLOG_DEBUG( __VA_ARGS__ )
@@ -62,6 +79,13 @@ namespace DRM {
 
     #define Fatal(...) SPDLOG_CRITICAL( __VA_ARGS__ )
 
+    // Register access messages: compiled only with the REGISTER_TRACE build option
+    #ifdef DRM_REGISTER_TRACE
+    #define RegTrace(...) do { if ( LogEnabled( spdlog::level::trace ) ) Debug2( __VA_ARGS__ ); } while( 0 )
+    #else
+    #define RegTrace(...) do {} while( 0 )
+    #endif
+
 }
 }
 
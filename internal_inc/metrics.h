@@ -0,0 +1,261 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Runtime statistics of the DRM library in OpenMetrics format
+*/
+
+#ifndef _H_ACCELIZE_METRICS
+#define _H_ACCELIZE_METRICS
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <exception>
+
+
+namespace Accelize {
+namespace DRM {
+
+
+/** \brief Monotonic counter
+*/
+class MetricCounter {
+
+private:
+    std::atomic<uint64_t> mValue{ 0 };
+
+public:
+    void inc( uint64_t n = 1 ) { mValue.fetch_add( n, std::memory_order_relaxed ); }
+    uint64_t value() const { return mValue.load( std::memory_order_relaxed ); }
+};
+
+
+/** \brief Histogram of durations with fixed bucket bounds in seconds
+*/
+class MetricHistogram {
+
+private:
+    std::vector<double> mBounds;                            // Upper bound in seconds of each bucket
+    std::unique_ptr<std::atomic<uint64_t>[]> mBuckets;      // Non-cumulative count of each bucket, last one is +Inf
+    std::atomic<uint64_t> mSumNs{ 0 };
+
+public:
+    explicit MetricHistogram( const std::vector<double>& bounds );
+
+    void observe( const std::chrono::steady_clock::duration& duration );
+
+    /// Append the samples of the histogram to the OpenMetrics text
+    void format( std::string& text, const std::string& name, const std::string& labels = std::string() ) const;
+};
+
+
+/** \brief Latency histogram with logarithmic buckets and per-thread shards
+
+    Buckets follow the HDR layout: each power of two of nanoseconds is split in
+    4 linear sub-buckets, giving a relative precision of 25% from 256 ns to 8.6 s.
+    Each thread increments the counters of its own shard, so that threads
+    recording concurrently do not contend on the same counters.
+*/
+class LatencyHistogram {
+
+public:
+    static const uint32_t SUB_BUCKET_BITS = 2;
+    static const uint32_t MIN_EXPONENT = 8;     // Values below 2^8 ns go in the first bucket
+    static const uint32_t MAX_EXPONENT = 33;    // Values above 2^33 ns go in the last bucket
+    static const uint32_t NB_BUCKETS = ( ( MAX_EXPONENT - MIN_EXPONENT ) << SUB_BUCKET_BITS ) + 2;
+    static const uint32_t NB_SHARDS = 8;
+
+    /// Counts of all the shards merged
+    struct Snapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sumNs = 0;
+        uint64_t maxNs = 0;
+
+        /// Return the upper bound in nanoseconds of the bucket containing the given quantile
+        uint64_t quantileNs( double quantile ) const;
+    };
+
+    LatencyHistogram();
+
+    void record( uint64_t ns );
+
+    Snapshot snapshot() const;
+
+    /// Return the index of the bucket of a value in nanoseconds
+    static uint32_t bucketIndex( uint64_t ns );
+
+    /// Return the upper bound in nanoseconds of a bucket
+    static uint64_t bucketUpperBound( uint32_t index );
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> buckets[NB_BUCKETS];
+        std::atomic<uint64_t> sumNs;
+        std::atomic<uint64_t> maxNs;
+    };
+    std::unique_ptr<Shard[]> mShards;
+};
+
+
+/** \brief Process-wide registry of the DRM library statistics
+
+    The statistics are aggregated across all the DrmManager instances of the
+    process. Recording is lock-free and only active while at least one instance
+    has enabled the metrics in its configuration file.
+    The registry is never destroyed so that it remains usable until the last
+    DrmManager is destroyed, whatever the destruction order of static objects.
+*/
+class Metrics {
+
+public:
+    typedef std::chrono::steady_clock TClock;
+
+    // License Web Service
+    MetricHistogram licenseRequestDuration;     // Duration of getLicense, retries included
+    MetricCounter licenseRequestRetries;        // Number of license and OAuth2 retries in getLicense
+    MetricCounter licenseRequestErrors;         // Number of getLicense failures
+    MetricHistogram healthRequestDuration;      // Duration of postHealth, retries included
+    MetricCounter healthRequestRetries;         // Number of health and OAuth2 retries in postHealth
+    MetricCounter healthRequestErrors;          // Number of postHealth failures
+    MetricCounter oauth2Refreshes;              // Number of OAuth2 tokens requested to the Web Service
+    MetricHistogram wsRequestDuration;          // Duration of each HTTP request
+    MetricCounter wsRequestErrors;              // Number of HTTP requests which failed or returned an error code
+
+    // DRM Controller
+    MetricHistogram setLicenseDuration;         // Duration of setLicense
+    MetricHistogram statusWaitDuration;         // Time spent waiting for the DRM Controller status registers
+    MetricCounter licensesLoaded;               // Number of licenses provisioned in the DRM Controllers
+    MetricCounter registerReads;                // Number of DRM Controller register reads
+    MetricCounter registerWrites;               // Number of DRM Controller register writes
+    MetricCounter registerErrors;               // Number of register accesses returning an error
+
+    /// Return the registry of the process
+    static Metrics& instance();
+
+    /// Return true if the recording is active
+    static bool enabled() { return sEnabled.load( std::memory_order_relaxed ) != 0; }
+
+    /// Enable the recording on behalf of an instance, and start the endpoint if not empty
+    void acquire( const void* owner, std::function<int64_t()> time_left, const std::string& endpoint );
+
+    /// Release the recording and the endpoint acquired by an instance
+    void release( const void* owner );
+
+    /// Return the latency histogram of a DRM Controller operation given as a call expression
+    LatencyHistogram& controllerOperation( const std::string& call );
+
+    /// Return the latency histograms of the DRM Controller operations which were called
+    std::map<std::string, LatencyHistogram::Snapshot> controllerOperations() const;
+
+    /// Return all the statistics in OpenMetrics text format
+    std::string format() const;
+
+private:
+    static std::atomic<uint32_t> sEnabled;
+
+    // Time left on the license of each instance, indexed by a stable number
+    struct Instance {
+        uint32_t index;
+        std::function<int64_t()> timeLeft;
+        bool endpoint;                  // True if the instance uses the endpoint
+    };
+    mutable std::mutex mMutex;
+    std::map<const void*, Instance> mInstances;
+    uint32_t mNextIndex = 0;
+
+    // Latency of each DRM Controller operation, indexed by operation name
+    mutable std::mutex mOperationsMutex;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> mOperations;
+
+    // Endpoint serving the statistics; mServerMutex is never taken by the server thread
+    std::mutex mServerMutex;
+    std::string mEndpoint;
+    uint32_t mEndpointUsers = 0;
+    int mServerFd = -1;
+    std::atomic<bool> mServerStop{ false };
+    std::thread mServerThread;
+
+    Metrics();
+    Metrics( const Metrics& ) = delete;
+    Metrics& operator=( const Metrics& ) = delete;
+
+    void startServer( const std::string& endpoint );
+    void stopServer();
+    void serve();
+};
+
+
+/** \brief Record the duration of a scope in a histogram when the metrics are enabled
+*/
+class MetricTimer {
+
+private:
+    MetricHistogram* mHistogram;
+    Metrics::TClock::time_point mStart;
+
+public:
+    explicit MetricTimer( MetricHistogram& histogram )
+        : mHistogram( Metrics::enabled() ? &histogram : nullptr ),
+          mStart( mHistogram ? Metrics::TClock::now() : Metrics::TClock::time_point() ) {}
+    ~MetricTimer() {
+        if ( mHistogram )
+            mHistogram->observe( Metrics::TClock::now() - mStart );
+    }
+
+    MetricTimer( const MetricTimer& ) = delete;
+    MetricTimer& operator=( const MetricTimer& ) = delete;
+};
+
+
+/** \brief Record the duration of a scope in a latency histogram when the metrics are enabled
+*/
+class LatencyTimer {
+
+private:
+    LatencyHistogram* mHistogram;
+    Metrics::TClock::time_point mStart;
+
+public:
+    explicit LatencyTimer( LatencyHistogram& histogram )
+        : mHistogram( Metrics::enabled() ? &histogram : nullptr ),
+          mStart( mHistogram ? Metrics::TClock::now() : Metrics::TClock::time_point() ) {}
+    ~LatencyTimer() {
+        if ( mHistogram )
+            mHistogram->record( (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Metrics::TClock::now() - mStart ).count() );
+    }
+
+    LatencyTimer( const LatencyTimer& ) = delete;
+    LatencyTimer& operator=( const LatencyTimer& ) = delete;
+};
+
+
+/// Increment a counter of the registry when the metrics are enabled
+#define MetricInc( counter ) do { if ( Metrics::enabled() ) Metrics::instance().counter.inc(); } while( 0 )
+
+
+}
+}
+
+#endif // _H_ACCELIZE_METRICS
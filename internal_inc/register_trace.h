@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief In-memory binary trace of the DRM Controller register accesses
+*/
+
+#ifndef _H_ACCELIZE_REGISTER_TRACE
+#define _H_ACCELIZE_REGISTER_TRACE
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
+
+namespace Accelize {
+namespace DRM {
+
+
+/** \brief Entry of the register trace, as written in the dump file (32 bytes).
+*/
+struct RegisterTraceEntry {
+    uint64_t timestamp;     ///< Start of the access in nanoseconds (steady clock)
+    uint32_t thread;        ///< System ID of the calling thread
+    uint32_t offset;        ///< Register offset relative to the DRM Controller base address
+    uint32_t value;         ///< Value read or written
+    uint32_t latency;       ///< Duration of the register callback in nanoseconds
+    uint8_t  access;        ///< RegisterTrace::READ or RegisterTrace::WRITE
+    uint8_t  page;          ///< Page selected in the DRM Controller, 0xFF if unknown
+    uint16_t errcode;       ///< Value returned by the register callback
+    uint32_t reserved;
+};
+
+
+/** \brief Fixed-size ring of register accesses.
+
+    Recording is lock-free: each access reserves a slot with an atomic increment and
+    overwrites the oldest entry when the ring is full. Each slot is published with a
+    sequence number (seqlock): the dump skips the entries which are being written or
+    were overwritten while it reads them, so it never writes a partial entry.
+
+    Dump file format (native endianness):
+    - header: magic "DRMTRACE", format version (uint32), entry size (uint32),
+      DRM Controller version (uint32), reserved (uint32), number of entries (uint64),
+      number of entries lost, overwritten or skipped by the dump (uint64);
+    - entries in chronological order, see RegisterTraceEntry.
+*/
+class RegisterTrace {
+
+public:
+    typedef std::chrono::steady_clock TClock;
+
+    static const uint8_t READ = 0;
+    static const uint8_t WRITE = 1;
+    static const uint32_t FORMAT_VERSION = 1;
+
+    /// The capacity is rounded up to the next power of 2
+    explicit RegisterTrace( size_t capacity );
+
+    RegisterTrace( const RegisterTrace& ) = delete;
+    RegisterTrace& operator=( const RegisterTrace& ) = delete;
+
+    void record( uint8_t access, uint32_t page, uint32_t offset, uint32_t value,
+                 const TClock::time_point& start, int32_t errcode );
+
+    /// Write the trace to a file and return the number of entries written
+    size_t dump( const std::string& file_path, uint32_t ctrl_version ) const;
+
+    size_t capacity() const { return mEntries.size(); }
+
+private:
+    std::vector<RegisterTraceEntry> mEntries;
+    std::unique_ptr<std::atomic<uint64_t>[]> mSequences;    ///< Per slot: odd while written, 2 * (index + 1) once written
+    size_t mMask;
+    std::atomic<uint64_t> mIndex;
+};
+
+
+}
+}
+
+#endif // _H_ACCELIZE_REGISTER_TRACE
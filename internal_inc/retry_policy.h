@@ -0,0 +1,83 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Retry policy of the requests to the License Web Service
+*/
+
+#ifndef _H_ACCELIZE_RETRY_POLICY
+#define _H_ACCELIZE_RETRY_POLICY
+
+#include <cstdint>
+#include <chrono>
+#include <json/json.h>
+
+
+namespace Accelize {
+namespace DRM {
+
+
+/// Return a random number uniformly distributed in [min_value, max_value]
+double uniformRandom( double min_value, double max_value );
+
+
+/** \brief Parameters of the exponential backoff of a request type
+*/
+struct RetryPolicy {
+    bool enabled = false;           ///< If false, the fixed retry periods are used
+    double basePeriod = 1.0;        ///< Upper bound in seconds of the first wait
+    double maxPeriod = 60.0;        ///< Upper bound in seconds of any wait
+    double multiplier = 2.0;        ///< Growth of the upper bound after each attempt
+    double deadlineRatio = 0.25;    ///< A wait never exceeds this fraction of the time left before the deadline
+
+    /// Parse the policy from the configuration, throw DRM_BadArg on invalid values
+    static RetryPolicy fromJson( const Json::Value& json_value, const std::string& name );
+
+    Json::Value toJson() const;
+};
+
+
+/** \brief Exponential backoff with full jitter bounded by a deadline.
+
+    The wait before attempt n is drawn uniformly in [0, min(max_period, base_period * multiplier^n)],
+    so that the clients failing at the same time do not retry at the same time. The upper bound is
+    also limited to a fraction of the time left before the deadline: the attempts get denser as the
+    deadline nears. A "Retry-After" delay returned by the server is respected unless it ends after
+    the deadline.
+*/
+class RetryBackoff {
+
+public:
+    typedef std::chrono::steady_clock TClock;
+
+    explicit RetryBackoff( const RetryPolicy& policy ): mPolicy( policy ) {}
+
+    /// Return the duration to wait before the next attempt
+    TClock::duration next( const TClock::time_point& deadline, int32_t retry_after_ms = -1 );
+
+    uint32_t attempts() const { return mAttempt; }
+    void reset() { mAttempt = 0; }
+
+private:
+    RetryPolicy mPolicy;
+    uint32_t mAttempt = 0;
+
+};
+
+
+}
+}
+
+#endif // _H_ACCELIZE_RETRY_POLICY
@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Durable spool of the session close requests
+*/
+
+#ifndef _H_ACCELIZE_SESSION_SPOOL
+#define _H_ACCELIZE_SESSION_SPOOL
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <json/json.h>
+
+#include "ws_client.h"
+
+
+namespace Accelize {
+namespace DRM {
+
+
+/** \brief Directory of the close requests waiting to be posted to the License Web Service.
+
+    Each request is written to its own file "<timestamp>_<session ID>.json": the file is
+    written under a temporary name, synced, then renamed, so a crash never leaves a
+    partial request in the spool.
+
+    Several processes can share the same spool directory: a file is locked while its
+    request is posted, so each request is posted by a single process.
+*/
+class SessionSpool {
+
+public:
+    explicit SessionSpool( const std::string& dir_path );
+
+    SessionSpool( const SessionSpool& ) = delete;
+    SessionSpool& operator=( const SessionSpool& ) = delete;
+
+    /// Write a close request to the spool and return the path of the file
+    std::string push( const std::string& session_id, const Json::Value& request_json ) const;
+
+    /// Return the paths of the pending requests, oldest first
+    std::vector<std::string> list() const;
+
+    /// Outcome of a flush of the spool
+    struct FlushResult {
+        uint32_t posted = 0;            ///< Number of requests accepted by the Web Service
+        std::vector<std::string> dropped;   ///< Session IDs of the requests rejected by the Web Service
+        bool retry = false;             ///< True if the flush stopped on an error which may be retried
+        int32_t retryAfterMS = -1;      ///< Delay requested by the Web Service with this error, -1 if none
+    };
+
+    /** \brief Post the pending requests.
+
+        A request is removed from the spool when the Web Service accepted it, or rejected
+        it with a non-retryable error. The flush stops at the first retryable error, or
+        when the abort flag is set.
+    */
+    FlushResult flush( DrmWSClient& ws_client, const std::atomic<bool>& abort_flag ) const;
+
+    const std::string& path() const { return mDirPath; }
+
+private:
+    std::string mDirPath;
+
+};
+
+
+}
+}
+
+#endif // _H_ACCELIZE_SESSION_SPOOL
@@ -0,0 +1,92 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Reader/writer lock protecting the DRM Controller accesses
+*/
+
+#ifndef _H_ACCELIZE_SHARED_MUTEX
+#define _H_ACCELIZE_SHARED_MUTEX
+
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+
+namespace Accelize {
+namespace DRM {
+
+
+/** \brief Recursive mutex supporting shared and exclusive ownership.
+
+    - The exclusive ownership is recursive: the owning thread can lock it again,
+      either exclusively or shared.
+    - Any number of threads can share the ownership as long as no thread owns it
+      exclusively. Shared ownership can be nested.
+    - A thread sharing the ownership must not request the exclusive ownership:
+      there is no upgrade from shared to exclusive.
+    - Exclusive requests wait for the completion of the ongoing shared sections.
+      While an exclusive request is queued, the new shared sections wait for it,
+      so continuous readers cannot starve a writer. A thread already sharing the
+      ownership (of any RecursiveSharedMutex) does not wait for the queued writers,
+      so a nested shared section cannot deadlock.
+
+    The lock() and unlock() functions allow the use of std::lock_guard for the
+    exclusive ownership; SharedLockGuard is the RAII wrapper of the shared one.
+*/
+class RecursiveSharedMutex {
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondVar;
+    std::thread::id mOwner;         // Thread owning the exclusive lock
+    uint32_t mOwnerDepth = 0;       // Recursion depth of the exclusive owner
+    uint32_t mSharedCount = 0;      // Number of shared owners
+    uint32_t mWaitingWriters = 0;   // Number of threads waiting for the exclusive ownership
+
+public:
+    RecursiveSharedMutex() = default;
+    RecursiveSharedMutex( const RecursiveSharedMutex& ) = delete;
+    RecursiveSharedMutex& operator=( const RecursiveSharedMutex& ) = delete;
+
+    void lock();
+    void unlock();
+
+    void lock_shared();
+    void unlock_shared();
+};
+
+
+/** \brief RAII shared ownership of a RecursiveSharedMutex
+*/
+class SharedLockGuard {
+
+private:
+    RecursiveSharedMutex& mMutex;
+
+public:
+    explicit SharedLockGuard( RecursiveSharedMutex& mutex ) : mMutex( mutex ) { mMutex.lock_shared(); }
+    ~SharedLockGuard() { mMutex.unlock_shared(); }
+
+    SharedLockGuard( const SharedLockGuard& ) = delete;
+    SharedLockGuard& operator=( const SharedLockGuard& ) = delete;
+};
+
+
+}
+}
+
+#endif // _H_ACCELIZE_SHARED_MUTEX
@@ -36,6 +36,7 @@ std::string getDirName( const std::string& full_path );
 bool isDir( const std::string& dir_path );
 bool isFile( const std::string& file_path );
 bool makeDirs( const std::string& dir_path, mode_t mode = 744 );
+void removeStaleSocket( const std::string& socket_path );
 
 // JSON related functions
 std::string saveJsonToString( const Json::Value& json_value, const std::string& indent = "" );
@@ -50,6 +51,9 @@ std::string time_t_to_string( const time_t &t );
 time_t steady_clock_to_time_t( const std::chrono::steady_clock::time_point& tp );
 std::chrono::steady_clock::time_point time_t_to_steady_clock( const time_t& t );
 
+// DRM Controller related functions
+uint32_t getDrmRegisterOffset( const std::string& regName );
+
 // Miscellaneous functions
 std::string execCmd( const std::string& cmd );
 std::string toUpHex( const uint64_t& i );
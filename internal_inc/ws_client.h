@@ -20,6 +20,7 @@ limitations under the License.
 #include <string>
 #include <list>
 #include <chrono>
+#include <atomic>
 #include <json/json.h>
 #include <curl/curl.h>
 
@@ -57,6 +58,8 @@ private:
     struct curl_slist *mHeaders_p = NULL;
     struct curl_slist *mHostResolveList = NULL;
     std::array<char, CURL_ERROR_SIZE> mErrBuff;
+    const std::atomic<bool>* mAbortFlag = NULL;
+    int32_t mRetryAfterMS = -1;     // Delay of the "Retry-After" header of the last response, -1 if none
 
 public:
     static bool is_error_retryable( long resp_code ) {
@@ -95,12 +98,14 @@ public:
     ~CurlEasyPost();
 
     double getTotalTime();  // Get total time in seconds of the previous transfer
+    int32_t getRetryAfterMS() const { return mRetryAfterMS; }  // Delay requested by the server, -1 if none
 
     void setVerbosity( const uint32_t verbosity );
     void setHostResolves( const Json::Value& host_json );
 
     void appendHeader( const std::string header );
     void setPostFields( const std::string& postfields );
+    void setAbortFlag( const std::atomic<bool>* abort_flag );  // Abort the transfer when the flag is set
 
     uint32_t perform( const std::string url, std::string* resp, const int32_t timeout_ms );
 
@@ -204,6 +209,19 @@ protected:
         return realsize;
     }
 
+    static size_t curl_header_callback( char *buffer, size_t size, size_t nitems, CurlEasyPost *self ) {
+        size_t realsize = size * nitems;
+        self->parseRetryAfter( std::string( buffer, realsize ) );
+        return realsize;
+    }
+
+    void parseRetryAfter( const std::string& header );
+
+    static int curl_xferinfo_callback( void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t ) {
+        // Returning a non-zero value aborts the transfer with CURLE_ABORTED_BY_CALLBACK
+        return ((const std::atomic<bool>*)clientp)->load() ? 1 : 0;
+    }
+
 };
 
 
@@ -232,12 +250,15 @@ protected:
     TClock::time_point mTokenExpirationTime;    /// OAuth2 expiration time
     int32_t mRequestTimeoutMS;                  /// Maximum period in milliseconds for a request to complete
     int32_t mConnectionTimeoutMS;               /// Maximum period in milliseconds for the client to connect the server
+    const std::atomic<bool>* mAbortFlag;        /// When set, the pending request is aborted
 
     bool isTokenValid() const;
-    Json::Value requestMetering( const std::string url, const Json::Value& json_req, int32_t timeout_msec );
+    Json::Value requestMetering( const std::string url, const Json::Value& json_req, int32_t timeout_msec,
+                                 int32_t* retry_after_ms );
 
 public:
-    DrmWSClient(const std::string &conf_file_path, const std::string &cred_file_path);
+    DrmWSClient(const std::string &conf_file_path, const std::string &cred_file_path,
+                const std::atomic<bool>* abort_flag = nullptr);
     ~DrmWSClient() = default;
 
     uint32_t getVerbosity() const { return mVerbosity; }
@@ -248,10 +269,12 @@ public:
     int32_t getRequestTimeoutMS() const { return mRequestTimeoutMS; }
     int32_t getConnectionTimeoutMS() const { return mConnectionTimeoutMS; }
 
-    void requestOAuth2token( int32_t timeout_msec );
+    // If retry_after_ms is given, it receives the delay requested by the server with a
+    // retryable error of this request, -1 if none
+    void requestOAuth2token( int32_t timeout_msec, int32_t* retry_after_ms = nullptr );
 
-    Json::Value requestLicense( const Json::Value& json_req, int32_t timeout_msec );
-    Json::Value requestHealth( const Json::Value& json_req, int32_t timeout_msec );
+    Json::Value requestLicense( const Json::Value& json_req, int32_t timeout_msec, int32_t* retry_after_ms = nullptr );
+    Json::Value requestHealth( const Json::Value& json_req, int32_t timeout_msec, int32_t* retry_after_ms = nullptr );
 
 };
 
@@ -4,4 +4,5 @@ Allow Accelize DRM library ".pxd" headers import from Cython
 Examples:
     cimport accelize_drm.libaccelize_drm
     cimport accelize_drm.libaccelize_drmc
+    cimport accelize_drm.native_registers
 """
\ No newline at end of file
@@ -21,13 +21,14 @@ import datetime
 __version__ = "@ACCELIZEDRM_LONG_VERSION@"
 __copyright__ = "Copyright %s Accelize" % datetime.date.today().year
 __licence__ = "Apache 2.0"
-__all__ = ['DrmManager', 'exceptions', 'get_api_version']
+__all__ = ['DrmManager', 'exceptions', 'registers', 'get_api_version']
 
 from os import environ as _environ
 from collections import namedtuple as _namedtuple
 
 
 import accelize_drm.exceptions  # noqa
+import accelize_drm.registers  # noqa
 
 if _environ.get('ACCELIZE_DRM_PYTHON_USE_C'):
     # Bind Python Accelize DRM on libaccelize_drmc (C variant)
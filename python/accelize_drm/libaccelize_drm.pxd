@@ -2,10 +2,12 @@
 # distutils: language = c++
 """libaccelize_drm Cython header"""
 
-from libc.stdint cimport uint32_t
+from libc.stdint cimport uint32_t, uint64_t
 from libcpp cimport bool
 from libcpp.string cimport string
 
+from accelize_drm.native_registers cimport NativeRegisters
+
 ctypedef int (*ReadRegisterCallback)(uint32_t, uint32_t*)
 ctypedef int (*WriteRegisterCallback)(uint32_t, uint32_t)
 ctypedef void (*AsynchErrorCallback)(const string &)
@@ -14,7 +16,10 @@ ctypedef void (*AsynchErrorCallback)(const string &)
 cdef extern from "accelize/drm.h" namespace "Accelize::DRM" nogil:
 
     enum ParameterKey:
-        pass
+        license_status
+        session_status
+        session_id
+        num_license_loaded
 
     const char* getApiVersion() except +
 
@@ -29,8 +34,22 @@ cdef extern from "accelize/drm.h" namespace "Accelize::DRM" nogil:
 
         void deactivate(bool pause_session_request) except +
 
+        uint32_t read_metering(uint64_t* counts, size_t n) except +
+
         void get(string& json_string) except +
         T get[T](const ParameterKey key_id) except +
+        bool get_bool "get<bool>"(const ParameterKey key_id) except +
+        uint32_t get_uint32 "get<uint32_t>"(const ParameterKey key_id) except +
+        string get_string "get<std::string>"(
+            const ParameterKey key_id) except +
 
         void set(string& json_string) except +
         void set[T](const ParameterKey key_id, const T& value) except +
+
+
+cdef extern from "native_registers.h" nogil:
+
+    DrmManager* NativeRegisters_newDrmManager(
+        string& conf_file_path, string& cred_file_path,
+        const NativeRegisters* registers,
+        AsynchErrorCallback f_asynch_error) except +
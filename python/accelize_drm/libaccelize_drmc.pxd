@@ -1,13 +1,17 @@
 # cython: language_level=3
 """libaccelize_drmc Cython header"""
 
-from libc.stdint cimport uint32_t
+from libc.stdint cimport uint32_t, uint64_t
 
 ctypedef int(*ReadRegisterCallback)(uint32_t, uint32_t*, void*user_p)
 ctypedef int(*WriteRegisterCallback)(uint32_t, uint32_t, void*user_p)
 ctypedef void(*AsynchErrorCallback)(const char*, void*user_p)
 
 
+cdef extern from "stdbool.h" nogil:
+    ctypedef bint bool
+
+
 cdef extern from "accelize/drmc.h" nogil:
 
     ctypedef struct DrmManager:
@@ -15,7 +19,10 @@ cdef extern from "accelize/drmc.h" nogil:
         pass
 
     ctypedef enum DrmParameterKey:
-        pass
+        DRM__license_status
+        DRM__session_status
+        DRM__session_id
+        DRM__num_license_loaded
 
 
     const char * DrmManager_getApiVersion()
@@ -32,8 +39,11 @@ cdef extern from "accelize/drmc.h" nogil:
 
     int DrmManager_deactivate(DrmManager *m, bint pause_session_request)
 
+    int DrmManager_read_metering(DrmManager *m, uint64_t* counts, size_t n,
+                                 unsigned int* p_nb_activators)
+
     int DrmManager_get_json_string(DrmManager *m, const char* json_in, char** json_out)
-    int DrmManager_get_bool(DrmManager *m, const DrmParameterKey key, bint* p_value)
+    int DrmManager_get_bool(DrmManager *m, const DrmParameterKey key, bool* p_value)
     int DrmManager_get_int(DrmManager *m, const DrmParameterKey key, int* p_value)
     int DrmManager_get_uint(DrmManager *m, const DrmParameterKey key, unsigned int* p_value)
     int DrmManager_get_int64(DrmManager *m, const DrmParameterKey key, long long* p_value)
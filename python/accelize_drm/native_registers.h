@@ -0,0 +1,105 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \file native_registers.h
+
+    \brief Native register access for the Python binding
+
+    The register callbacks of the Python DrmManager are Python functions: each
+    register access of the DRM Library takes the Python GIL. With a native
+    register backend, the accesses are served by C code only: either a C
+    function of a FPGA driver library, or a memory mapped PCIe BAR.
+*/
+
+#ifndef _H_ACCELIZE_DRM_PYTHON_NATIVE_REGISTERS
+#define _H_ACCELIZE_DRM_PYTHON_NATIVE_REGISTERS
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <string>
+#include "accelize/drm.h"
+#endif
+
+/** \brief Native read register function, same signature as the C API callback
+*/
+typedef int (*NativeReadRegister)( uint32_t offset, uint32_t* value, void* user_p );
+
+/** \brief Native write register function, same signature as the C API callback
+*/
+typedef int (*NativeWriteRegister)( uint32_t offset, uint32_t value, void* user_p );
+
+/** \brief Native register backend
+
+    If read_register is NULL, the registers are read and written in the memory
+    mapping of mapping_size bytes starting at "mapping".
+*/
+typedef struct {
+    NativeReadRegister read_register;   ///< Read function, NULL to use the memory mapping
+    NativeWriteRegister write_register; ///< Write function, NULL to use the memory mapping
+    void* user_p;                       ///< User pointer passed to the functions
+    uint64_t base_address;              ///< DRM Controller base address
+    volatile uint32_t* mapping;         ///< Memory mapping of the register bus
+    size_t mapping_size;                ///< Size of the memory mapping in bytes
+} NativeRegisters;
+
+/** \brief Read a register of the DRM Controller, "user_p" is the NativeRegisters
+*/
+static inline int NativeRegisters_read( uint32_t offset, uint32_t* value, void* user_p ) {
+    const NativeRegisters* registers = (const NativeRegisters*)user_p;
+    uint64_t address = registers->base_address + offset;
+    if ( registers->read_register )
+        return registers->read_register( (uint32_t)address, value, registers->user_p );
+    if ( ( address & 3 ) || ( address + 4 > registers->mapping_size ) )
+        return -1;
+    *value = registers->mapping[address / 4];
+    return 0;
+}
+
+/** \brief Write a register of the DRM Controller, "user_p" is the NativeRegisters
+*/
+static inline int NativeRegisters_write( uint32_t offset, uint32_t value, void* user_p ) {
+    const NativeRegisters* registers = (const NativeRegisters*)user_p;
+    uint64_t address = registers->base_address + offset;
+    if ( registers->write_register )
+        return registers->write_register( (uint32_t)address, value, registers->user_p );
+    if ( ( address & 3 ) || ( address + 4 > registers->mapping_size ) )
+        return -1;
+    registers->mapping[address / 4] = value;
+    return 0;
+}
+
+#ifdef __cplusplus
+
+/** \brief Instantiate a C++ DrmManager accessing the registers through a NativeRegisters
+
+    The NativeRegisters must outlive the DrmManager.
+*/
+inline Accelize::DRM::DrmManager* NativeRegisters_newDrmManager(
+        const std::string& conf_file_path, const std::string& cred_file_path,
+        const NativeRegisters* registers, void (*f_asynch_error)( const std::string& ) ) {
+    void* user_p = const_cast<NativeRegisters*>( registers );
+    return new Accelize::DRM::DrmManager(
+        conf_file_path, cred_file_path,
+        [user_p]( uint32_t offset, uint32_t* value ) { return NativeRegisters_read( offset, value, user_p ); },
+        [user_p]( uint32_t offset, uint32_t value ) { return NativeRegisters_write( offset, value, user_p ); },
+        f_asynch_error );
+}
+
+#endif
+
+#endif // _H_ACCELIZE_DRM_PYTHON_NATIVE_REGISTERS
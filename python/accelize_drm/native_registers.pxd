@@ -0,0 +1,22 @@
+# cython: language_level=3
+"""Native register access Cython header"""
+
+from libc.stdint cimport uint32_t, uint64_t
+
+ctypedef int (*NativeReadRegister)(uint32_t, uint32_t*, void*user_p)
+ctypedef int (*NativeWriteRegister)(uint32_t, uint32_t, void*user_p)
+
+
+cdef extern from "native_registers.h" nogil:
+
+    ctypedef struct NativeRegisters:
+        NativeReadRegister read_register
+        NativeWriteRegister write_register
+        void* user_p
+        uint64_t base_address
+        uint32_t* mapping
+        size_t mapping_size
+
+    int NativeRegisters_read(uint32_t offset, uint32_t* value, void* user_p)
+
+    int NativeRegisters_write(uint32_t offset, uint32_t value, void* user_p)
@@ -0,0 +1,133 @@
+# coding=utf-8
+"""
+Native register backends
+
+The read and write register callbacks of "accelize_drm.DrmManager" are Python
+functions: each register access of the DRM Library waits for the Python GIL.
+A native register backend replaces both callbacks and serves the register
+accesses from C code only, so the DRM Library never calls back into Python.
+"""
+from ctypes import (
+    c_char as _c_char, c_void_p as _c_void_p, cast as _cast,
+    addressof as _addressof)
+from mmap import mmap as _mmap, PAGESIZE as _PAGESIZE
+import os as _os
+
+__all__ = ['NativeRegisters', 'MappedRegisters']
+
+
+def _function_address(function, name):
+    """
+    Return the address of a C function.
+
+    Args:
+        function (ctypes function pointer or int): C function.
+        name (str): Argument name for the error message.
+
+    Returns:
+        int: Function address.
+    """
+    if isinstance(function, int):
+        address = function
+    else:
+        try:
+            address = _cast(function, _c_void_p).value
+        except Exception:
+            address = None
+    if not address:
+        raise TypeError(
+            '"%s" must be a C function from a ctypes library or its address'
+            % name)
+    return address
+
+
+class NativeRegisters:
+    """
+    Register accesses through the C functions of a FPGA driver library.
+
+    The functions have the signature of the C API register callbacks
+    (See "accelize/drmc.h"):
+
+    - int read_register(uint32_t offset, uint32_t* value, void* user_p)
+    - int write_register(uint32_t offset, uint32_t value, void* user_p)
+
+    "offset" is the DRM Controller register offset added to "base_address".
+    The functions must be thread-safe in case of concurrency on the register
+    bus.
+
+    Pass the instance as "read_register" argument of
+    "accelize_drm.DrmManager" and None as "write_register".
+
+    Args:
+        read_register (ctypes function pointer or int): Read register function.
+        write_register (ctypes function pointer or int): Write register
+            function.
+        user_p (ctypes.c_void_p or int): User pointer passed to the functions.
+        base_address (int): DRM Controller base address.
+    """
+    _mapping_address = 0
+    _mapping_size = 0
+
+    def __init__(self, read_register, write_register, user_p=None,
+                 base_address=0):
+        self._read_function = _function_address(read_register, 'read_register')
+        self._write_function = _function_address(
+            write_register, 'write_register')
+        self._user_p = getattr(user_p, 'value', user_p) or 0
+        self._base_address = base_address
+
+        # Keep references to the library objects
+        self._references = (read_register, write_register, user_p)
+
+
+class MappedRegisters(NativeRegisters):
+    """
+    Register accesses in a memory mapping of the register bus.
+
+    The registers are read and written with 32 bits accesses, for instance in
+    the PCIe BAR of the FPGA mapped from its "resource" file:
+    "/sys/bus/pci/devices/<domain:bus:device.function>/resource<bar>"
+
+    Pass the instance as "read_register" argument of
+    "accelize_drm.DrmManager" and None as "write_register".
+
+    Args:
+        path (path-like object): Path of the file to map.
+        base_address (int): DRM Controller base address in the file.
+        size (int): Size in bytes of the DRM Controller address range.
+    """
+
+    def __init__(self, path, base_address=0, size=0x10000):
+        # Map whole pages
+        offset = base_address - base_address % _PAGESIZE
+        length = base_address - offset + size
+        fd = _os.open(path, _os.O_RDWR | getattr(_os, 'O_SYNC', 0))
+        try:
+            self._mmap = _mmap(fd, length, offset=offset)
+        finally:
+            _os.close(fd)
+        self._buffer = _c_char.from_buffer(self._mmap)
+
+        self._read_function = 0
+        self._write_function = 0
+        self._user_p = 0
+        self._base_address = base_address - offset
+        self._mapping_address = _addressof(self._buffer)
+        self._mapping_size = length
+
+    def close(self):
+        """
+        Unmap the registers.
+
+        The DrmManager instances using the mapping must be freed before.
+        """
+        if self._buffer is not None:
+            self._buffer = None
+            self._mapping_address = 0
+            self._mmap.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
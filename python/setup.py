@@ -41,7 +41,7 @@ PACKAGE_INFO = dict(
     python_requires='>=3.6',
     setup_requires=['setuptools'],
     packages=['accelize_drm'],
-    package_data={'accelize_drm': ['*.pxd']},
+    package_data={'accelize_drm': ['*.pxd', '*.h']},
     zip_safe=False
 )
 
@@ -137,7 +137,8 @@ if __name__ == '__main__':
     library_dirs = ['/usr/local/lib64', '/usr/local/lib']
     include_dir = 'accelize_drm'
     extension_kwargs.update(dict(
-        library_dirs=library_dirs, runtime_library_dirs=library_dirs))
+        library_dirs=library_dirs, runtime_library_dirs=library_dirs,
+        include_dirs=[include_dir]))
     ext_kwargs = [
         dict(name='accelize_drm._accelize_drm',
              extra_compile_args=compile_args + ['-std=c++11'],
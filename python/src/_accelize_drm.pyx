@@ -5,6 +5,8 @@
 """Accelize DRM Python binding"""
 from libcpp cimport bool
 from libcpp.string cimport string
+from libc.stdint cimport uint32_t, uint64_t
+from libc.stdlib cimport malloc, free
 
 from os import fsencode as _fsencode
 from ctypes import (
@@ -14,15 +16,24 @@ from json import dumps as _dumps, loads as _loads
 
 from accelize_drm.libaccelize_drm cimport (
     DrmManager as C_DrmManager, getApiVersion,
-    ReadRegisterCallback, WriteRegisterCallback, AsynchErrorCallback)
+    ReadRegisterCallback, WriteRegisterCallback, AsynchErrorCallback,
+    NativeRegisters_newDrmManager, license_status, session_status,
+    session_id, num_license_loaded)
+from accelize_drm.native_registers cimport (
+    NativeRegisters as C_NativeRegisters, NativeReadRegister,
+    NativeWriteRegister)
 
 from accelize_drm.exceptions import (
     _async_error_callback, _raise_from_error, DRMBadArg as _DRMBadArg)
+from accelize_drm.registers import NativeRegisters as _NativeRegisters
 
 _ASYNC_ERROR_CFUNCTYPE = _CFUNCTYPE(_c_void_p, _c_void_p)
 _READ_REGISTER_CFUNCTYPE = _CFUNCTYPE(_c_int, _c_uint32, _POINTER(_c_uint32))
 _WRITE_REGISTER_CFUNCTYPE = _CFUNCTYPE(_c_int, _c_uint32, _c_uint32)
 
+# Initial number of counters allocated by "read_metering"
+_METERING_BUFFER_SIZE = 64
+
 
 def _handle_exceptions(exception):
     """
@@ -37,6 +48,26 @@ def _handle_exceptions(exception):
     _raise_from_error(str(exception))
 
 
+cdef int _set_native_registers(C_NativeRegisters* native_registers,
+                              registers) except -1:
+    """
+    Set the native register backend structure.
+
+    Args:
+        native_registers (NativeRegisters*): Structure to set.
+        registers (accelize_drm.registers.NativeRegisters): Register backend.
+    """
+    native_registers.read_register = <NativeReadRegister><size_t>(
+        registers._read_function)
+    native_registers.write_register = <NativeWriteRegister><size_t>(
+        registers._write_function)
+    native_registers.user_p = <void*><size_t>registers._user_p
+    native_registers.base_address = registers._base_address
+    native_registers.mapping = <uint32_t*><size_t>registers._mapping_address
+    native_registers.mapping_size = registers._mapping_size
+    return 0
+
+
 def _get_api_version():
     """
     Return "libaccelize_drm" API version.
@@ -59,13 +90,16 @@ cdef class DrmManager:
             Path to the DRM configuration JSON file.
         cred_file_path (path-like object):
             Path to the user Accelize credential JSON file.
-        read_register (function): FPGA read register callback function.
+        read_register (function or accelize_drm.registers.NativeRegisters):
+            FPGA read register callback function.
             The function needs to return an int and accept following arguments:
             register_offset (int), returned_data (int).
             The function can't be a non static method.
             register_offset is relative to first register of DRM controller
             This function must be thread-safe in case of concurrency on the
             register bus.
+            With a native register backend, the register accesses do not
+            require the Python GIL.
         write_register (function): FPGA write register callback function.
             The function needs to return an int and accept following arguments:
             register_offset (int), data_to_write (int).
@@ -73,6 +107,7 @@ cdef class DrmManager:
             register_offset is relative to first register of DRM controller
             This function must be thread-safe in case of concurrency on the
             register bus.
+            Must be None if "read_register" is a native register backend.
         async_error (function): Asynchronous error handling callback function.
             This function is called in case of asynchronous error during
             operation.
@@ -92,6 +127,8 @@ cdef class DrmManager:
     cdef object _async_error
     cdef object _async_error_c
     cdef AsynchErrorCallback _async_error_p
+    cdef C_NativeRegisters _native_registers
+    cdef bool _use_native_registers
     cdef string _conf_file_path
     cdef string _cred_file_path
 
@@ -103,24 +140,37 @@ cdef class DrmManager:
         self._cred_file_path = _fsencode(cred_file_path)
 
         # Handle callbacks
-        if not hasattr(read_register, "__call__"):
-            _raise_from_error(
-                'Read register callback function must not be None',
-                error_code=_DRMBadArg.error_code)
-        if not hasattr(write_register, "__call__"):
-            _raise_from_error(
-                'Write register callback function must not be None',
-                error_code=_DRMBadArg.error_code)
-
-        self._read_register = read_register
-        self._read_register_c = _READ_REGISTER_CFUNCTYPE(read_register)
-        self._read_register_p = (<ReadRegisterCallback*><size_t>_addressof(
-            self._read_register_c))[0]
-
-        self._write_register = write_register
-        self._write_register_c = _WRITE_REGISTER_CFUNCTYPE(write_register)
-        self._write_register_p = (<WriteRegisterCallback*><size_t>_addressof(
-            self._write_register_c))[0]
+        self._use_native_registers = isinstance(
+            read_register, _NativeRegisters)
+        if self._use_native_registers:
+            if write_register is not None:
+                _raise_from_error(
+                    'Write register callback function must be None with a '
+                    'native register backend',
+                    error_code=_DRMBadArg.error_code)
+            # Keep a reference to the backend
+            self._read_register = read_register
+            _set_native_registers(&self._native_registers, read_register)
+
+        else:
+            if not hasattr(read_register, "__call__"):
+                _raise_from_error(
+                    'Read register callback function must not be None',
+                    error_code=_DRMBadArg.error_code)
+            if not hasattr(write_register, "__call__"):
+                _raise_from_error(
+                    'Write register callback function must not be None',
+                    error_code=_DRMBadArg.error_code)
+
+            self._read_register = read_register
+            self._read_register_c = _READ_REGISTER_CFUNCTYPE(read_register)
+            self._read_register_p = (<ReadRegisterCallback*><size_t>_addressof(
+                self._read_register_c))[0]
+
+            self._write_register = write_register
+            self._write_register_c = _WRITE_REGISTER_CFUNCTYPE(write_register)
+            self._write_register_p = (<WriteRegisterCallback*><size_t>_addressof(
+                self._write_register_c))[0]
 
         if async_error is None:
             # Use default error callback
@@ -145,10 +195,15 @@ cdef class DrmManager:
         # Instantiate object
         try:
             with nogil:
-                self._drm_manager = new C_DrmManager(
-                    self._conf_file_path, self._cred_file_path,
-                    self._read_register_p, self._write_register_p,
-                    self._async_error_p)
+                if self._use_native_registers:
+                    self._drm_manager = NativeRegisters_newDrmManager(
+                        self._conf_file_path, self._cred_file_path,
+                        &self._native_registers, self._async_error_p)
+                else:
+                    self._drm_manager = new C_DrmManager(
+                        self._conf_file_path, self._cred_file_path,
+                        self._read_register_p, self._write_register_p,
+                        self._async_error_p)
         except RuntimeError as exception:
             _handle_exceptions(exception)
 
@@ -224,6 +279,39 @@ cdef class DrmManager:
         except RuntimeError as exception:
             _handle_exceptions(exception)
 
+    def read_metering(self):
+        """
+        Read the metering counters of the activators.
+
+        This function reads the per-activator counters directly from the DRM
+        Controller metering file. Unlike the "metered_data" parameter, it
+        builds no JSON object, does not contact the Web Service and does not
+        affect the health requests. It is suited for frequent polling.
+
+        Returns:
+            list of int: Counter of each activator, ordered by activator index.
+                Empty list if no session is running.
+        """
+        cdef size_t size = _METERING_BUFFER_SIZE
+        cdef uint32_t nb_activators = 0
+        cdef uint64_t* counts = NULL
+        try:
+            while True:
+                free(counts)
+                counts = <uint64_t*>malloc(size * sizeof(uint64_t))
+                if counts is NULL:
+                    raise MemoryError()
+                with nogil:
+                    nb_activators = self._drm_manager.read_metering(
+                        counts, size)
+                if nb_activators <= size:
+                    return [counts[i] for i in range(nb_activators)]
+                size = nb_activators
+        except RuntimeError as exception:
+            _handle_exceptions(exception)
+        finally:
+            free(counts)
+
     def set(self, **values):
         """
         Set information of the DRM system.
@@ -271,3 +359,75 @@ cdef class DrmManager:
         if len(keys) > 1:
             return items
         return items[keys[0]]
+
+    def get_license_status(self):
+        """
+        Get the "license_status" parameter without JSON conversion.
+
+        Returns:
+            bool: True if a valid license is loaded in the DRM Controller.
+        """
+        cdef bool value
+        try:
+            with nogil:
+                value = self._drm_manager.get_bool(license_status)
+        except RuntimeError as exception:
+            _handle_exceptions(exception)
+        return value
+
+    def get_session_status(self):
+        """
+        Get the "session_status" parameter without JSON conversion.
+
+        Returns:
+            bool: True if a session is running.
+        """
+        cdef bool value
+        try:
+            with nogil:
+                value = self._drm_manager.get_bool(session_status)
+        except RuntimeError as exception:
+            _handle_exceptions(exception)
+        return value
+
+    def get_session_id(self):
+        """
+        Get the "session_id" parameter without JSON conversion.
+
+        Returns:
+            str: Session ID, empty if no session is running.
+        """
+        cdef string value
+        try:
+            with nogil:
+                value = self._drm_manager.get_string(session_id)
+        except RuntimeError as exception:
+            _handle_exceptions(exception)
+        return bytes(value).decode()
+
+    def get_num_license_loaded(self):
+        """
+        Get the "num_license_loaded" parameter without JSON conversion.
+
+        Returns:
+            int: Number of licenses loaded in the DRM Controller.
+        """
+        cdef uint32_t value
+        try:
+            with nogil:
+                value = self._drm_manager.get_uint32(num_license_loaded)
+        except RuntimeError as exception:
+            _handle_exceptions(exception)
+        return value
+
+    def get_metered_data(self):
+        """
+        Get the "metered_data" parameter without JSON conversion.
+
+        The counters are read with "read_metering".
+
+        Returns:
+            list of int: Counter of each activator, ordered by activator index.
+                Empty list if no session is running.
+        """
+        return self.read_metering()
@@ -3,6 +3,9 @@
 # cython: language_level=3
 """Accelize DRM Python binding (C binding variant)"""
 
+from libc.stdint cimport uint32_t, uint64_t
+from libc.stdlib cimport malloc, free
+
 from os import fsencode as _fsencode
 from ctypes import (
     CFUNCTYPE as _CFUNCTYPE, POINTER as _POINTER, c_uint32 as _c_uint32,
@@ -14,11 +17,18 @@ from accelize_drm.libaccelize_drmc cimport (
     DrmManager as C_DrmManager,
     ReadRegisterCallback, WriteRegisterCallback, AsynchErrorCallback,
     DrmManager_alloc, DrmManager_free, DrmManager_activate,
-    DrmManager_deactivate, DrmManager_get_json_string,
-    DrmManager_set_json_string, DrmManager_getApiVersion)
+    DrmManager_deactivate, DrmManager_read_metering,
+    DrmManager_get_json_string, DrmManager_set_json_string,
+    DrmManager_get_bool, DrmManager_get_uint, DrmManager_get_string,
+    DrmManager_getApiVersion, bool, DRM__license_status, DRM__session_status,
+    DRM__session_id, DRM__num_license_loaded)
+from accelize_drm.native_registers cimport (
+    NativeRegisters as C_NativeRegisters, NativeReadRegister,
+    NativeWriteRegister, NativeRegisters_read, NativeRegisters_write)
 
 from accelize_drm.exceptions import (
     _raise_from_error, _async_error_callback, DRMBadArg as _DRMBadArg)
+from accelize_drm.registers import NativeRegisters as _NativeRegisters
 
 _ASYNC_ERROR_CFUNCTYPE = _CFUNCTYPE(_c_void_p, _c_char_p, _c_void_p)
 _READ_REGISTER_CFUNCTYPE = _CFUNCTYPE(
@@ -26,6 +36,29 @@ _READ_REGISTER_CFUNCTYPE = _CFUNCTYPE(
 _WRITE_REGISTER_CFUNCTYPE = _CFUNCTYPE(
     _c_int, _c_uint32, _c_uint32, _c_void_p)
 
+# Initial number of counters allocated by "read_metering"
+_METERING_BUFFER_SIZE = 64
+
+
+cdef int _set_native_registers(C_NativeRegisters* native_registers,
+                              registers) except -1:
+    """
+    Set the native register backend structure.
+
+    Args:
+        native_registers (NativeRegisters*): Structure to set.
+        registers (accelize_drm.registers.NativeRegisters): Register backend.
+    """
+    native_registers.read_register = <NativeReadRegister><size_t>(
+        registers._read_function)
+    native_registers.write_register = <NativeWriteRegister><size_t>(
+        registers._write_function)
+    native_registers.user_p = <void*><size_t>registers._user_p
+    native_registers.base_address = registers._base_address
+    native_registers.mapping = <uint32_t*><size_t>registers._mapping_address
+    native_registers.mapping_size = registers._mapping_size
+    return 0
+
 
 def _get_api_version():
     """
@@ -49,13 +82,16 @@ cdef class DrmManager:
             Path to the DRM configuration JSON file.
         cred_file_path (path-like object):
             Path to the user Accelize credential JSON file.
-        read_register (function): FPGA read register callback function.
+        read_register (function or accelize_drm.registers.NativeRegisters):
+            FPGA read register callback function.
             The function needs to return an int and accept following arguments:
             register_offset (int), returned_data (int).
             The function can't be a non static method.
             register_offset is relative to first register of DRM controller
             This function must be thread-safe in case of concurrency on the
             register bus.
+            With a native register backend, the register accesses do not
+            require the Python GIL.
         write_register (function): FPGA write register callback function.
             The function needs to return an int and accept following arguments:
             register_offset (int), data_to_write (int).
@@ -63,6 +99,7 @@ cdef class DrmManager:
             register_offset is relative to first register of DRM controller
             This function must be thread-safe in case of concurrency on the
             register bus.
+            Must be None if "read_register" is a native register backend.
         async_error (function): Asynchronous error handling callback function.
             This function is called in case of asynchronous error during
             operation.
@@ -81,6 +118,8 @@ cdef class DrmManager:
     cdef object _async_error
     cdef object _async_error_c
     cdef AsynchErrorCallback _async_error_p
+    cdef C_NativeRegisters _native_registers
+    cdef void* _user_p
     cdef object _conf_file_path
     cdef char*_conf_file_path_c
     cdef object _cred_file_path
@@ -96,32 +135,47 @@ cdef class DrmManager:
         self._cred_file_path_c = self._cred_file_path
 
         # Handle callbacks
-        if not hasattr(read_register, "__call__"):
-            _raise_from_error(
-                'Read register callback function must be a callable',
-                error_code=_DRMBadArg.error_code)
-        if not hasattr(write_register, "__call__"):
-            _raise_from_error(
-                'Write register callback function must be a callable',
-                error_code=_DRMBadArg.error_code)
-
-        def read_register_c(register_offset, returned_data, user_p):
-            """read_register with "user_p" support"""
-            return read_register(register_offset, returned_data)
-
-        self._read_register = (read_register_c, read_register)
-        self._read_register_c = _READ_REGISTER_CFUNCTYPE(read_register_c)
-        self._read_register_p = (<ReadRegisterCallback*> <size_t> _addressof(
-            self._read_register_c))[0]
-
-        def write_register_c(register_offset, returned_data, user_p):
-            """write_register with "user_p" support"""
-            return write_register(register_offset, returned_data)
-
-        self._write_register = (write_register_c, write_register)
-        self._write_register_c = _WRITE_REGISTER_CFUNCTYPE(write_register_c)
-        self._write_register_p = (<WriteRegisterCallback*> <size_t> _addressof(
-            self._write_register_c))[0]
+        if isinstance(read_register, _NativeRegisters):
+            if write_register is not None:
+                _raise_from_error(
+                    'Write register callback function must be None with a '
+                    'native register backend',
+                    error_code=_DRMBadArg.error_code)
+            # Keep a reference to the backend
+            self._read_register = read_register
+            _set_native_registers(&self._native_registers, read_register)
+            self._read_register_p = NativeRegisters_read
+            self._write_register_p = NativeRegisters_write
+            self._user_p = &self._native_registers
+
+        else:
+            if not hasattr(read_register, "__call__"):
+                _raise_from_error(
+                    'Read register callback function must be a callable',
+                    error_code=_DRMBadArg.error_code)
+            if not hasattr(write_register, "__call__"):
+                _raise_from_error(
+                    'Write register callback function must be a callable',
+                    error_code=_DRMBadArg.error_code)
+
+            def read_register_c(register_offset, returned_data, user_p):
+                """read_register with "user_p" support"""
+                return read_register(register_offset, returned_data)
+
+            self._read_register = (read_register_c, read_register)
+            self._read_register_c = _READ_REGISTER_CFUNCTYPE(read_register_c)
+            self._read_register_p = (<ReadRegisterCallback*> <size_t> _addressof(
+                self._read_register_c))[0]
+
+            def write_register_c(register_offset, returned_data, user_p):
+                """write_register with "user_p" support"""
+                return write_register(register_offset, returned_data)
+
+            self._write_register = (write_register_c, write_register)
+            self._write_register_c = _WRITE_REGISTER_CFUNCTYPE(write_register_c)
+            self._write_register_p = (<WriteRegisterCallback*> <size_t> _addressof(
+                self._write_register_c))[0]
+            self._user_p = <void*> self
 
         if async_error is None:
             # Use default error callback
@@ -148,7 +202,7 @@ cdef class DrmManager:
                 &self._drm_manager,
                 self._conf_file_path_c, self._cred_file_path_c,
                 self._read_register_p, self._write_register_p,
-                self._async_error_p, <void*> self)
+                self._async_error_p, self._user_p)
         if return_code:
             _raise_from_error(self._drm_manager.error_message, return_code)
 
@@ -229,6 +283,41 @@ cdef class DrmManager:
         if return_code:
             _raise_from_error(self._drm_manager.error_message, return_code)
 
+    def read_metering(self):
+        """
+        Read the metering counters of the activators.
+
+        This function reads the per-activator counters directly from the DRM
+        Controller metering file. Unlike the "metered_data" parameter, it
+        builds no JSON object, does not contact the Web Service and does not
+        affect the health requests. It is suited for frequent polling.
+
+        Returns:
+            list of int: Counter of each activator, ordered by activator index.
+                Empty list if no session is running.
+        """
+        cdef int return_code
+        cdef size_t size = _METERING_BUFFER_SIZE
+        cdef unsigned int nb_activators = 0
+        cdef uint64_t* counts = NULL
+        try:
+            while True:
+                free(counts)
+                counts = <uint64_t*>malloc(size * sizeof(uint64_t))
+                if counts is NULL:
+                    raise MemoryError()
+                with nogil:
+                    return_code = DrmManager_read_metering(
+                        self._drm_manager, counts, size, &nb_activators)
+                if return_code:
+                    _raise_from_error(
+                        self._drm_manager.error_message, return_code)
+                if nb_activators <= size:
+                    return [counts[i] for i in range(nb_activators)]
+                size = nb_activators
+        finally:
+            free(counts)
+
     def set(self, **values):
         """
         Set information of the DRM system.
@@ -278,3 +367,82 @@ cdef class DrmManager:
         if len(keys) > 1:
             return items
         return items[keys[0]]
+
+    def get_license_status(self):
+        """
+        Get the "license_status" parameter without JSON conversion.
+
+        Returns:
+            bool: True if a valid license is loaded in the DRM Controller.
+        """
+        cdef bool value
+        cdef int return_code
+        with nogil:
+            return_code = DrmManager_get_bool(
+                self._drm_manager, DRM__license_status, &value)
+        if return_code:
+            _raise_from_error(self._drm_manager.error_message, return_code)
+        return value
+
+    def get_session_status(self):
+        """
+        Get the "session_status" parameter without JSON conversion.
+
+        Returns:
+            bool: True if a session is running.
+        """
+        cdef bool value
+        cdef int return_code
+        with nogil:
+            return_code = DrmManager_get_bool(
+                self._drm_manager, DRM__session_status, &value)
+        if return_code:
+            _raise_from_error(self._drm_manager.error_message, return_code)
+        return value
+
+    def get_session_id(self):
+        """
+        Get the "session_id" parameter without JSON conversion.
+
+        Returns:
+            str: Session ID, empty if no session is running.
+        """
+        cdef char*value = NULL
+        cdef int return_code
+        with nogil:
+            return_code = DrmManager_get_string(
+                self._drm_manager, DRM__session_id, &value)
+        if return_code:
+            _raise_from_error(self._drm_manager.error_message, return_code)
+        try:
+            return bytes(value).decode()
+        finally:
+            free(value)
+
+    def get_num_license_loaded(self):
+        """
+        Get the "num_license_loaded" parameter without JSON conversion.
+
+        Returns:
+            int: Number of licenses loaded in the DRM Controller.
+        """
+        cdef unsigned int value
+        cdef int return_code
+        with nogil:
+            return_code = DrmManager_get_uint(
+                self._drm_manager, DRM__num_license_loaded, &value)
+        if return_code:
+            _raise_from_error(self._drm_manager.error_message, return_code)
+        return value
+
+    def get_metered_data(self):
+        """
+        Get the "metered_data" parameter without JSON conversion.
+
+        The counters are read with "read_metering".
+
+        Returns:
+            list of int: Counter of each activator, ordered by activator index.
+                Empty list if no session is running.
+        """
+        return self.read_metering()
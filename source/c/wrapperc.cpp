@@ -34,29 +34,35 @@ void checkPointer(void *p) {
         Throw( DRM_BadArg, "Provided pointer is NULL" );    //LCOV_EXCL_LINE
 }
 
+/* Copy an exception message in the error message buffer, truncated if needed */
+void setErrorMessage( DrmManager *m, const char* msg ) {
+    if ( m == NULL )
+        return;                                                 //LCOV_EXCL_LINE
+    size_t cp_size = strlen( msg );
+    if ( cp_size >= MAX_MSG_SIZE ) {
+        cp_size = MAX_MSG_SIZE - 6;
+        strcpy( m->error_message + cp_size, "[...]" );
+    } else {
+        m->error_message[cp_size] = '\0';
+    }
+    memcpy( m->error_message, msg, cp_size );
+}
+
 /* Help macros TRY/CATCH to return code error */
+/* Only the first byte of the error message is reset: clearing the whole buffer on each call is
+   costly for the typed accessors, and setErrorMessage always terminates the message */
 #define TRY                                        \
     DRM_ErrorCode __try_ret = DRM_OK;              \
     if ( m != NULL )                               \
-        memset(m->error_message, 0, MAX_MSG_SIZE); \
+        m->error_message[0] = '\0';                \
     try {
 
 #define CATCH_RETURN                                          \
     } catch( const cpp::Exception& e ) {                      \
-        int cp_size = strlen( e.what() );                     \
-        if ( cp_size >= MAX_MSG_SIZE ) {                      \
-            cp_size = MAX_MSG_SIZE - 6;                       \
-            strcpy( m->error_message + cp_size, "[...]" );    \
-        }                                                     \
-        strncpy( m->error_message, e.what(), cp_size );       \
+        setErrorMessage( m, e.what() );                       \
         __try_ret = e.getErrCode();                           \
     } catch( const std::exception& e ) {                      \
-        int cp_size = strlen( e.what() );                     \
-        if ( cp_size >= MAX_MSG_SIZE ) {                      \
-            cp_size = MAX_MSG_SIZE - 6;                       \
-            strcpy( m->error_message + cp_size, "[...]" );    \
-        }                                                     \
-        strncpy( m->error_message, e.what(), cp_size );       \
+        setErrorMessage( m, e.what() );                       \
         SPDLOG_ERROR( e.what() );                             \
         __try_ret = DRM_Fatal;                                \
     }                                                         \
@@ -122,6 +128,16 @@ DRM_ErrorCode DrmManager_deactivate( DrmManager *m, bool pause_session_request )
 }
 
 
+DRM_ErrorCode DrmManager_read_metering( DrmManager *m, uint64_t* counts, size_t n, unsigned int* p_nb_activators ) {
+    TRY
+        checkPointer(m);
+        uint32_t nb_activators = m->drm->obj->read_metering( counts, n );
+        if ( p_nb_activators != NULL )
+            *p_nb_activators = nb_activators;
+    CATCH_RETURN
+}
+
+
 DRM_ErrorCode DrmManager_get_bool( DrmManager *m, const DrmParameterKey key, bool* p_value ) {
     TRY
         checkPointer(m);
@@ -0,0 +1,296 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "daemon.h"
+#include "accelize/drm/error.h"
+#include "log.h"
+#include "utils.h"
+
+
+namespace Accelize {
+namespace DRM {
+
+
+static const int SERVER_POLL_PERIOD_MS = 200;
+static const size_t MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+
+
+static void fillSocketAddress( struct sockaddr_un& addr, const std::string& socket_path ) {
+    memset( &addr, 0, sizeof( addr ) );
+    if ( socket_path.empty() || ( socket_path.size() >= sizeof( addr.sun_path ) ) )
+        Throw( DRM_BadArg, "Invalid daemon socket path '{}'. ", socket_path );
+    addr.sun_family = AF_UNIX;
+    strncpy( addr.sun_path, socket_path.c_str(), sizeof( addr.sun_path ) - 1 );
+}
+
+static bool sendLine( int fd, const Json::Value& json_value ) {
+    std::string line = saveJsonToString( json_value ) + "\n";
+    size_t sent = 0;
+    while( sent < line.size() ) {
+        ssize_t ret = send( fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL );
+        if ( ret < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            return false;
+        }
+        sent += (size_t)ret;
+    }
+    return true;
+}
+
+/// Extract the next complete line from the buffer, return false if there is none
+static bool popLine( std::string& buffer, std::string& line ) {
+    size_t pos = buffer.find( '\n' );
+    if ( pos == std::string::npos )
+        return false;
+    line = buffer.substr( 0, pos );
+    buffer.erase( 0, pos + 1 );
+    return true;
+}
+
+
+DaemonServer::DaemonServer( const std::string& socket_path, mode_t socket_mode,
+                            RequestHandler request_handler, DisconnectHandler disconnect_handler )
+    : mSocketPath( socket_path ), mSocketMode( socket_mode ), mRequestHandler( request_handler ),
+      mDisconnectHandler( disconnect_handler )
+{
+    struct sockaddr_un addr;
+    fillSocketAddress( addr, socket_path );
+    // Never take over the socket of a running daemon
+    removeStaleSocket( socket_path );
+    int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( fd < 0 )
+        Throw( DRM_ExternFail, "Failed to create daemon socket: {}. ", strerror( errno ) );
+    if ( bind( fd, (struct sockaddr*)&addr, sizeof( addr ) ) ) {
+        close( fd );
+        Throw( DRM_ExternFail, "Failed to bind daemon socket to {}: {}. ", socket_path, strerror( errno ) );
+    }
+    if ( chmod( socket_path.c_str(), socket_mode ) ) {
+        int err = errno;
+        close( fd );
+        unlink( socket_path.c_str() );
+        Throw( DRM_ExternFail, "Failed to set mode {:o} of daemon socket {}: {}. ", socket_mode, socket_path, strerror( err ) );
+    }
+    if ( listen( fd, 16 ) ) {
+        close( fd );
+        unlink( socket_path.c_str() );
+        Throw( DRM_ExternFail, "Failed to listen on daemon socket {}: {}. ", socket_path, strerror( errno ) );
+    }
+    mServerFd = fd;
+    mAcceptThread = std::thread( &DaemonServer::acceptLoop, this );
+    Debug( "DRM daemon listening on {}", socket_path );
+}
+
+DaemonServer::~DaemonServer() {
+    stop();
+}
+
+void DaemonServer::stop() {
+    if ( !mAcceptThread.joinable() )
+        return;
+    mStop = true;
+    mAcceptThread.join();
+    // The accept thread is stopped: no client thread can be added anymore
+    for( auto& client: mClientThreads )
+        client.thread.join();
+    mClientThreads.clear();
+    close( mServerFd );
+    mServerFd = -1;
+    unlink( mSocketPath.c_str() );
+    Debug( "DRM daemon stopped listening on {}", mSocketPath );
+}
+
+void DaemonServer::acceptLoop() {
+    struct pollfd pfd;
+    pfd.fd = mServerFd;
+    pfd.events = POLLIN;
+    while( !mStop ) {
+        if ( poll( &pfd, 1, SERVER_POLL_PERIOD_MS ) <= 0 )
+            continue;
+        reapClients();
+        int client = accept( mServerFd, NULL, NULL );
+        if ( client < 0 )
+            continue;
+        if ( !isPeerAllowed( client ) ) {
+            close( client );
+            continue;
+        }
+        uint64_t client_id = mNextClientId++;
+        Debug( "DRM daemon client {} connected", client_id );
+        mClientThreads.emplace_back();
+        ClientThread& entry = mClientThreads.back();
+        entry.thread = std::thread( &DaemonServer::serveClient, this, client, client_id, &entry.done );
+    }
+}
+
+void DaemonServer::reapClients() {
+    for( auto it = mClientThreads.begin(); it != mClientThreads.end(); ) {
+        if ( it->done ) {
+            it->thread.join();
+            it = mClientThreads.erase( it );
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool DaemonServer::isPeerAllowed( int fd ) const {
+    struct ucred cred;
+    socklen_t len = sizeof( cred );
+    if ( getsockopt( fd, SOL_SOCKET, SO_PEERCRED, &cred, &len ) ) {
+        Warning( "DRM daemon rejected a client: failed to get its credentials: {}", strerror( errno ) );
+        return false;
+    }
+    if ( ( cred.uid == 0 ) || ( cred.uid == geteuid() ) )
+        return true;
+    if ( ( mSocketMode & S_IRWXG ) && ( cred.gid == getegid() ) )
+        return true;
+    if ( mSocketMode & S_IRWXO )
+        return true;
+    Warning( "DRM daemon rejected a client: process {} of user {} is not granted by socket mode {:o}",
+             cred.pid, cred.uid, mSocketMode );
+    return false;
+}
+
+void DaemonServer::serveClient( int fd, uint64_t client_id, std::atomic<bool>* done ) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    std::string buffer;
+    std::string line;
+    char chunk[4096];
+
+    while( !mStop ) {
+        if ( poll( &pfd, 1, SERVER_POLL_PERIOD_MS ) <= 0 )
+            continue;
+        ssize_t ret = recv( fd, chunk, sizeof( chunk ), 0 );
+        if ( ret <= 0 ) {
+            if ( ( ret < 0 ) && ( errno == EINTR ) )
+                continue;
+            break;
+        }
+        buffer.append( chunk, (size_t)ret );
+        if ( buffer.size() > MAX_REQUEST_SIZE ) {
+            Warning( "DRM daemon client {} disconnected: request exceeds {} bytes", client_id, MAX_REQUEST_SIZE );
+            break;
+        }
+        bool connected = true;
+        while( connected && popLine( buffer, line ) ) {
+            Json::Value reply( Json::objectValue );
+            try {
+                Json::Value request = parseJsonString( line );
+                reply["result"] = mRequestHandler( client_id, request );
+            } catch( const Exception& e ) {
+                reply["error"]["code"] = (int)e.getErrCode();
+                reply["error"]["message"] = e.std::runtime_error::what();
+            } catch( const std::exception& e ) {
+                reply["error"]["code"] = (int)DRM_ExternFail;
+                reply["error"]["message"] = e.what();
+            }
+            connected = sendLine( fd, reply );
+        }
+        if ( !connected )
+            break;
+    }
+    close( fd );
+    Debug( "DRM daemon client {} disconnected", client_id );
+    try {
+        mDisconnectHandler( client_id );
+    } catch( const std::exception& e ) {
+        Warning( "DRM daemon failed to release client {}: {}", client_id, e.what() );
+    }
+    *done = true;
+}
+
+
+DaemonClient::DaemonClient( const std::string& socket_path, uint32_t timeout_ms )
+    : mSocketPath( socket_path ), mTimeoutMS( timeout_ms )
+{
+    struct sockaddr_un addr;
+    fillSocketAddress( addr, socket_path );
+    mFd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( mFd < 0 )
+        Throw( DRM_ExternFail, "Failed to create daemon socket: {}. ", strerror( errno ) );
+    if ( connect( mFd, (struct sockaddr*)&addr, sizeof( addr ) ) ) {
+        int err = errno;
+        close( mFd );
+        mFd = -1;
+        Throw( DRM_ExternFail, "Failed to connect to DRM daemon on {}: {}. ", socket_path, strerror( err ) );
+    }
+    Debug( "Connected to DRM daemon on {}", socket_path );
+}
+
+DaemonClient::~DaemonClient() {
+    if ( mFd >= 0 )
+        close( mFd );
+}
+
+Json::Value DaemonClient::call( const Json::Value& request ) {
+    std::lock_guard<std::mutex> lock( mMutex );
+    if ( mFd < 0 )
+        Throw( DRM_ExternFail, "Connection to DRM daemon on {} is closed. ", mSocketPath );
+    if ( !sendLine( mFd, request ) )
+        Throw( DRM_ExternFail, "Failed to send request to DRM daemon on {}: {}. ", mSocketPath, strerror( errno ) );
+
+    std::string line;
+    char chunk[4096];
+    struct pollfd pfd;
+    pfd.fd = mFd;
+    pfd.events = POLLIN;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( mTimeoutMS );
+    while( !popLine( mBuffer, line ) ) {
+        int64_t time_left_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now() ).count();
+        int ret_poll = ( time_left_ms > 0 ) ? poll( &pfd, 1, (int)time_left_ms ) : 0;
+        if ( ret_poll < 0 && errno == EINTR )
+            continue;
+        if ( ret_poll == 0 ) {
+            // A late reply would be taken for the reply of the next request: drop the connection
+            close( mFd );
+            mFd = -1;
+            mBuffer.clear();
+            Throw( DRM_ExternFail, "Timeout on request to DRM daemon on {} after {} ms. ", mSocketPath, mTimeoutMS );
+        }
+        ssize_t ret = ( ret_poll > 0 ) ? recv( mFd, chunk, sizeof( chunk ), 0 ) : -1;
+        if ( ret < 0 && errno == EINTR )
+            continue;
+        if ( ret <= 0 ) {
+            close( mFd );
+            mFd = -1;
+            Throw( DRM_ExternFail, "Connection to DRM daemon on {} was lost. ", mSocketPath );
+        }
+        mBuffer.append( chunk, (size_t)ret );
+    }
+    Json::Value reply = parseJsonString( line );
+    if ( reply.isMember( "error" ) ) {
+        const Json::Value& error = reply["error"];
+        DRM_ErrorCode code = (DRM_ErrorCode)error.get( "code", (int)DRM_ExternFail ).asInt();
+        Throw( code, "{}", error.get( "message", "" ).asString() );
+    }
+    return reply["result"];
+}
+
+
+}
+}
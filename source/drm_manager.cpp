@@ -19,6 +19,7 @@ limitations under the License.
 #include <iomanip>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <json/json.h>
 #include <json/version.h>
@@ -28,7 +29,9 @@ limitations under the License.
 #include <future>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 #include <queue>
+#include <set>
 #include <fstream>
 #include <typeinfo>
 #include <sys/types.h>
@@ -42,6 +45,12 @@ limitations under the License.
 #include "log.h"
 #include "utils.h"
 #include "csp.h"
+#include "shared_mutex.h"
+#include "register_trace.h"
+#include "metrics.h"
+#include "session_spool.h"
+#include "daemon.h"
+#include "retry_policy.h"
 
 
 #pragma GCC diagnostic push
@@ -81,13 +90,13 @@ limitations under the License.
             if ( ( errcode == DRM_WSMayRetry ) || ( errcode == DRM_WSTimedOut ) ) \
                 errmsg += DRM_CONNECTION_ERROR_MESSAGE;                           \
             Fatal( errmsg );                                                      \
-            sLogger->flush();                                                     \
+            flushLog();                                                           \
             f_asynch_error( errmsg );                                             \
         }                                                                         \
         throw;                                                                    \
     } catch( const std::exception &e ) {                                          \
         Fatal( e.what() );                                                        \
-        sLogger->flush();                                                         \
+        flushLog();                                                               \
         f_asynch_error( e.what() );                                               \
         throw;                                                                    \
     }
@@ -242,6 +251,8 @@ protected:
             {eLicenseType::NODE_LOCKED, "Node-Locked"}
     };
 
+    static const uint32_t DRM_PAGE_UNKNOWN = 0xFFFFFFFF;
+
     uint32_t SDK_CTRL_TIMEOUT_IN_US = 10000000;
     uint32_t SDK_CTRL_SLEEP_IN_US = 100;
 
@@ -267,9 +278,68 @@ protected:
     // Composition
     std::unique_ptr<DrmWSClient> mWsClient;
     std::unique_ptr<DrmControllerLibrary::DrmControllerOperations> mDrmController;
-    mutable std::recursive_mutex mDrmControllerMutex;
+    /* DRM Controller access locking
+     * - Sequences accessing several registers of a page other than the registers page (page 0),
+     *   issuing commands or switching pages on purpose take the exclusive lock. They are fully
+     *   serialized with any other access to the DRM Controller.
+     * - Single status reads in the registers page take the shared lock with checkDRMCtlrRetShared:
+     *   they run concurrently with each other but never during an exclusive sequence, so they
+     *   always observe a consistent page selection. A failing access logs the DRM Controller
+     *   errors under the exclusive lock, so a thread must never call them while holding the
+     *   shared lock (the exclusive lock would wait for its own shared lock forever).
+     * - The register callbacks are serialized, unless mConcurrentRegisterAccess allows the
+     *   shared accesses to call them concurrently.
+     * - If mPageRegisterCached, the page register value is cached: writing the page already
+     *   selected is skipped, so a status read costs a single register read while the registers
+     *   page is selected.
+     */
+    mutable RecursiveSharedMutex mDrmControllerMutex;
+    mutable std::mutex mRegisterCallbackMutex;                          ///< Serializes the register callbacks
+    mutable std::atomic<uint32_t> mDrmPageCache{ DRM_PAGE_UNKNOWN };   ///< Last value written in the page register
+    bool mConcurrentRegisterAccess = false;     ///< If true, the register callbacks can be called concurrently
+    bool mPageRegisterCached = false;           ///< If true, the write of the page already selected is skipped
+
+    // Binary trace of the register accesses; null when disabled
+    std::unique_ptr<RegisterTrace> mRegisterTrace;
+    std::string mRegisterTraceFile = fmt::format( "accelize_drmlib_{}.trace", getpid() );
+
+    // Runtime statistics
+    bool mMetricsEnabled = false;         ///< If true, this instance contributes to the process metrics
+    std::string mMetricsEndpoint;         ///< Local endpoint serving the metrics: "unix:<path>" or "tcp:<port>"
+
+    // Deferred session close
+    std::string mSessionSpoolDir;                 ///< Spool directory of the close requests, empty to close synchronously
+    std::unique_ptr<SessionSpool> mSessionSpool;
+    std::future<void> mThreadSpool;               ///< Background thread posting the spooled close requests
+    std::mutex mSpoolMtx;
+    std::condition_variable mSpoolCondVar;        ///< Wakes the spool thread waiting before a retry
+    bool mSpoolFlushRunning = false;
+    bool mSpoolFlushPending = false;
+    bool mSpoolStop = false;                      ///< Requests a last flush attempt on destruction
+    std::atomic<bool> mSpoolExit{false};          ///< Aborts the spool flush on destruction
+
+    // Device profile
+    std::string mDeviceProfilePath;     ///< File of the device profile, empty to probe the device on each construction
+    Json::Value mDeviceProfile;         ///< Profile read from the file, null if it does not match the device
+
+    // Fast resume
+    bool mFastResume = false;                   ///< If true, the construction is reduced when a session with a valid license is pending
+    bool mFastResumePending = false;            ///< True until the pending session is resumed or replaced
+    bool mFrequencyDetectionPending = false;    ///< True if the frequency measure has been deferred
+    bool mHostDataPending = false;              ///< True if the host and card information collection has been deferred
     bool mIsLockedToDrm = false;
 
+    // Host-local daemon
+    std::string mDaemonServerSocket;            ///< Socket on which this instance serves its session to the clients
+    std::string mDaemonSocket;                  ///< Socket of the daemon this instance forwards its calls to
+    mode_t mDaemonSocketMode = 0600;            ///< Mode of the daemon socket, granting access to the clients
+    uint32_t mDaemonTimeout = 60;               ///< Timeout in seconds of a call forwarded to the daemon
+    std::unique_ptr<DaemonServer> mDaemonServer;
+    std::unique_ptr<DaemonClient> mDaemonClient;
+    std::mutex mDaemonMtx;                      ///< Serializes the requests of the clients
+    std::set<uint64_t> mDaemonClients;          ///< Clients which activated the session and did not deactivate it yet
+    bool mDaemonSessionActive = false;          ///< True if the session has been activated on behalf of the clients
+
     // Logging parameters
     spdlog::level::level_enum sLogConsoleVerbosity = spdlog::level::err;
     std::string sLogConsoleFormat = std::string("[%^%=8l%$] %-6t, %v");
@@ -282,6 +352,10 @@ protected:
     size_t       sLogFileRotatingSize = 100*1024; ///< Size max in KBytes of the log roating file
     size_t       sLogFileRotatingNum  = 3;
 
+    bool         sLogAsync            = false;      ///< If true, messages are written by a background thread
+    size_t       sLogAsyncQueueSize   = 8192;       ///< Maximum number of messages waiting in the asynchronous queue
+    spdlog::async_overflow_policy sLogAsyncOverflow = spdlog::async_overflow_policy::block;
+
     eCtrlLogVerbosity sLogCtrlVerbosity = eCtrlLogVerbosity::ERROR;
 
     // Function callbacks
@@ -306,6 +380,10 @@ protected:
     uint32_t mWSRetryPeriodLong  = 60;    ///< Time in seconds before the next request attempt to the Web Server when the time left before timeout is large
     uint32_t mWSRetryPeriodShort = 2;     ///< Time in seconds before the next request attempt to the Web Server when the time left before timeout is short
     uint32_t mWSApiRetryDuration = 60;    ///< Period of time in seconds during which retries occur on activate and deactivate functions
+    RetryPolicy mLicenseRetryPolicy;      ///< Backoff of the license requests, replaces the fixed retry periods when enabled
+    RetryPolicy mHealthRetryPolicy;       ///< Backoff of the health requests, replaces the fixed retry period when enabled
+    double mLicenseRenewalJitter = 0;     ///< Maximum random delay of a license renewal, as a fraction of the license duration
+    double mHealthPeriodJitter = 0;       ///< Maximum random reduction of a health period, as a fraction of the period
 
     eLicenseType mLicenseType = eLicenseType::METERED;
     uint32_t mLicenseDuration = 0;        ///< Time duration in seconds of the license
@@ -319,6 +397,44 @@ protected:
     // To protect access to the metering data (to securize the segment ID check in HW)
     mutable std::mutex mMeteringAccessMutex;
 
+    // Shared metering snapshot
+    struct MeteringSnapshot {
+        TClock::time_point timestamp;       ///< Time of the extraction
+        std::vector<uint64_t> counts;       ///< Counter of each activator, empty when no session is running
+    };
+    mutable std::shared_ptr<const MeteringSnapshot> mMeteringSnapshot;  ///< Latest snapshot, only accessed with std::atomic_load/std::atomic_store
+    mutable std::mutex mMeteringSnapshotMutex;                          ///< Serializes the refresh of the snapshot
+    std::atomic<uint32_t> mMeteringCachePeriod{ 0 };    ///< Maximum age in milliseconds of the metering snapshot; 0 disables the cache
+
+    // Shared status snapshot
+    struct StatusSnapshot {
+        uint64_t version;                   ///< Publication number, incremented at each publication
+        TClock::time_point timestamp;       ///< Time of the publication
+        bool sessionRunning;                ///< Session running status of the DRM Controller
+        bool licenseActive;                 ///< True if the DRM Controller has a valid license
+        uint32_t numLicenseLoaded;          ///< Number of licenses provisioned in the DRM Controller
+        eLicenseType drmLicenseType;        ///< License mode of the DRM Controller
+        uint32_t licenseDuration;           ///< Duration in seconds of the last license
+        TClock::time_point expirationTime;  ///< Expiration time of the provisioned licenses
+    };
+    mutable std::shared_ptr<const StatusSnapshot> mStatusSnapshot;  ///< Latest snapshot, only accessed with std::atomic_load/std::atomic_store
+    mutable std::mutex mStatusPublishMutex;                         ///< Orders the publications with their versions
+    mutable std::atomic<uint64_t> mStatusVersion{ 0 };              ///< Version reserved by the last status read
+    bool mStatusCached = false;           ///< If true, the status parameters are read from the status snapshot
+
+    // Design information, fixed for the life of the bitstream
+    struct DesignInfo {
+        std::string drmVersion;             ///< Version of the DRM Controller
+        std::string dna;                    ///< DNA of the device
+        std::vector<std::string> vlnvFile;  ///< VLNV of the DRM Controller followed by the ones of the activators
+        std::string mailboxReadOnly;        ///< Content of the read-only mailbox
+        Json::Value mailboxRoData;          ///< Parsed content of the read-only mailbox, null if empty
+        uint32_t numActivators;             ///< Number of activators detected by the DRM Controller
+        uint32_t mailboxRoSize;             ///< Size in words of the read-only mailbox
+        uint32_t mailboxRwSize;             ///< Size in words of the read-write mailbox
+    };
+    mutable std::shared_ptr<const DesignInfo> mDesignInfo;  ///< Read once, only accessed with std::atomic_load/std::atomic_store
+
     // Operating mode
     bool mIsHybrid = false;
     bool mIsPnR = false;
@@ -358,7 +474,7 @@ protected:
     bool mSecurityStop{false};
     std::mutex mThreadExitMtx;
     std::condition_variable mThreadExitCondVar;
-    bool mThreadExit{false};
+    std::atomic<bool> mThreadExit{false};   // Also aborts the in-flight Web Service requests
 
     // XRT PATH
     std::string mXrtPath;
@@ -366,26 +482,45 @@ protected:
     Json::Value mHostConfigData = Json::nullValue;
     eHostDataVerbosity mHostDataVerbosity = eHostDataVerbosity::PARTIAL;
     Json::Value mSettings = Json::nullValue;
-    Json::Value mMailboxRoData = Json::nullValue;
 
     // Debug parameters
     spdlog::level::level_enum mDebugMessageLevel;
 
-    // User accessible parameters
-    const std::map<ParameterKey, std::string> mParameterKeyMap = {
-    #   define PARAMETERKEY_ITEM(id) {id, #id},
-    #   include "accelize/drm/ParameterKey.def"
-    #   undef PARAMETERKEY_ITEM
-        {ParameterKeyCount, "ParameterKeyCount"}
-    };
+    // User accessible parameters: names indexed by ParameterKey
+    static const char* const* getParameterKeyNames() {
+        static const char* const names[] = {
+        #   define PARAMETERKEY_ITEM(id) #id,
+        #   include "accelize/drm/ParameterKey.def"
+        #   undef PARAMETERKEY_ITEM
+            "ParameterKeyCount"
+        };
+        return names;
+    }
+
+    // User accessible parameters: names sorted alphabetically for the lookup by name
+    typedef std::pair<const char*, ParameterKey> ParameterKeyEntry;
+    static const std::vector<ParameterKeyEntry>& getSortedParameterKeys() {
+        static const std::vector<ParameterKeyEntry> table = []() {
+            std::vector<ParameterKeyEntry> entries;
+            for( int i=0; i <= ParameterKey::ParameterKeyCount; i++ )
+                entries.push_back( ParameterKeyEntry( getParameterKeyNames()[i], static_cast<ParameterKey>( i ) ) );
+            std::sort( entries.begin(), entries.end(),
+                    []( const ParameterKeyEntry& a, const ParameterKeyEntry& b ) { return strcmp( a.first, b.first ) < 0; } );
+            return entries;
+        }();
+        return table;
+    }
 
 
     #define checkDRMCtlrRet( func ) {                                                           \
         unsigned int errcode = DRM_OK;                                                          \
         try {                                                                                   \
-            std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );                  \
+            static auto& latency = Metrics::instance().controllerOperation( #func );            \
+            std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );                  \
+            LatencyTimer latency_timer( latency );                                              \
             errcode = func;                                                                     \
-            Debug( "{} returned {}", #func, errcode );                                          \
+            if ( LogEnabled( spdlog::level::debug ) )                                           \
+                Debug( "{} returned {}", #func, errcode );                                      \
             if ( errcode ) {                                                                    \
                 logDrmCtrlError();                                                              \
                 logDrmCtrlTrngStatus();                                                         \
@@ -400,6 +535,35 @@ protected:
         }                                                                                       \
     }
 
+    // Same as checkDRMCtlrRet for status reads in the registers page: the shared lock is
+    // released before logging the DRM Controller errors (which requires the exclusive lock).
+    #define checkDRMCtlrRetShared( func ) {                                                     \
+        unsigned int errcode = DRM_OK;                                                          \
+        std::string except_msg;                                                                 \
+        try {                                                                                   \
+            static auto& latency = Metrics::instance().controllerOperation( #func );            \
+            SharedLockGuard lock( mDrmControllerMutex );                                        \
+            LatencyTimer latency_timer( latency );                                              \
+            errcode = func;                                                                     \
+        } catch( const std::exception &e ) {                                                    \
+            except_msg = e.what();                                                              \
+        }                                                                                       \
+        if ( !except_msg.empty() ) {                                                            \
+            Error( "{} threw an exception: {}", #func, except_msg );                            \
+            logDrmCtrlError();                                                                  \
+            logDrmCtrlTrngStatus();                                                             \
+            Throw( DRM_CtlrError, except_msg );                                                 \
+        }                                                                                       \
+        if ( LogEnabled( spdlog::level::debug ) )                                               \
+            Debug( "{} returned {}", #func, errcode );                                          \
+        if ( errcode ) {                                                                        \
+            logDrmCtrlError();                                                                  \
+            logDrmCtrlTrngStatus();                                                             \
+            Error( "{} failed with error code {}", #func, errcode );                            \
+            Throw( DRM_CtlrError, "{} failed with error code {}. ", #func, errcode );           \
+        }                                                                                       \
+    }
+
 
     Impl( const std::string& conf_file_path,
           const std::string& cred_file_path )
@@ -457,6 +621,20 @@ protected:
                 sLogFileRotatingNum = JVgetOptional( param_lib, "log_file_rotating_num",
                         Json::uintValue, (uint32_t)sLogFileRotatingNum ).asUInt();
 
+                // Asynchronous logging
+                sLogAsync = JVgetOptional(
+                        param_lib, "log_async", Json::booleanValue, sLogAsync ).asBool();
+                sLogAsyncQueueSize = JVgetOptional( param_lib, "log_async_queue_size",
+                        Json::uintValue, (uint32_t)sLogAsyncQueueSize ).asUInt();
+                uint32_t overflow = JVgetOptional( param_lib, "log_async_overflow",
+                        Json::uintValue, 0 ).asUInt();
+                if ( overflow > 1 )
+                    Throw( DRM_BadArg, "Invalid value for log_async_overflow: {}, must be 0 (block) or 1 (overrun oldest). ", overflow );
+                sLogAsyncOverflow = overflow ? spdlog::async_overflow_policy::overrun_oldest
+                                             : spdlog::async_overflow_policy::block;
+                if ( sLogAsyncQueueSize == 0 )
+                    Throw( DRM_BadArg, "Invalid value for log_async_queue_size: must be greater than 0. " );
+
                 // Software Controller logging
                 sLogCtrlVerbosity = static_cast<eCtrlLogVerbosity>( JVgetOptional(
                         param_lib, "log_ctrl_verbosity", Json::uintValue, (uint32_t)sLogCtrlVerbosity ).asUInt() );
@@ -474,6 +652,86 @@ protected:
                         Json::uintValue, mWSRetryPeriodShort).asUInt();
                 mWSApiRetryDuration = JVgetOptional( param_lib, "ws_api_retry_duration",
                         Json::uintValue, mWSApiRetryDuration).asUInt();
+                mLicenseRetryPolicy = RetryPolicy::fromJson( JVgetOptional( param_lib, "license_retry_policy",
+                        Json::objectValue ), "license_retry_policy" );
+                mHealthRetryPolicy = RetryPolicy::fromJson( JVgetOptional( param_lib, "health_retry_policy",
+                        Json::objectValue ), "health_retry_policy" );
+
+                // Request jitter
+                mLicenseRenewalJitter = JVgetOptional( param_lib, "license_renewal_jitter",
+                        Json::realValue, mLicenseRenewalJitter ).asDouble();
+                // The renewal delay is taken from the retry budget of the renewal: keep it small
+                if ( ( mLicenseRenewalJitter < 0 ) || ( mLicenseRenewalJitter > 0.1 ) )
+                    Throw( DRM_BadArg, "Invalid value for license_renewal_jitter: {}, must be in [0, 0.1]. ", mLicenseRenewalJitter );
+                mHealthPeriodJitter = JVgetOptional( param_lib, "health_period_jitter",
+                        Json::realValue, mHealthPeriodJitter ).asDouble();
+                if ( ( mHealthPeriodJitter < 0 ) || ( mHealthPeriodJitter > 0.5 ) )
+                    Throw( DRM_BadArg, "Invalid value for health_period_jitter: {}, must be in [0, 0.5]. ", mHealthPeriodJitter );
+
+                // Metering snapshot cache
+                mMeteringCachePeriod = JVgetOptional( param_lib, "metering_cache_period",
+                        Json::uintValue, mMeteringCachePeriod.load() ).asUInt();
+
+                // Status snapshot
+                mStatusCached = JVgetOptional( param_lib, "status_cached",
+                        Json::booleanValue, mStatusCached).asBool();
+
+                // Register accesses
+                mConcurrentRegisterAccess = JVgetOptional( param_lib, "concurrent_register_access",
+                        Json::booleanValue, mConcurrentRegisterAccess ).asBool();
+                mPageRegisterCached = JVgetOptional( param_lib, "page_register_cached",
+                        Json::booleanValue, mPageRegisterCached ).asBool();
+
+                // Register trace
+                uint32_t registerTraceSize = JVgetOptional( param_lib, "register_trace_size",
+                        Json::uintValue, 0 ).asUInt();
+                mRegisterTraceFile = JVgetOptional( param_lib, "register_trace_file",
+                        Json::stringValue, mRegisterTraceFile ).asString();
+                if ( registerTraceSize ) {
+                    mRegisterTrace.reset( new RegisterTrace( registerTraceSize ) );
+                    Debug( "Register trace enabled with {} entries", mRegisterTrace->capacity() );
+                }
+
+                // Runtime statistics
+                mMetricsEnabled = JVgetOptional( param_lib, "metrics",
+                        Json::booleanValue, mMetricsEnabled ).asBool();
+                mMetricsEndpoint = JVgetOptional( param_lib, "metrics_endpoint",
+                        Json::stringValue, mMetricsEndpoint ).asString();
+
+                // Deferred session close
+                mSessionSpoolDir = JVgetOptional( param_lib, "session_spool_dir",
+                        Json::stringValue, mSessionSpoolDir ).asString();
+
+                // Device profile
+                mDeviceProfilePath = JVgetOptional( param_lib, "device_profile_file",
+                        Json::stringValue, mDeviceProfilePath ).asString();
+
+                // Fast resume
+                mFastResume = JVgetOptional( param_lib, "fast_resume",
+                        Json::booleanValue, mFastResume ).asBool();
+
+                // Host-local daemon
+                mDaemonServerSocket = JVgetOptional( param_lib, "daemon_server_socket",
+                        Json::stringValue, mDaemonServerSocket ).asString();
+                mDaemonSocket = JVgetOptional( param_lib, "daemon_socket",
+                        Json::stringValue, mDaemonSocket ).asString();
+                if ( !mDaemonServerSocket.empty() && !mDaemonSocket.empty() )
+                    Throw( DRM_BadArg, "Parameters daemon_server_socket and daemon_socket cannot be both defined. " );
+                std::string daemon_socket_mode = JVgetOptional( param_lib, "daemon_socket_mode",
+                        Json::stringValue, fmt::format( "{:04o}", mDaemonSocketMode ) ).asString();
+                size_t mode_length = 0;
+                unsigned long socket_mode = 0;
+                try {
+                    socket_mode = std::stoul( daemon_socket_mode, &mode_length, 8 );
+                } catch( const std::exception& ) {}
+                if ( daemon_socket_mode.empty() || ( mode_length != daemon_socket_mode.size() ) || ( socket_mode > 0777 ) )
+                    Throw( DRM_BadArg, "Invalid value for parameter daemon_socket_mode: '{}'. Must be an octal file mode. ",
+                           daemon_socket_mode );
+                mDaemonSocketMode = (mode_t)socket_mode;
+                mDaemonTimeout = JVgetOptional( param_lib, "daemon_timeout",
+                        Json::uintValue, mDaemonTimeout ).asUInt();
+                if ( mDaemonTimeout == 0 )
+                    Throw( DRM_BadArg, "Invalid value for parameter daemon_timeout: must be greater than 0. " );
 
                 // Host and Card information
                 mHostDataVerbosity = static_cast<eHostDataVerbosity>( JVgetOptional(
@@ -537,8 +795,10 @@ protected:
             sinks.push_back( console_sink );
 
             sLogger = std::make_shared<spdlog::logger>( "drmlib_logger", sinks.begin(), sinks.end() );
-            sLogger->set_level( sLogConsoleVerbosity );
+            setLogLevel( sLogConsoleVerbosity );
             spdlog::set_default_logger( sLogger );
+            // Release the pool of a previous asynchronous logger: its destruction writes the pending messages
+            sLogThreadPool.reset();
         }
         catch( const spdlog::spdlog_ex& ex ) { //LCOV_EXCL_LINE
             std::cout << "Failed to initialize logging: " << ex.what() << std::endl; //LCOV_EXCL_LINE
@@ -574,22 +834,39 @@ protected:
         log_sink->set_level( level );
         sLogger->sinks().push_back( log_sink );
         if ( level < sLogger->level() )
-            sLogger->set_level( level );
+            setLogLevel( level );
         if ( type != eLogFileType::NONE )
             Debug( "Created log file '{}' of type {}, with verbosity {}", file_path, (int)type, (int)level );
     }
 
+    void createAsyncLog( const size_t queue_size, const spdlog::async_overflow_policy overflow ) {
+        std::shared_ptr<spdlog::details::thread_pool> pool = std::make_shared<spdlog::details::thread_pool>( queue_size, 1 );
+        auto async_logger = std::make_shared<spdlog::async_logger>( "drmlib_logger",
+                sLogger->sinks().begin(), sLogger->sinks().end(), pool, overflow );
+        async_logger->set_level( sLogger->level() );
+        // Errors are flushed as soon as they are written by the background thread
+        async_logger->flush_on( spdlog::level::err );
+        sLogThreadPool = pool;
+        sLogger = async_logger;
+        spdlog::set_default_logger( sLogger );
+        Debug( "Enabled asynchronous logging with a queue of {} messages, overflow policy {}", queue_size, (int)overflow );
+    }
+
     void updateLog() {
         try {
             auto console_sink = sLogger->sinks()[0];
             console_sink->set_level( sLogConsoleVerbosity );
             console_sink->set_pattern( sLogConsoleFormat );
             if ( sLogConsoleVerbosity < sLogger->level() )
-                sLogger->set_level( sLogConsoleVerbosity );
+                setLogLevel( sLogConsoleVerbosity );
 
             // File logging
             createFileLog( sLogFilePath, sLogFileType, sLogFileVerbosity, sLogFileFormat,
                     sLogFileRotatingSize, sLogFileRotatingNum, sLogFileAppend );
+
+            // Asynchronous logging: the same sinks are fed by a single background thread
+            if ( sLogAsync )
+                createAsyncLog( sLogAsyncQueueSize, sLogAsyncOverflow );
         }
         catch( const spdlog::spdlog_ex& ex ) {  //LCOV_EXCL_LINE
             std::cout << "Failed to update logging settings: " << ex.what() << std::endl; //LCOV_EXCL_LINE
@@ -622,6 +899,7 @@ protected:
     }
 
     void getDrmCtrlError( uint8_t& activation_error, uint8_t& dna_error, uint8_t& vlnv_error, uint8_t& license_error ) const {
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
         getDrmController().readActivationErrorRegister( activation_error );
         getDrmController().readExtractDnaErrorRegister( dna_error );
         getDrmController().readExtractVlnvErrorRegister( vlnv_error );
@@ -651,9 +929,28 @@ protected:
     }
 
     void logDrmCtrlTrngStatus() const {
+        auto drmMajor = ( mDrmVersionNum >> 16 ) & 0xFF;
+        auto drmMinor = ( mDrmVersionNum >> 8  ) & 0xFF;
+        if ( ( drmMajor < 4 ) || ( ( drmMajor == 4 ) && ( drmMinor < 2 ) ) ) {
+            Debug( "TRNG status bits are not supported in this HDK version." );
+            return;
+        }
         bool securityAlertBit( false );
-        uint32_t adaptiveProportionTestError, repetitionCountTestError;
-        getTrngStatus( securityAlertBit, adaptiveProportionTestError, repetitionCountTestError );
+        uint32_t adaptiveProportionTestError = 0, repetitionCountTestError = 0;
+        // Called by checkDRMCtlrRet on errors: ignore the register errors instead of calling
+        // checkDRMCtlrRet again, which would recurse endlessly when the register access is down
+        try {
+            std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
+            if ( getDrmController().readSecurityAlertStatusRegister( securityAlertBit )
+              || getDrmController().extractAdaptiveProportionTestFailures( adaptiveProportionTestError )
+              || getDrmController().extractRepetitionCountTestFailures( repetitionCountTestError ) ) {
+                Debug( "Could not read the Controller TRNG status" );
+                return;
+            }
+        } catch( const std::exception& e ) {
+            Debug( "Could not read the Controller TRNG status: {}", e.what() );
+            return;
+        }
         Debug( "Controller TRNG status: security alert bit = {}, adaptative proportion test error = {}, repetition count test error = {}",
                 securityAlertBit, adaptiveProportionTestError, repetitionCountTestError );
     }
@@ -860,6 +1157,14 @@ protected:
         settings["health_retry"] = mHealthRetryTimeout;
         settings["health_retry_sleep"] = mHealthRetrySleep;
         settings["ws_api_retry_duration"] = mWSApiRetryDuration;
+        if ( mLicenseRetryPolicy.enabled )
+            settings["license_retry_policy"] = mLicenseRetryPolicy.toJson();
+        if ( mHealthRetryPolicy.enabled )
+            settings["health_retry_policy"] = mHealthRetryPolicy.toJson();
+        if ( mLicenseRenewalJitter > 0 )
+            settings["license_renewal_jitter"] = mLicenseRenewalJitter;
+        if ( mHealthPeriodJitter > 0 )
+            settings["health_period_jitter"] = mHealthPeriodJitter;
         settings["host_data_verbosity"] = static_cast<uint32_t>( mHostDataVerbosity );
         settings["drm_ctrl_time_factor"] = mCtrlTimeFactor;
         settings["drm_ctrl_timeout_us"] = mCtrlTimeoutInUS;
@@ -869,14 +1174,17 @@ protected:
     }
 
     uint32_t getMailboxSize() const {
-        uint32_t roSize, rwSize;
-        checkDRMCtlrRet( getDrmController().readMailboxFileSizeRegister( roSize, rwSize ) );
+        uint32_t rwSize = getDesignInfo()->mailboxRwSize;
         Debug2( "Full mailbox size: {}", rwSize );
         return rwSize;
     }
 
     uint32_t getUserMailboxSize() const {
-        uint32_t mbSize = getMailboxSize() - (uint32_t)eMailboxOffset::MB_USER;
+        return getUserMailboxSize( getMailboxSize() );
+    }
+
+    uint32_t getUserMailboxSize( const uint32_t& mbFullSize ) const {
+        uint32_t mbSize = mbFullSize - (uint32_t)eMailboxOffset::MB_USER;
         auto drmMajor = ( mDrmVersionNum >> 16 ) & 0xFF;
         if ( (drmMajor <= 3) && (mbSize >= 4) )
             // Used to compensate the bug in the HDK that prevent any access to the highest addresses of the mailbox
@@ -938,7 +1246,7 @@ protected:
         uint32_t roSize, rwSize;
         std::vector<uint32_t> roData, rwData;
 
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
 
         checkDRMCtlrRet( getDrmController().readMailboxFileRegister( roSize, rwSize, roData, rwData) );
         if ( index >= rwData.size() )
@@ -964,7 +1272,7 @@ protected:
         const uint32_t* p_data = (uint32_t*)&data;
         std::vector<uint32_t> value_vec(p_data, p_data + nb_elements);
 
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
 
         checkDRMCtlrRet( getDrmController().readMailboxFileRegister( roSize, rwSize, roData, rwData) );
         if ( index >= rwData.size() )
@@ -989,21 +1297,25 @@ protected:
         Unreachable( "No Web Service has been defined. " ); //LCOV_EXCL_LINE
     }
 
-    static uint32_t getDrmRegisterOffset( const std::string& regName ) {
-        if ( regName == "DrmPageRegister" )
-            return 0;
-        if ( regName.substr( 0, 15 ) == "DrmRegisterLine" )
-            return (uint32_t)std::stoul( regName.substr( 15 ) ) * 4 + 4;
-        Unreachable( "Unsupported regName argument: {}. ", regName ); //LCOV_EXCL_LINE
-    }
-
+    // Register accesses take the shared lock: they are either part of a sequence already
+    // protected by the caller (exclusive or shared) or run before any thread is started.
+    // The callbacks are also serialized, unless their concurrent calls are allowed.
     unsigned int readDrmAddress( const uint32_t address, uint32_t& value ) const {
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        SharedLockGuard lock( mDrmControllerMutex );
+        std::unique_lock<std::mutex> callback_lock( mRegisterCallbackMutex, std::defer_lock );
+        if ( !mConcurrentRegisterAccess )
+            callback_lock.lock();
+        TClock::time_point start = mRegisterTrace ? TClock::now() : TClock::time_point();
         int ret = f_read_register( address, &value );
+        if ( mRegisterTrace )
+            mRegisterTrace->record( RegisterTrace::READ, mDrmPageCache, address, value, start, ret );
+        MetricInc( registerReads );
+        if ( ret )
+            MetricInc( registerErrors );
         if ( ret )
             Error( "Error in read register callback, errcode = {}: failed to read address {}", ret, address );
         else
-            Debug2( "Read DRM Ctrl address 0x{:x} = 0x{:08x}", address, value );
+            RegTrace( "Read DRM Ctrl address 0x{:x} = 0x{:08x}", address, value );
         return ret;
     }
 
@@ -1012,12 +1324,27 @@ protected:
     }
 
     unsigned int writeDrmAddress( const uint32_t address, uint32_t value ) const {
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        SharedLockGuard lock( mDrmControllerMutex );
+        if ( mPageRegisterCached && ( address == 0 ) && ( mDrmPageCache == value ) ) {
+            RegTrace( "DRM Ctrl page {} is already selected", value );
+            return 0;
+        }
+        std::unique_lock<std::mutex> callback_lock( mRegisterCallbackMutex, std::defer_lock );
+        if ( !mConcurrentRegisterAccess )
+            callback_lock.lock();
+        TClock::time_point start = mRegisterTrace ? TClock::now() : TClock::time_point();
         int ret = f_write_register( address, value );
+        if ( address == 0 )
+            mDrmPageCache = ret ? DRM_PAGE_UNKNOWN : value;
+        if ( mRegisterTrace )
+            mRegisterTrace->record( RegisterTrace::WRITE, mDrmPageCache, address, value, start, ret );
+        MetricInc( registerWrites );
+        if ( ret )
+            MetricInc( registerErrors );
         if ( ret )
             Error( "Error in write register callback, errcode = {}: failed to write {} to address {}", ret, value, address );
         else
-            Debug2( "Wrote DRM Ctrl address 0x{:x} = 0x{:08x}", address, value );
+            RegTrace( "Wrote DRM Ctrl address 0x{:x} = 0x{:08x}", address, value );
         return ret;
     }
 
@@ -1027,7 +1354,7 @@ protected:
 
     void lockDrmToInstance() {
         return;
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
         uint32_t isLocked = readMailbox<uint32_t>( eMailboxOffset::MB_LOCK_DRM );
         if ( isLocked )
             Throw( DRM_BadUsage, "Another instance of the DRM Manager is currently owning the HW. " );
@@ -1038,7 +1365,7 @@ protected:
 
     void unlockDrmToInstance() {
         return;
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
         if ( !mIsLockedToDrm )
             return;
         uint32_t isLocked = readMailbox<uint32_t>( eMailboxOffset::MB_LOCK_DRM );
@@ -1090,12 +1417,13 @@ protected:
      * This test write and read mailbox registers to verify the read and write callbacks are working correctly.
      */
     void runBistLevel2() const {
-        // Check mailbox size
-        uint32_t mb_full_size = getMailboxSize();
+        // Check mailbox size: read from the registers because the design information is not read yet
+        uint32_t mb_ro_size, mb_full_size;
+        checkDRMCtlrRet( getDrmController().readMailboxFileSizeRegister( mb_ro_size, mb_full_size ) );
         if ( mb_full_size < (uint32_t)eMailboxOffset::MB_USER ) {
             Throw( DRM_BadArg, "DRM Communication Self-Test 2 failed: Unexpected mailbox size {}: Must be > {}.\n{}", mb_full_size, eMailboxOffset::MB_USER, DRM_SELF_TEST_ERROR_MESSAGE ); //LCOV_EXCL_LINE
         }
-        uint32_t mbSize = getUserMailboxSize();
+        uint32_t mbSize = getUserMailboxSize( mb_full_size );
 
         // Check mailbox size
         uint32_t mbSizeMax = 0x8000;
@@ -1172,7 +1500,7 @@ protected:
         const char* ctrl_timeout = getenv( "DRM_CONTROLLER_TIMEOUT_IN_MICRO_SECONDS" );
         mCtrlTimeoutInUS = std::stoul(std::string(ctrl_timeout));
         Debug("DRM_CONTROLLER_TIMEOUT_IN_MICRO_SECONDS environment variable is {}", mCtrlTimeoutInUS);
-        mActivationTransmissionTimeoutMS = 20.0 * mCtrlTimeoutInUS;
+        mActivationTransmissionTimeoutMS = 20.0 * mCtrlTimeoutInUS / 1000.0;
 
         const char* ctrl_sleep = getenv( "DRM_CONTROLLER_SLEEP_IN_MICRO_SECONDS" );
         mCtrlSleepInUS = std::stoul(std::string(ctrl_sleep));
@@ -1209,16 +1537,40 @@ protected:
         // Run auto-test level 1
         runBistLevel1();
 
-        // Run auto-test of register accesses
-        runBistLevel2();
+        // A session with a valid license has been started on this device by a previous instance
+        mFastResumePending = mFastResume && !isConfigInNodeLock() && isSessionRunning() && isLicenseActive();
+        if ( mFastResumePending )
+            Debug( "A session is pending with a valid license: construction is reduced to resume it" );
+
+        // Compare the device with the profile saved by a previous instance
+        if ( restoreDeviceProfile( readDeviceProfile() ) ) {
+            // The register accesses have already been tested by a previous instance
+            Debug( "Device profile {} matches the DRM Controller: DRM Communication Self-Test 2 is skipped", mDeviceProfilePath );
+        } else if ( mFastResumePending ) {
+            // The register accesses have been tested by the instance that started the session
+            Debug( "DRM Communication Self-Test 2 is skipped" );
+        } else {
+            // Run auto-test of register accesses before reading the design information
+            runBistLevel2();
+        }
 
         // Determine frequency detection method if metering/floating mode is active
+        bool save_profile = mDeviceProfile.isNull();
         if ( !isConfigInNodeLock() ) {
             determineFrequencyDetectionMethod();
-            if ( mFreqDetectionMethod == 3 ) {
+            bool is_measured = !mBypassFrequencyDetection
+                    && ( ( mFreqDetectionMethod == 3 ) || ( mFreqDetectionMethod == 2 ) );
+            if ( is_measured && restoreDrmFrequency() ) {
+                Debug( "DRM frequency measured by a previous instance is used: {} MHz", mFrequencyCurr );
+            } else if ( is_measured && mFastResumePending ) {
+                // Measured before the next license request
+                mFrequencyDetectionPending = true;
+            } else if ( mFreqDetectionMethod == 3 ) {
                 detectDrmFrequencyMethod3();
+                save_profile = true;
             } else if ( mFreqDetectionMethod == 2 ) {
                 detectDrmFrequencyMethod2();
+                save_profile = true;
             } else if ( ( mFreqDetectionMethod == 1 ) || ( mFreqDetectionMethod == 0 ) ) {
             } else {
                 Warning( "DRM frequency auto-detection is disabled: {:0.1f} will be used to compute license timers", mFrequencyCurr );
@@ -1245,7 +1597,7 @@ protected:
                 Debug( "A floating/metering session is still pending: trying to close it gracefully before switching to nodelocked license." );
                 mHeaderJsonRequest["mode"] = (uint8_t)eLicenseType::METERED;
                 try {
-                    mWsClient.reset( new DrmWSClient( mConfFilePath, mCredFilePath ) );
+                    mWsClient.reset( new DrmWSClient( mConfFilePath, mCredFilePath, &mThreadExit ) );
                     stopSession();
                 } catch( const Exception& e ) {
                     Debug( "Failed to stop gracefully the pending session because: {}", e.what() );
@@ -1256,7 +1608,143 @@ protected:
             // Create license request file
             createNodelockedLicenseRequestFile();
         } else {
-            mWsClient.reset( new DrmWSClient( mConfFilePath, mCredFilePath ) );
+            mWsClient.reset( new DrmWSClient( mConfFilePath, mCredFilePath, &mThreadExit ) );
+        }
+
+        // Save the probing results for the next instances
+        if ( save_profile && !mFastResumePending )
+            saveDeviceProfile();
+    }
+
+    // Complete the initialization steps deferred to resume the pending session quickly
+    void completeDeferredInit() {
+        if ( mFrequencyDetectionPending ) {
+            if ( mFreqDetectionMethod == 3 )
+                detectDrmFrequencyMethod3();
+            else
+                detectDrmFrequencyMethod2();
+            mFrequencyDetectionPending = false;
+        }
+        if ( mHostDataPending ) {
+            getHostAndCardInfo();
+            mHostDataPending = false;
+        }
+    }
+
+    // Read the device profile file; return null if it is disabled, missing or not usable
+    Json::Value readDeviceProfile() const {
+        if ( mDeviceProfilePath.empty() || !isFile( mDeviceProfilePath ) )
+            return Json::nullValue;
+        try {
+            Json::Value profile = parseJsonFile( mDeviceProfilePath );
+            if ( JVgetRequired( profile, "drmlib_version", Json::stringValue ).asString() != DRMLIB_VERSION ) {
+                Debug( "Ignoring device profile {} saved by another DRM Library version", mDeviceProfilePath );
+                return Json::nullValue;
+            }
+            JVgetRequired( profile, "drm_version", Json::stringValue );
+            JVgetRequired( profile, "dna", Json::stringValue );
+            JVgetRequired( profile, "num_activators", Json::uintValue );
+            const Json::Value& mailbox_size = JVgetRequired( profile, "mailbox_size", Json::arrayValue );
+            if ( ( mailbox_size.size() != 2 ) || !mailbox_size[0].isUInt() || !mailbox_size[1].isUInt() )
+                Throw( DRM_BadFormat, "Value of parameter 'mailbox_size' shall be a list of 2 sizes" );
+            const Json::Value& design = JVgetRequired( profile, "design", Json::objectValue );
+            for( const Json::Value& vlnv: JVgetRequired( design, "vlnv_file", Json::arrayValue ) ) {
+                if ( !vlnv.isString() )
+                    Throw( DRM_BadFormat, "Value of parameter 'vlnv_file' shall be a list of strings" );
+            }
+            JVgetRequired( design, "mailbox_read_only", Json::stringValue );
+            const Json::Value& frequency = JVgetOptional( profile, "frequency", Json::objectValue );
+            if ( !frequency.isNull() ) {
+                JVgetRequired( frequency, "method", Json::uintValue );
+                JVgetRequired( frequency, "drm_aclk", Json::intValue );
+                JVgetRequired( frequency, "s_axi_aclk", Json::uintValue );
+            }
+            return profile;
+        } catch( const Exception& e ) {
+            Warning( "Ignoring invalid device profile {}: {}", mDeviceProfilePath, e.what() );
+        }
+        return Json::nullValue;
+    }
+
+    // Restore the design information from the profile if it has been saved for this device.
+    // Only the DRM Controller version and the DNA are read: the profile shall be removed when the
+    // FPGA is reprogrammed with another design.
+    bool restoreDeviceProfile( const Json::Value& profile ) {
+        if ( profile.isNull() )
+            return false;
+        std::string dna;
+        checkDRMCtlrRet( getDrmController().extractDna( dna ) );
+        if ( ( profile["drm_version"].asString() != getDrmCtrlVersion() ) || ( profile["dna"].asString() != dna ) ) {
+            Debug( "Device profile {} does not match the DRM Controller: the device is probed again", mDeviceProfilePath );
+            return false;
+        }
+        std::shared_ptr<DesignInfo> info = std::make_shared<DesignInfo>();
+        const Json::Value& design = profile["design"];
+        info->drmVersion = profile["drm_version"].asString();
+        info->dna = dna;
+        for( const Json::Value& vlnv: design["vlnv_file"] )
+            info->vlnvFile.push_back( vlnv.asString() );
+        info->mailboxReadOnly = design["mailbox_read_only"].asString();
+        info->numActivators = profile["num_activators"].asUInt();
+        info->mailboxRoSize = profile["mailbox_size"][0].asUInt();
+        info->mailboxRwSize = profile["mailbox_size"][1].asUInt();
+        try {
+            info->mailboxRoData = parseMailboxReadOnly( info->mailboxReadOnly );
+        } catch( const Exception& e ) {
+            Warning( "Ignoring invalid device profile {}: {}", mDeviceProfilePath, e.what() );
+            return false;
+        }
+        std::atomic_store( &mDesignInfo, std::shared_ptr<const DesignInfo>( info ) );
+        mDeviceProfile = profile;
+        return true;
+    }
+
+    // Restore the DRM frequency measured by the instance that saved the profile
+    bool restoreDrmFrequency() {
+        const Json::Value& frequency = mDeviceProfile["frequency"];
+        if ( frequency.isNull() || ( frequency["method"].asUInt() != mFreqDetectionMethod ) )
+            return false;
+        mAxiFrequency = frequency["s_axi_aclk"].asUInt();
+        checkDrmFrequency( frequency["drm_aclk"].asInt() );
+        return true;
+    }
+
+    void saveDeviceProfile() {
+        Json::Value profile;
+
+        if ( mDeviceProfilePath.empty() )
+            return;
+        try {
+            std::shared_ptr<const DesignInfo> info = getDesignInfo();
+
+            profile["drmlib_version"] = DRMLIB_VERSION;
+            profile["drm_version"] = info->drmVersion;
+            profile["dna"] = info->dna;
+            profile["num_activators"] = info->numActivators;
+            profile["mailbox_size"].append( info->mailboxRoSize );
+            profile["mailbox_size"].append( info->mailboxRwSize );
+            profile["design"]["vlnv_file"] = Json::arrayValue;
+            for( const std::string& vlnv: info->vlnvFile )
+                profile["design"]["vlnv_file"].append( vlnv );
+            profile["design"]["mailbox_read_only"] = info->mailboxReadOnly;
+            if ( !isConfigInNodeLock() && !mBypassFrequencyDetection && !mFrequencyDetectionPending
+                    && ( ( mFreqDetectionMethod == 3 ) || ( mFreqDetectionMethod == 2 ) ) ) {
+                profile["frequency"]["method"] = mFreqDetectionMethod;
+                profile["frequency"]["drm_aclk"] = (int32_t)mFrequencyCurr;
+                profile["frequency"]["s_axi_aclk"] = mAxiFrequency;
+            }
+
+            // Replace the file atomically so that concurrent instances never read a partial profile
+            std::string tmp_path = fmt::format( "{}.{}.tmp", mDeviceProfilePath, getpid() );
+            saveJsonToFile( tmp_path, profile );
+            if ( rename( tmp_path.c_str(), mDeviceProfilePath.c_str() ) ) {
+                int err = errno;
+                remove( tmp_path.c_str() );
+                Throw( DRM_ExternFail, "Unable to write file {}: {}", mDeviceProfilePath, strerror( err ) );
+            }
+            Debug( "Saved device profile in {}", mDeviceProfilePath );
+        } catch( const Exception& e ) {
+            Warning( "Failed to save the device profile: {}", e.what() );
         }
     }
 
@@ -1286,7 +1774,7 @@ protected:
     }
 
     void getNumActivator( uint32_t& value ) const {
-        checkDRMCtlrRet( getDrmController().readNumberOfDetectedIpsStatusRegister( value ) );
+        value = getDesignInfo()->numActivators;
     }
 
     uint64_t getTimerCounterValue() const {
@@ -1302,7 +1790,7 @@ protected:
 
     std::string getDrmPage( uint32_t page_index ) const {
         uint32_t value;
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
         writeDrmRegister( "DrmPageRegister", page_index );
         std::string str = fmt::format( "DRM Page {}  registry:\n", page_index );
         for( uint32_t r=0; r < NB_MAX_REGISTER; r++ ) {
@@ -1312,27 +1800,42 @@ protected:
         return str;
     }
 
+    // Dump the register trace in a file; errors are logged but not thrown when called on an error path
+    void dumpRegisterTrace( const std::string& file_path, bool throw_error = true ) const {
+        if ( !mRegisterTrace ) {
+            if ( throw_error )
+                Throw( DRM_BadUsage, "Register trace is disabled: set 'register_trace_size' in the configuration file. " );
+            return;
+        }
+        try {
+            size_t count = mRegisterTrace->dump( file_path, mDrmVersionNum );
+            Info( "Dumped {} register accesses in {}", count, file_path );
+        } catch( const Exception& e ) {
+            if ( throw_error )
+                throw;
+            Warning( "Failed to dump the register trace: {}", e.what() );
+        }
+    }
+
     std::string getDrmReport() const {
         std::stringstream ss;
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
         getDrmController().printHwReport( ss );
         return ss.str();
     }
 
     Json::Value getMeteringHeader() {
         Json::Value json_output;
-        std::string drmVersion;
-        std::string dna;
-        std::vector<std::string> vlnvFile;
-        std::string mailboxReadOnly;
 
         // Get information from DRM Controller
-        getDesignInfo( drmVersion, dna, vlnvFile, mailboxReadOnly );
+        std::shared_ptr<const DesignInfo> info = getDesignInfo();
+        const std::vector<std::string>& vlnvFile = info->vlnvFile;
+        const Json::Value& mailboxRoData = info->mailboxRoData;
 
         // Fulfill application section
         if ( !mUDID.empty() )
             json_output["udid"] = mUDID;
-        else if ( mailboxReadOnly.empty() )
+        else if ( info->mailboxReadOnly.empty() )
             Throw( DRM_BadArg, "UDID and Product ID cannot be both missing" );
         if ( !mBoardType.empty() )
             json_output["boardType"] = mBoardType;
@@ -1342,8 +1845,8 @@ protected:
 
         // Fulfill with DRM section
         json_output["drmlibVersion"] = DRMLIB_VERSION;
-        json_output["lgdnVersion"] = drmVersion;
-        json_output["dna"] = dna;
+        json_output["lgdnVersion"] = info->drmVersion;
+        json_output["dna"] = info->dna;
         for ( uint32_t i = 0; i < vlnvFile.size(); i++ ) {
             std::string i_str = std::to_string(i);
             json_output["vlnvFile"][i_str]["vendor"] = std::string("x") + vlnvFile[i].substr(0, 4);
@@ -1353,29 +1856,22 @@ protected:
         }
 
         // Fulfill with product information
-        if ( !mailboxReadOnly.empty() ) {
-            try {
-                mMailboxRoData = parseJsonString( mailboxReadOnly );
-                if ( mMailboxRoData.isMember( "product_id" ) )
-                    json_output["product"] = mMailboxRoData["product_id"];
-                else
-                    json_output["product"] = mMailboxRoData;
-                if ( mMailboxRoData.isMember( "pkg_version" ) ) {
-                    json_output["pkg_version"] = mMailboxRoData["pkg_version"];
-                    Debug( "HDK Generator version: {}", json_output["pkg_version"].asString() );
-                }
-                if ( mMailboxRoData.isMember( "dna_type" ) ) {
-                    json_output["dna_type"] = mMailboxRoData["dna_type"];
-                    Debug( "HDK DNA type: {}", json_output["dna_type"].asString() );
-                }
-                if ( mMailboxRoData.isMember( "extra" ) ) {
-                    json_output["extra"] = mMailboxRoData["extra"];
-                    Debug( "HDK extra data: {}", json_output["extra"].toStyledString() );
-                }
-            } catch( const Exception &e ) {
-                if ( e.getErrCode() == DRM_BadFormat )
-                    Throw( DRM_BadFormat, "Failed to parse Read-Only Mailbox in DRM Controller: {}", e.what() );
-                throw;
+        if ( !mailboxRoData.isNull() ) {
+            if ( mailboxRoData.isMember( "product_id" ) )
+                json_output["product"] = mailboxRoData["product_id"];
+            else
+                json_output["product"] = mailboxRoData;
+            if ( mailboxRoData.isMember( "pkg_version" ) ) {
+                json_output["pkg_version"] = mailboxRoData["pkg_version"];
+                Debug( "HDK Generator version: {}", json_output["pkg_version"].asString() );
+            }
+            if ( mailboxRoData.isMember( "dna_type" ) ) {
+                json_output["dna_type"] = mailboxRoData["dna_type"];
+                Debug( "HDK DNA type: {}", json_output["dna_type"].asString() );
+            }
+            if ( mailboxRoData.isMember( "extra" ) ) {
+                json_output["extra"] = mailboxRoData["extra"];
+                Debug( "HDK extra data: {}", json_output["extra"].toStyledString() );
             }
         }
 
@@ -1451,6 +1947,7 @@ protected:
         checkDRMCtlrRet( getDrmController().waitNotTimerInitLoaded( timeout ) );
         // Request challenge and metering info for new request
         checkDRMCtlrRet( getDrmController().synchronousExtractMeteringFile( numberOfDetectedIps, saasChallenge, meteringFile ) );
+        publishMeteringSnapshot( meteringFile );
         json_request["saasChallenge"] = saasChallenge;
         json_request["sessionId"] = meteringFile[0].substr( 0, 16 );
         checkSessionIDFromDRM( json_request );
@@ -1496,10 +1993,11 @@ protected:
 
             Debug( "Build health request #{}", mHealthCounter );
             {
-                std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+                std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
                 if ( isConfigInNodeLock() || isSessionRunning() ) {
                     checkDRMCtlrRet( getDrmController().asynchronousExtractMeteringFile(
                             numberOfDetectedIps, saasChallenge, meteringFile ) );
+                    publishMeteringSnapshot( meteringFile );
                 } else {
                     Warning( "Cannot access metering data when no session is running" );
                 }
@@ -1521,54 +2019,150 @@ protected:
         return json_request;
     }
 
-    // Get common info
-    void getDesignInfo( std::string &drmVersion,
-                        std::string &dna,
-                        std::vector<std::string> &vlnvFile,
-                        std::string &mailboxReadOnly ) {
-        uint32_t nbOfDetectedIps;
-        uint32_t readOnlyMailboxSize, readWriteMailboxSize;
-        std::vector<uint32_t> readOnlyMailboxData, readWriteMailboxData;
+    // Decode the per-activator counters of a metering file.
+    // Metering file lines: 2 header lines, 1 line per activator and 1 MAC line.
+    // Each activator line is made of a 64-bit IP index followed by a 64-bit counter.
+    void decodeMeteringCounters( const std::vector<std::string>& meteringFile,
+                                 std::vector<uint64_t>& counts ) const {
+        counts.clear();
+        if ( meteringFile.size() < 3 )
+            return;
+        counts.reserve( meteringFile.size() - 3 );
+        for( auto it = meteringFile.begin() + 2; it != meteringFile.end() - 1; it++ )
+            counts.push_back( ( it->size() > 16 ) ? strtoull( it->c_str() + 16, nullptr, 16 ) : 0 );
+    }
 
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
-        checkDRMCtlrRet( getDrmController().extractDrmVersion( drmVersion ) );
-        checkDRMCtlrRet( getDrmController().extractDna( dna ) );
-        checkDRMCtlrRet( getDrmController().extractVlnvFile( nbOfDetectedIps, vlnvFile ) );
-        Debug( "Number of detected activators: {}", nbOfDetectedIps );
-        checkDRMCtlrRet( getDrmController().readMailboxFileRegister( readOnlyMailboxSize, readWriteMailboxSize,
-                                                                     readOnlyMailboxData, readWriteMailboxData ) );
-        Debug( "Mailbox sizes: read-only={}, read-write={}", readOnlyMailboxSize, readWriteMailboxSize );
-        readOnlyMailboxData.push_back( 0 );
-        mailboxReadOnly = std::string( (char*)readOnlyMailboxData.data() );
+    std::shared_ptr<const MeteringSnapshot> publishMeteringSnapshot( const std::vector<std::string>& meteringFile ) const {
+        std::shared_ptr<MeteringSnapshot> snapshot = std::make_shared<MeteringSnapshot>();
+        snapshot->timestamp = TClock::now();
+        decodeMeteringCounters( meteringFile, snapshot->counts );
+        std::shared_ptr<const MeteringSnapshot> published( snapshot );
+        std::atomic_store( &mMeteringSnapshot, published );
+        return published;
+    }
+
+    void clearMeteringSnapshot() {
+        std::atomic_store( &mMeteringSnapshot, std::shared_ptr<const MeteringSnapshot>() );
+    }
+
+    // Extract the metering file and publish its counters as the new snapshot.
+    // Unlike getMeteringHealth, no request is built and the health counter is left untouched.
+    // The metering access mutex is held by the licensing thread during the Web Service requests:
+    // if it is busy, the last snapshot is returned instead of waiting for the request.
+    std::shared_ptr<const MeteringSnapshot> refreshMeteringSnapshot() const {
+        uint32_t numberOfDetectedIps = 0;
+        std::string saasChallenge;
+        std::vector<std::string> meteringFile;
+        // A snapshot within the cache period is returned by getMeteringSnapshot without calling this function:
+        // an outdated one is never returned, so the refresh waits for the license request in progress
+        std::lock_guard<std::mutex> lockMetering( mMeteringAccessMutex );
+        {
+            std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
+            if ( isConfigInNodeLock() || isSessionRunning() ) {
+                checkDRMCtlrRet( getDrmController().asynchronousExtractMeteringFile(
+                        numberOfDetectedIps, saasChallenge, meteringFile ) );
+            } else {
+                Debug( "Cannot access metering data when no session is running" );
+            }
+        }
+        return publishMeteringSnapshot( meteringFile );
+    }
+
+    // Return the latest metering snapshot, refreshed if older than mMeteringCachePeriod.
+    // A fresh snapshot is returned without taking any lock; concurrent readers of
+    // an outdated snapshot wait for a single refresh.
+    std::shared_ptr<const MeteringSnapshot> getMeteringSnapshot() const {
+        uint32_t cache_period = mMeteringCachePeriod;
+        if ( cache_period == 0 )
+            return refreshMeteringSnapshot();
+        TClock::duration max_age = std::chrono::milliseconds( cache_period );
+        std::shared_ptr<const MeteringSnapshot> snapshot = std::atomic_load( &mMeteringSnapshot );
+        if ( snapshot && ( TClock::now() - snapshot->timestamp < max_age ) )
+            return snapshot;
+        std::lock_guard<std::mutex> lock( mMeteringSnapshotMutex );
+        // Another reader may have refreshed the snapshot meanwhile
+        snapshot = std::atomic_load( &mMeteringSnapshot );
+        if ( snapshot && ( TClock::now() - snapshot->timestamp < max_age ) )
+            return snapshot;
+        return refreshMeteringSnapshot();
+    }
+
+    uint32_t readMetering( uint64_t* counts, size_t n ) const {
+        std::shared_ptr<const MeteringSnapshot> snapshot = getMeteringSnapshot();
+        uint32_t nb_ips = (uint32_t)snapshot->counts.size();
+        std::copy_n( snapshot->counts.begin(), std::min( (size_t)nb_ips, n ), counts );
+        Debug2( "Read metering of {} activators", nb_ips );
+        return nb_ips;
+    }
+
+    static Json::Value parseMailboxReadOnly( const std::string& mailboxReadOnly ) {
         if ( mailboxReadOnly.empty() ) {
             Debug( "Could not find Product ID information in DRM Controller Memory" );
+            return Json::nullValue;
+        }
+        try {
+            return parseJsonString( mailboxReadOnly );
+        } catch( const Exception &e ) {
+            if ( e.getErrCode() == DRM_BadFormat )
+                Throw( DRM_BadFormat, "Failed to parse Read-Only Mailbox in DRM Controller: {}", e.what() );
+            throw;
         }
     }
 
+    // Return the design information; the DRM Controller is accessed only the first time
+    std::shared_ptr<const DesignInfo> getDesignInfo() const {
+        std::shared_ptr<const DesignInfo> published = std::atomic_load( &mDesignInfo );
+        if ( published )
+            return published;
+
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
+        published = std::atomic_load( &mDesignInfo );
+        if ( published )
+            return published;   // Read by another thread in the meantime
+
+        std::shared_ptr<DesignInfo> info = std::make_shared<DesignInfo>();
+        std::vector<uint32_t> readOnlyMailboxData, readWriteMailboxData;
+        checkDRMCtlrRet( getDrmController().extractDrmVersion( info->drmVersion ) );
+        checkDRMCtlrRet( getDrmController().extractDna( info->dna ) );
+        checkDRMCtlrRet( getDrmController().extractVlnvFile( info->numActivators, info->vlnvFile ) );
+        checkDRMCtlrRet( getDrmController().readMailboxFileRegister( info->mailboxRoSize, info->mailboxRwSize,
+                                                                     readOnlyMailboxData, readWriteMailboxData ) );
+        readOnlyMailboxData.push_back( 0 );
+        info->mailboxReadOnly = std::string( (char*)readOnlyMailboxData.data() );
+        Debug( "Number of detected activators: {}", info->numActivators );
+        Debug( "Mailbox sizes: read-only={}, read-write={}", info->mailboxRoSize, info->mailboxRwSize );
+
+        info->mailboxRoData = parseMailboxReadOnly( info->mailboxReadOnly );
+
+        published = info;
+        std::atomic_store( &mDesignInfo, published );
+        return published;
+    }
+
     bool isSessionRunning()const  {
         bool sessionRunning( false );
-        checkDRMCtlrRet( getDrmController().readSessionRunningStatusRegister( sessionRunning ) );
+        checkDRMCtlrRetShared( getDrmController().readSessionRunningStatusRegister( sessionRunning ) );
         Debug( "DRM session running state: {}", sessionRunning );
         return sessionRunning;
     }
 
     bool isDrmCtrlInNodelock()const  {
         bool isNodelocked( false );
-        checkDRMCtlrRet( getDrmController().readLicenseNodeLockStatusRegister( isNodelocked ) );
+        checkDRMCtlrRetShared( getDrmController().readLicenseNodeLockStatusRegister( isNodelocked ) );
         Debug( "DRM Controller node-locked status: {}", isNodelocked );
         return isNodelocked;
     }
 
     bool isDrmCtrlInMetering()const  {
         bool isMetering( false );
-        checkDRMCtlrRet( getDrmController().readLicenseMeteringStatusRegister( isMetering ) );
+        checkDRMCtlrRetShared( getDrmController().readLicenseMeteringStatusRegister( isMetering ) );
         Debug( "DRM Controller metering status: {}", isMetering );
         return isMetering;
     }
 
     bool isReadyForNewLicense() const {
         uint32_t numberOfLicenseTimerLoaded;
-        checkDRMCtlrRet( getDrmController().readNumberOfLicenseTimerLoadedStatusRegister(
+        checkDRMCtlrRetShared( getDrmController().readNumberOfLicenseTimerLoadedStatusRegister(
                     numberOfLicenseTimerLoaded ) );
         bool readiness = ( numberOfLicenseTimerLoaded < 2 );
         Debug( "DRM readiness to receive a new license: {} (# loaded licenses = {})", readiness, numberOfLicenseTimerLoaded );
@@ -1577,10 +2171,62 @@ protected:
 
     bool isLicenseActive() const {
         bool isLicenseEmpty( false );
-        checkDRMCtlrRet( getDrmController().readLicenseTimerCountEmptyStatusRegister( isLicenseEmpty ) );
+        checkDRMCtlrRetShared( getDrmController().readLicenseTimerCountEmptyStatusRegister( isLicenseEmpty ) );
         return !isLicenseEmpty;
     }
 
+    uint32_t getNumLicenseLoaded() const {
+        uint32_t numberOfLicenseTimerLoaded;
+        checkDRMCtlrRetShared( getDrmController().readNumberOfLicenseTimerLoadedStatusRegister(
+                    numberOfLicenseTimerLoaded ) );
+        return numberOfLicenseTimerLoaded;
+    }
+
+    eLicenseType getDrmCtrlLicenseType() const {
+        if ( isDrmCtrlInMetering() )
+            return eLicenseType::METERED;
+        if ( isDrmCtrlInNodelock() )
+            return eLicenseType::NODE_LOCKED;
+        return eLicenseType::NONE;
+    }
+
+    // Read the status registers and publish them as a new status snapshot
+    std::shared_ptr<const StatusSnapshot> publishStatusSnapshot() const {
+        // The registers are read without holding any lock, because a failing read logs the DRM Controller
+        // errors under the exclusive lock. The version is reserved before the reads: a snapshot is discarded
+        // if a snapshot read after it has already been published, so it never replaces a more recent one.
+        std::shared_ptr<StatusSnapshot> snapshot = std::make_shared<StatusSnapshot>();
+        snapshot->version = ++mStatusVersion;
+        snapshot->sessionRunning = isSessionRunning();
+        snapshot->licenseActive = isLicenseActive();
+        snapshot->numLicenseLoaded = getNumLicenseLoaded();
+        snapshot->drmLicenseType = getDrmCtrlLicenseType();
+        snapshot->licenseDuration = mLicenseDuration;
+        snapshot->expirationTime = mExpirationTime;
+        snapshot->timestamp = TClock::now();
+        std::shared_ptr<const StatusSnapshot> published( snapshot );
+
+        std::lock_guard<std::mutex> lock( mStatusPublishMutex );
+        std::shared_ptr<const StatusSnapshot> current = std::atomic_load( &mStatusSnapshot );
+        if ( current && ( current->version > snapshot->version ) ) {
+            Debug( "Discarded status snapshot #{}: snapshot #{} is more recent", snapshot->version, current->version );
+            return current;
+        }
+        std::atomic_store( &mStatusSnapshot, published );
+        Debug( "Published status snapshot #{}", snapshot->version );
+        return published;
+    }
+
+    // Return the latest status snapshot; the DRM Controller is accessed only if none was published yet,
+    // or if the license of the snapshot has expired since its publication
+    std::shared_ptr<const StatusSnapshot> getStatusSnapshot() const {
+        std::shared_ptr<const StatusSnapshot> snapshot = std::atomic_load( &mStatusSnapshot );
+        if ( snapshot && !( snapshot->licenseActive && ( snapshot->expirationTime.time_since_epoch().count() != 0 )
+                && ( TClock::now() >= snapshot->expirationTime ) ) )
+            return snapshot;
+        return publishStatusSnapshot();
+    }
+
     Json::Value getLicense( Json::Value& request_json, const uint32_t& timeout_ms,
                             int32_t short_retry_period_ms = -1, int32_t long_retry_period_ms = -1 ) {
         TClock::time_point deadline;
@@ -1596,9 +2242,24 @@ protected:
 
     Json::Value getLicense( Json::Value& request_json, const TClock::time_point& deadline,
                         int32_t short_retry_period_ms = -1, int32_t long_retry_period_ms = -1 ) {
+        MetricTimer metric_timer( Metrics::instance().licenseRequestDuration );
+        try {
+            return requestLicenseWithRetry( request_json, deadline, short_retry_period_ms, long_retry_period_ms );
+        } catch( const Exception& e ) {
+            // An exit request is not a failure of the Web Service
+            if ( e.getErrCode() != DRM_Exit )
+                MetricInc( licenseRequestErrors );
+            throw;
+        }
+    }
+
+    Json::Value requestLicenseWithRetry( Json::Value& request_json, const TClock::time_point& deadline,
+                        int32_t short_retry_period_ms, int32_t long_retry_period_ms ) {
         TClock::duration wait_duration;
         TClock::duration long_duration = std::chrono::milliseconds( long_retry_period_ms );
         TClock::duration short_duration = std::chrono::milliseconds( short_retry_period_ms );
+        RetryBackoff backoff( mLicenseRetryPolicy );
+        int32_t retry_after_ms = -1;
         bool token_valid(false);
         uint32_t oauth_attempt = 0;
         uint32_t lic_attempt = 0;
@@ -1612,7 +2273,7 @@ protected:
                 timeout_chrono = std::chrono::duration_cast<std::chrono::milliseconds>(
                                  deadline - TClock::now() );
                 timeout_msec = timeout_chrono.count();
-                getDrmWSClient().requestOAuth2token( timeout_msec );
+                getDrmWSClient().requestOAuth2token( timeout_msec, &retry_after_ms );
                 token_valid = true;
             } catch ( const Exception& e ) {
                 lic_attempt = 0;
@@ -1625,19 +2286,22 @@ protected:
                 }
                 // It is retryable
                 oauth_attempt ++;
+                MetricInc( licenseRequestRetries );
                 if ( short_retry_period_ms == -1 ) {
                     // No retry
                     Debug( "OAuthentication retry mechanism is disabled" );
                     throw;
                 }
-                if ( long_retry_period_ms == -1 )
+                if ( mLicenseRetryPolicy.enabled )
+                    wait_duration = backoff.next( deadline, retry_after_ms );
+                else if ( long_retry_period_ms == -1 )
                      wait_duration = short_duration;
                 else if ( ( deadline - TClock::now() ) <= ( long_duration + 2*short_duration )  )
                     wait_duration = short_duration;
                 else
                     wait_duration = long_duration;
-                Warning( "Attempt #{} to obtain a new OAuth2 token failed with message: {}. New attempt planned in {} seconds",
-                        oauth_attempt, e.what(), wait_duration.count()/1000000000 );
+                Warning( "Attempt #{} to obtain a new OAuth2 token failed with message: {}. New attempt planned in {:.1f} seconds",
+                        oauth_attempt, e.what(), std::chrono::duration<double>( wait_duration ).count() );
                 // Wait a bit before retrying
                 sleepOrExit( wait_duration );
             }
@@ -1654,7 +2318,7 @@ protected:
                 timeout_chrono = std::chrono::duration_cast<std::chrono::milliseconds>(
                                  deadline - TClock::now() );
                 timeout_msec = timeout_chrono.count();
-                return getDrmWSClient().requestLicense( request_json, timeout_msec );
+                return getDrmWSClient().requestLicense( request_json, timeout_msec, &retry_after_ms );
             } catch ( const Exception& e ) {
                 oauth_attempt = 0;
                 if ( e.getErrCode() == DRM_WSTimedOut ) {
@@ -1666,20 +2330,23 @@ protected:
                 }
                 // It is retryable
                 lic_attempt ++;
+                MetricInc( licenseRequestRetries );
                 if ( short_retry_period_ms == -1 ) {
                     // No retry
                     Debug( "Licensing retry mechanism is disabled" );
                     throw;
                 }
                 // Evaluate the next retry
-                if ( long_retry_period_ms == -1 )
+                if ( mLicenseRetryPolicy.enabled )
+                    wait_duration = backoff.next( deadline, retry_after_ms );
+                else if ( long_retry_period_ms == -1 )
                      wait_duration = short_duration;
                 else if ( ( deadline - TClock::now() ) <= ( long_duration + 2*short_duration ) )
                     wait_duration = short_duration;
                 else
                     wait_duration = long_duration;
-                Warning( "Attempt #{} to obtain a new License failed with message: {}. New attempt planned in {} seconds",
-                        lic_attempt, e.what(), wait_duration.count()/1000000000 );
+                Warning( "Attempt #{} to obtain a new License failed with message: {}. New attempt planned in {:.1f} seconds",
+                        lic_attempt, e.what(), std::chrono::duration<double>( wait_duration ).count() );
                 // Wait a bit before retrying
                 sleepOrExit( wait_duration );
             }
@@ -1687,6 +2354,7 @@ protected:
     }
 
     void setLicense( const Json::Value& license_json ) {
+        MetricTimer metric_timer( Metrics::instance().setLicenseDuration );
 
         Debug( "Provisioning license #{} on DRM controller", mLicenseCounter );
 
@@ -1721,7 +2389,7 @@ protected:
             Throw( DRM_WSRespError, "Malformed response from License Web Service: {}", e.what() );
         }
 
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
 
         if ( mLicenseCounter == 0 ) {
             // Load key
@@ -1756,14 +2424,35 @@ protected:
 
         Debug( "Provisioned license #{} for session {} on DRM controller", mLicenseCounter, mSessionID );
         mLicenseCounter ++;
+        MetricInc( licensesLoaded );
+        publishStatusSnapshot();
     }
 
     Json::Value postHealth( const Json::Value& request_json, const TClock::time_point& deadline,
                             const int32_t& retry_period_ms = -1 ) {
+        MetricTimer metric_timer( Metrics::instance().healthRequestDuration );
+        Json::Value response;
+        try {
+            response = requestHealthWithRetry( request_json, deadline, retry_period_ms );
+        } catch( const Exception& e ) {
+            if ( e.getErrCode() != DRM_Exit )
+                MetricInc( healthRequestErrors );
+            throw;
+        }
+        // The health request failures are reported with a null response
+        if ( response.isNull() )
+            MetricInc( healthRequestErrors );
+        return response;
+    }
+
+    Json::Value requestHealthWithRetry( const Json::Value& request_json, const TClock::time_point& deadline,
+                            const int32_t& retry_period_ms ) {
         bool token_valid(false);
         uint32_t oauth_attempt = 0;
         uint32_t lic_attempt = 0;
         TClock::duration retry_duration = std::chrono::milliseconds( retry_period_ms );
+        RetryBackoff backoff( mHealthRetryPolicy );
+        int32_t retry_after_ms = -1;
         int32_t timeout_msec;
         std::chrono::milliseconds timeout_chrono;
 
@@ -1774,10 +2463,12 @@ protected:
                 timeout_chrono = std::chrono::duration_cast<std::chrono::milliseconds>(
                                  deadline - TClock::now() );
                 timeout_msec = timeout_chrono.count();
-                getDrmWSClient().requestOAuth2token( timeout_msec );
+                getDrmWSClient().requestOAuth2token( timeout_msec, &retry_after_ms );
                 token_valid = true;
             } catch ( const Exception& e ) {
                 lic_attempt = 0;
+                if ( e.getErrCode() == DRM_Exit )
+                    throw;
                 if ( e.getErrCode() == DRM_WSTimedOut ) {
                     // Reached timeout
                     Warning( "Timeout on Authentication request after {} attempts", oauth_attempt );
@@ -1789,13 +2480,16 @@ protected:
                 }
                 // It is retryable
                 oauth_attempt ++;
+                MetricInc( healthRequestRetries );
                 if ( retry_period_ms == -1 ) {
                     // No retry
                     Debug( "OAuthentication retry mechanism is disabled" );
                     return Json::nullValue;
                 }
-                Warning( "Attempt #{} to obtain a new OAuth2 token failed with message: {}. New attempt planned in {} seconds",
-                        oauth_attempt, e.what(), retry_duration.count()/1000000000 );
+                if ( mHealthRetryPolicy.enabled )
+                    retry_duration = backoff.next( deadline, retry_after_ms );
+                Warning( "Attempt #{} to obtain a new OAuth2 token failed with message: {}. New attempt planned in {:.1f} seconds",
+                        oauth_attempt, e.what(), std::chrono::duration<double>( retry_duration ).count() );
                 // Wait a bit before retrying
                 sleepOrExit( retry_duration );
             }
@@ -1806,9 +2500,11 @@ protected:
                 timeout_chrono = std::chrono::duration_cast<std::chrono::milliseconds>(
                                  deadline - TClock::now() );
                 timeout_msec = timeout_chrono.count();
-                return getDrmWSClient().requestHealth( request_json, timeout_msec );
+                return getDrmWSClient().requestHealth( request_json, timeout_msec, &retry_after_ms );
             } catch ( const Exception& e ) {
                 oauth_attempt = 0;
+                if ( e.getErrCode() == DRM_Exit )
+                    throw;
                 if ( e.getErrCode() == DRM_WSTimedOut ) {
                     // Reached timeout
                     Warning( "Timeout on Health request after {} attempts", lic_attempt );
@@ -1820,14 +2516,17 @@ protected:
                 }
                 // It is retryable
                 lic_attempt ++;
+                MetricInc( healthRequestRetries );
                 if ( retry_period_ms == -1 ) {
                     // No retry
                     Debug( "Health retry mechanism is disabled" );
                     return Json::nullValue;
                 }
                 // Perform retry
-                Warning( "Attempt #{} to send a new Health request failed with message: {}. New attempt planned in {} seconds",
-                        lic_attempt, e.what(), retry_duration.count()/1000000000 );
+                if ( mHealthRetryPolicy.enabled )
+                    retry_duration = backoff.next( deadline, retry_after_ms );
+                Warning( "Attempt #{} to send a new Health request failed with message: {}. New attempt planned in {:.1f} seconds",
+                        lic_attempt, e.what(), std::chrono::duration<double>( retry_duration ).count() );
                 // Wait a bit before retrying
                 sleepOrExit( retry_duration );
             }
@@ -1847,16 +2546,18 @@ protected:
         return postHealth( request_json, retry_deadline, retry_sleep_ms );
     }
 
-    std::string getDesignHash() {
-        std::string drmVersion, dna, mailboxReadOnly;
-        std::vector<std::string> vlnvFile;
+    static std::string hashDesign( const std::string& drmVersion, const std::string& dna,
+                                   const std::vector<std::string>& vlnvFile ) {
         std::hash<std::string> hasher;
-
-        getDesignInfo( drmVersion, dna, vlnvFile, mailboxReadOnly );
         std::string design = dna + drmVersion;
         for( const std::string& vlnv: vlnvFile )
             design += vlnv;
-        std::string hash = fmt::format( "{:016X}", hasher( design ) );
+        return fmt::format( "{:016X}", hasher( design ) );
+    }
+
+    std::string getDesignHash() {
+        std::shared_ptr<const DesignInfo> info = getDesignInfo();
+        std::string hash = hashDesign( info->drmVersion, info->dna, info->vlnvFile );
         Debug( "Hash for HW design is {}", hash );
         return hash;
     }
@@ -1906,7 +2607,7 @@ protected:
             mSessionID = std::string("");
             writeMailbox<uint64_t>( eMailboxOffset::MB_SESSION_0, 0 );
             /// - Create WS access
-            mWsClient.reset( new DrmWSClient( mConfFilePath, mCredFilePath ) );
+            mWsClient.reset( new DrmWSClient( mConfFilePath, mCredFilePath, &mThreadExit ) );
             /// - Read request file
             try {
                 Json::Value request_json = parseJsonFile( mNodeLockRequestFilePath );
@@ -1986,7 +2687,7 @@ protected:
             return;
         }
 
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
 
         // Reset detection counter by writing drm_aclk counter register
         ret = writeDrmAddress( REG_FREQ_DETECTION_VERSION, 0 );
@@ -2023,7 +2724,7 @@ protected:
             return;
         }
 
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
 
         // Reset detection counter by writing drm_aclk counter register
         ret = writeDrmAddress( REG_FREQ_DETECTION_VERSION, 0 );
@@ -2070,7 +2771,7 @@ protected:
 
         Debug( "Detecting DRM frequency in {} ms", mFrequencyDetectionPeriod );
 
-        std::lock_guard<std::recursive_mutex> lock( mDrmControllerMutex );
+        std::lock_guard<RecursiveSharedMutex> lock( mDrmControllerMutex );
 
         while ( max_attempts > 0 ) {
 
@@ -2132,7 +2833,7 @@ protected:
     void sleepOrExit( const std::chrono::time_point<Clock, Duration> &timeout_time ) {
         std::unique_lock<std::mutex> lock( mThreadExitMtx );
         bool isExitRequested = mThreadExitCondVar.wait_until( lock, timeout_time,
-                [ this ]{ return mThreadExit; } );
+                [ this ]{ return mThreadExit.load(); } );
         if ( isExitRequested )
             Throw( DRM_Exit, "Exit requested. " );
     }
@@ -2141,7 +2842,7 @@ protected:
     void sleepOrExit( const std::chrono::duration<Rep, Period> &rel_time ) {
         std::unique_lock<std::mutex> lock( mThreadExitMtx );
         bool isExitRequested = mThreadExitCondVar.wait_for( lock, rel_time,
-                [ this ]{ return mThreadExit; } );
+                [ this ]{ return mThreadExit.load(); } );
         if ( isExitRequested )
             Throw( DRM_Exit, "Exit requested. " );
     }
@@ -2205,12 +2906,22 @@ protected:
                         // DRM license queue is full, wait until current license expires
                         uint32_t licenseTimeLeft = getCurrentLicenseTimeLeft();
                         TClock::duration wait_duration = std::chrono::seconds( licenseTimeLeft + 1 );
-                        Debug( "License thread sleeping {} seconds before checking DRM Controller readiness", licenseTimeLeft );
+                        if ( mLicenseRenewalJitter > 0 ) {
+                            // Spread the renewals of the boards started together. The deadline of the renewal
+                            // is the expiration of the license queued in the DRM Controller, resynchronized
+                            // below: the retries still have at least (1 - jitter) of the license duration
+                            wait_duration += std::chrono::duration_cast<TClock::duration>( std::chrono::duration<double>(
+                                    uniformRandom( 0, mLicenseRenewalJitter * mLicenseDuration ) ) );
+                        }
+                        Debug( "License thread sleeping {:.1f} seconds before checking DRM Controller readiness",
+                                std::chrono::duration<double>( wait_duration ).count() );
                         sleepOrExit( wait_duration );
                         // Resync expiration time
                         licenseTimeLeft = getCurrentLicenseTimeLeft();
                         mExpirationTime = TClock::now() + std::chrono::seconds( licenseTimeLeft );
-                        Debug( "Update expiration time to {}", time_t_to_string( steady_clock_to_time_t( mExpirationTime ) ) );
+                        Debug( "Update expiration time to {}: {} seconds left to renew the license",
+                               time_t_to_string( steady_clock_to_time_t( mExpirationTime ) ), licenseTimeLeft );
+                        publishStatusSnapshot();
                     }
                 }
 
@@ -2232,7 +2943,7 @@ protected:
             logDrmCtrlError();
             logDrmCtrlTrngStatus();
             Debug( "Exiting background thread which maintains licensing" );
-            sLogger->flush();
+            flushLog();
         });
     }
 
@@ -2254,13 +2965,21 @@ protected:
                 while( 1 ) {
 
                     /// Sleep until it's time to collect the next metering data
-                    TClock::time_point wakeup_time = TClock::now() + std::chrono::seconds( mHealthPeriod );
-                    Debug( "Health thread sleeping {} seconds before gathering new metering", mHealthPeriod );
+                    TClock::duration health_period = std::chrono::seconds( mHealthPeriod );
+                    if ( mHealthPeriodJitter > 0 ) {
+                        // Spread the health requests of the boards started together
+                        health_period -= std::chrono::duration_cast<TClock::duration>( std::chrono::duration<double>(
+                                uniformRandom( 0, mHealthPeriodJitter * mHealthPeriod ) ) );
+                    }
+                    TClock::time_point wakeup_time = TClock::now() + health_period;
+                    Debug( "Health thread sleeping {:.1f} seconds before gathering new metering",
+                            std::chrono::duration<double>( health_period ).count() );
                     sleepOrExit( wakeup_time );
 
                     /// Collect the next metering data and send them to the Health Web Service
                     Debug( "Health thread collecting new metering data" );
                     Json::Value response_json = performHealth( retry_timeout_ms, retry_sleep_ms );
+                    publishStatusSnapshot();
 
                     if ( response_json != Json::nullValue ) {
                         /// Extract asynchronous metering parameters from response
@@ -2316,7 +3035,7 @@ protected:
                 f_asynch_error( e.what() );
             }
             Debug( "Exiting background thread which checks health" );
-            sLogger->flush();
+            flushLog();
         });
     }
 
@@ -2344,13 +3063,14 @@ protected:
     }
 
     void waitActivationCodeTransmitted() {
+        MetricTimer metric_timer( Metrics::instance().statusWaitDuration );
         bool activationCodesTransmitted( false );
         TClock::duration timeSpan;
         double mseconds( 0.0 );
         uint32_t sleep_period = mCtrlSleepInUS * 100;
         TClock::time_point timeStart = TClock::now();
         while( mseconds < mActivationTransmissionTimeoutMS ) {
-            checkDRMCtlrRet( getDrmController().readActivationCodesTransmittedStatusRegister(
+            checkDRMCtlrRetShared( getDrmController().readActivationCodesTransmittedStatusRegister(
                     activationCodesTransmitted ) );
             timeSpan = TClock::now() - timeStart;
             mseconds = 1000.0 * double( timeSpan.count() ) * TClock::period::num / TClock::period::den;
@@ -2387,6 +3107,7 @@ protected:
             Debug( "There is no session in Node-Locked licensing mode" );
             return;
         }
+        MetricTimer metric_timer( Metrics::instance().statusWaitDuration );
         double mseconds( 0.0 );
         bool is_running(false);
         TClock::duration timeSpan;
@@ -2409,6 +3130,7 @@ protected:
     }
 
     void startSession() {
+        completeDeferredInit();
         {
             Debug( "Waiting metering access mutex from startSession" );
             std::lock_guard<std::mutex> lockMetering( mMeteringAccessMutex );
@@ -2418,6 +3140,7 @@ protected:
                 Unreachable( "To start a new session the DRM Controller shall be ready to accept a new license" ); //LCOV_EXCL_LINE
 
             mLicenseCounter = 0;
+            clearMeteringSnapshot();
 
             // Build start request message for new license
             Json::Value request_json = getMeteringStart();
@@ -2459,7 +3182,10 @@ protected:
                 Debug( "Initialize expiration time from DRM registry: {}", time_t_to_string( t ) );
             }
 
-            if ( isReadyForNewLicense() ) {
+            if ( mFastResumePending ) {
+                // The licensing thread requests the next license when the DRM Controller is ready for it
+                Debug( "Fast resume: no license request before the licensing thread starts" );
+            } else if ( isReadyForNewLicense() ) {
                 // Create JSON license request
                 Json::Value request_json = getMeteringRunning();
 
@@ -2479,6 +3205,7 @@ protected:
 
         // Stop background thread
         stopThread();
+        completeDeferredInit();
 
         {
             // Get and send metering data to web service
@@ -2486,11 +3213,14 @@ protected:
             std::lock_guard<std::mutex> lockMetering( mMeteringAccessMutex );
             Debug( "Acquired metering access mutex from stopSession" );
             request_json = getMeteringStop();
+            clearMeteringSnapshot();
 
-            // Send last metering information
-            Json::Value license_json = getLicense( request_json, mWSApiRetryDuration * 1000, mWSRetryPeriodShort * 1000 );
-            checkSessionIDFromWS( license_json );
-            Debug( "Session ID {} stopped and last metering data uploaded", mSessionID );
+            if ( !spoolSessionClose( request_json ) ) {
+                // Send last metering information
+                Json::Value license_json = getLicense( request_json, mWSApiRetryDuration * 1000, mWSRetryPeriodShort * 1000 );
+                checkSessionIDFromWS( license_json );
+                Debug( "Session ID {} stopped and last metering data uploaded", mSessionID );
+            }
         }
         Debug( "Released metering access mutex from stopSession" );
         // Clear Session ID
@@ -2509,21 +3239,346 @@ protected:
         Info( "DRM session {} stopped.", sessionID );
     }
 
-    ParameterKey findParameterKey( const std::string& key_string ) const {
-        for ( auto const& it : mParameterKeyMap ) {
-            if ( key_string == it.second ) {
-                return it.first;
+    // Save the close request in the spool instead of posting it; return false if the session must be closed now
+    bool spoolSessionClose( Json::Value& request_json ) {
+        if ( !mSessionSpool )
+            return false;
+        request_json["settings"] = buildSettingsNode();
+        try {
+            mSessionSpool->push( mSessionID, request_json );
+        } catch( const Exception& e ) {
+            Warning( "Failed to spool the close request of session {}, closing it now: {}", mSessionID, e.what() );
+            return false;
+        }
+        Debug( "Session ID {} stopped and last metering data spooled", mSessionID );
+        startSpoolFlushThread();
+        return true;
+    }
+
+    void startSpoolFlushThread() {
+        std::lock_guard<std::mutex> lock( mSpoolMtx );
+        mSpoolFlushPending = true;
+        if ( mSpoolFlushRunning )
+            return;     // The running thread flushes the spool again before exiting
+        if ( mThreadSpool.valid() )
+            mThreadSpool.get();
+        mSpoolFlushRunning = true;
+
+        mThreadSpool = std::async( std::launch::async, [ this ]() {
+            Debug( "Starting background thread which posts the spooled close requests" );
+            try {
+                DrmWSClient ws_client( mConfFilePath, mCredFilePath, &mSpoolExit );
+                // The close requests are retried until the destruction: there is no deadline
+                RetryBackoff backoff( mLicenseRetryPolicy );
+                while( 1 ) {
+                    {
+                        std::lock_guard<std::mutex> lock( mSpoolMtx );
+                        if ( !mSpoolFlushPending || mSpoolExit.load() ) {
+                            mSpoolFlushRunning = false;
+                            break;
+                        }
+                        mSpoolFlushPending = false;
+                    }
+                    SessionSpool::FlushResult result = mSessionSpool->flush( ws_client, mSpoolExit );
+                    for( const std::string& session_id: result.dropped ) {
+                        std::string errmsg = fmt::format( "[errCode={}] The close request of session {} was rejected by "
+                                "the License Web Service: its last metering data is lost", DRM_WSError, session_id );
+                        Warning( errmsg );
+                        f_asynch_error( errmsg );
+                    }
+                    if ( !result.retry ) {
+                        backoff.reset();
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock( mSpoolMtx );
+                    if ( mSpoolStop ) {
+                        mSpoolFlushRunning = false;
+                        break;
+                    }
+                    TClock::duration wait_duration = backoff.next( TClock::time_point::max(), result.retryAfterMS );
+                    Debug( "New attempt to post the spooled close requests planned in {:.1f} seconds",
+                           std::chrono::duration<double>( wait_duration ).count() );
+                    mSpoolCondVar.wait_for( lock, wait_duration, [ this ]() { return mSpoolStop; } );
+                    mSpoolFlushPending = true;
+                }
+            } catch( const std::exception &e ) {
+                Warning( "Failed to post the spooled close requests: {}", e.what() );
+                std::lock_guard<std::mutex> lock( mSpoolMtx );
+                mSpoolFlushRunning = false;
             }
+            Debug( "Exiting background thread which posts the spooled close requests" );
+        });
+    }
+
+    void stopSpoolFlushThread() {
+        if ( !mThreadSpool.valid() )
+            return;
+        // Give the thread a last attempt, bounded by the request timeout, then abort it.
+        // The requests not posted yet stay in the spool for the next process
+        {
+            std::lock_guard<std::mutex> lock( mSpoolMtx );
+            mSpoolStop = true;
         }
-        Throw( DRM_BadArg, "Cannot find parameter: {}. ", key_string );
+        mSpoolCondVar.notify_all();
+        std::chrono::milliseconds timeout( mWsClient ? mWsClient->getRequestTimeoutMS() : 0 );
+        if ( mThreadSpool.wait_for( timeout ) != std::future_status::ready )
+            Warning( "Spooled close requests not posted after {} ms: they are kept for the next instance",
+                     timeout.count() );
+        mSpoolExit = true;
+        mThreadSpool.get();
+    }
+
+    Json::Value callDaemon( const std::string& command, Json::Value request ) const {
+        request["cmd"] = command;
+        Debug2( "Forwarding '{}' to the DRM daemon", command );
+        return mDaemonClient->call( request );
+    }
+
+    // Serve a request from a client of the daemon.
+    // The requests of all the clients are serialized: the DRM Manager of the daemon sees a single caller
+    Json::Value handleDaemonRequest( uint64_t client_id, const Json::Value& request ) {
+        std::string command = JVgetRequired( request, "cmd", Json::stringValue ).asString();
+        Debug( "DRM daemon client {} requests '{}'", client_id, command );
+        std::lock_guard<std::mutex> lock( mDaemonMtx );
+        if ( command == "activate" ) {
+            // The session is shared by all the clients: only the first activation opens or resumes it
+            if ( !mDaemonSessionActive ) {
+                activate( JVgetOptional( request, "resume", Json::booleanValue, false ).asBool() );
+                mDaemonSessionActive = true;
+            }
+            mDaemonClients.insert( client_id );
+            return Json::nullValue;
+        }
+        if ( command == "deactivate" ) {
+            releaseDaemonClientLocked( client_id, JVgetOptional( request, "pause", Json::booleanValue, false ).asBool() );
+            return Json::nullValue;
+        }
+        if ( command == "get" ) {
+            // The clients can only read the parameters of the session and the design, not the credentials,
+            // the configuration or the registers of the daemon
+            Json::Value json_value = JVgetRequired( request, "params", Json::objectValue );
+            for( const std::string& key_str: json_value.getMemberNames() ) {
+                switch( findParameterKey( key_str ) ) {
+                    case ParameterKey::license_type:
+                    case ParameterKey::license_duration:
+                    case ParameterKey::num_activators:
+                    case ParameterKey::session_id:
+                    case ParameterKey::session_status:
+                    case ParameterKey::license_status:
+                    case ParameterKey::metered_data:
+                    case ParameterKey::drm_frequency:
+                    case ParameterKey::drm_license_type:
+                    case ParameterKey::product_info:
+                    case ParameterKey::mailbox_size:
+                    case ParameterKey::custom_field:
+                    case ParameterKey::mailbox_data:
+                    case ParameterKey::num_license_loaded:
+                    case ParameterKey::derived_product:
+                    case ParameterKey::is_drm_software:
+                    case ParameterKey::controller_version:
+                    case ParameterKey::status_version:
+                        break;
+                    default:
+                        Throw( DRM_BadArg, "Parameter '{}' cannot be read by a client of the DRM daemon. ", key_str );
+                }
+            }
+            get( json_value );
+            return json_value;
+        }
+        if ( command == "set" ) {
+            // The clients can only write the parameters of the session, not the configuration of the daemon
+            const Json::Value& params = JVgetRequired( request, "params", Json::objectValue );
+            for( const std::string& key_str: params.getMemberNames() ) {
+                ParameterKey key_id = findParameterKey( key_str );
+                if ( ( key_id != ParameterKey::custom_field ) && ( key_id != ParameterKey::mailbox_data )
+                        && ( key_id != ParameterKey::log_message ) )
+                    Throw( DRM_BadArg, "Parameter '{}' cannot be set by a client of the DRM daemon. ", key_str );
+            }
+            set( params );
+            return Json::nullValue;
+        }
+        if ( command == "read_metering" ) {
+            uint32_t nb_activators = 0;
+            getNumActivator( nb_activators );
+            size_t n = std::min<size_t>( nb_activators,
+                    (size_t)JVgetOptional( request, "n", Json::uintValue, 0 ).asUInt64() );
+            std::vector<uint64_t> counts( n );
+            Json::Value result;
+            result["num_activators"] = read_metering( counts.data(), n );
+            result["counts"] = Json::arrayValue;
+            for( const uint64_t& count: counts )
+                result["counts"].append( (Json::UInt64)count );
+            return result;
+        }
+        Throw( DRM_BadArg, "Unsupported DRM daemon command: {}. ", command );
+    }
+
+    // Release the session held by a client: the session is closed, or left running if it is paused,
+    // when the last client releases it
+    void releaseDaemonClient( uint64_t client_id, bool pause_session_request ) {
+        std::lock_guard<std::mutex> lock( mDaemonMtx );
+        releaseDaemonClientLocked( client_id, pause_session_request );
+    }
+
+    void releaseDaemonClientLocked( uint64_t client_id, bool pause_session_request ) {
+        if ( !mDaemonClients.erase( client_id ) || !mDaemonClients.empty() || !mDaemonSessionActive )
+            return;
+        if ( pause_session_request ) {
+            Debug( "Last DRM daemon client paused the session: session is kept running" );
+            return;
+        }
+        Debug( "Last DRM daemon client released the session: session is stopped" );
+        mDaemonSessionActive = false;
+        deactivate( false );
+    }
+
+    ParameterKey findParameterKey( const std::string& key_string ) const {
+        const std::vector<ParameterKeyEntry>& table = getSortedParameterKeys();
+        auto it = std::lower_bound( table.begin(), table.end(), key_string.c_str(),
+                []( const ParameterKeyEntry& entry, const char* key ) { return strcmp( entry.first, key ) < 0; } );
+        if ( ( it == table.end() ) || ( key_string != it->first ) )
+            Throw( DRM_BadArg, "Cannot find parameter: {}. ", key_string );
+        return it->second;
     }
 
     std::string findParameterString( const ParameterKey key_id ) const {
-        std::map<ParameterKey, std::string>::const_iterator it;
-        it = mParameterKeyMap.find( key_id );
-        if ( it == mParameterKeyMap.end() )
+        if ( ( key_id < 0 ) || ( key_id > ParameterKey::ParameterKeyCount ) )
             Throw( DRM_BadArg, "Cannot find parameter with ID: {}. ", key_id );
-        return it->second;
+        return getParameterKeyNames()[key_id];
+    }
+
+    // Read the scalar parameters directly from their source, without building a JSON object.
+    // Return false if the parameter is not handled so that the caller falls back to get(Json::Value&).
+    template<typename T> bool getScalar( const ParameterKey key_id, T& value ) const {
+        if ( mDaemonClient )
+            return false;
+        switch( key_id ) {
+            case ParameterKey::license_duration:
+                value = static_cast<T>( mStatusCached ? getStatusSnapshot()->licenseDuration : mLicenseDuration );
+                break;
+            case ParameterKey::num_activators: {
+                uint32_t nbActivators = 0;
+                getNumActivator( nbActivators );
+                value = static_cast<T>( nbActivators );
+                break;
+            }
+            case ParameterKey::session_status:
+                value = static_cast<T>( mStatusCached ? getStatusSnapshot()->sessionRunning : isSessionRunning() );
+                break;
+            case ParameterKey::license_status:
+                value = static_cast<T>( mStatusCached ? getStatusSnapshot()->licenseActive : isLicenseActive() );
+                break;
+            case ParameterKey::num_license_loaded:
+                value = static_cast<T>( mStatusCached ? getStatusSnapshot()->numLicenseLoaded : getNumLicenseLoaded() );
+                break;
+            case ParameterKey::status_version:
+                value = static_cast<T>( getStatusSnapshot()->version );
+                break;
+            case ParameterKey::status_cached:
+                value = static_cast<T>( mStatusCached );
+                break;
+            case ParameterKey::metering_cache_period:
+                value = static_cast<T>( mMeteringCachePeriod.load() );
+                break;
+            case ParameterKey::drm_frequency:
+                value = static_cast<T>( mFrequencyCurr );
+                break;
+            case ParameterKey::health_period:
+                value = static_cast<T>( mHealthPeriod );
+                break;
+            case ParameterKey::health_retry:
+                value = static_cast<T>( mHealthRetryTimeout );
+                break;
+            case ParameterKey::health_retry_sleep:
+                value = static_cast<T>( mHealthRetrySleep );
+                break;
+            case ParameterKey::ws_retry_period_long:
+                value = static_cast<T>( mWSRetryPeriodLong );
+                break;
+            case ParameterKey::ws_retry_period_short:
+                value = static_cast<T>( mWSRetryPeriodShort );
+                break;
+            case ParameterKey::ws_api_retry_duration:
+                value = static_cast<T>( mWSApiRetryDuration );
+                break;
+            case ParameterKey::log_verbosity:
+                value = static_cast<T>( static_cast<uint32_t>( sLogConsoleVerbosity ) );
+                break;
+            case ParameterKey::log_file_verbosity:
+                value = static_cast<T>( static_cast<uint32_t>( sLogFileVerbosity ) );
+                break;
+            case ParameterKey::log_file_type:
+                value = static_cast<T>( static_cast<uint32_t>( sLogFileType ) );
+                break;
+            case ParameterKey::log_file_rotating_num:
+                value = static_cast<T>( static_cast<uint32_t>( sLogFileRotatingNum ) );
+                break;
+            case ParameterKey::log_file_rotating_size:
+                value = static_cast<T>( static_cast<uint32_t>( sLogFileRotatingSize ) );
+                break;
+            case ParameterKey::log_file_append:
+                value = static_cast<T>( sLogFileAppend );
+                break;
+            case ParameterKey::log_async:
+                value = static_cast<T>( sLogAsync );
+                break;
+            case ParameterKey::log_ctrl_verbosity:
+                value = static_cast<T>( static_cast<uint32_t>( sLogCtrlVerbosity ) );
+                break;
+            case ParameterKey::log_message_level:
+                value = static_cast<T>( static_cast<uint32_t>( mDebugMessageLevel ) );
+                break;
+            case ParameterKey::host_data_verbosity:
+                value = static_cast<T>( static_cast<uint32_t>( mHostDataVerbosity ) );
+                break;
+            case ParameterKey::bypass_frequency_detection:
+                value = static_cast<T>( mBypassFrequencyDetection );
+                break;
+            case ParameterKey::frequency_detection_method:
+                value = static_cast<T>( mFreqDetectionMethod );
+                break;
+            case ParameterKey::frequency_detection_threshold:
+                value = static_cast<T>( mFrequencyDetectionThreshold );
+                break;
+            case ParameterKey::frequency_detection_period:
+                value = static_cast<T>( mFrequencyDetectionPeriod );
+                break;
+            case ParameterKey::custom_field:
+                value = static_cast<T>( readMailbox<uint32_t>( eMailboxOffset::MB_CUSTOM_FIELD ) );
+                break;
+            case ParameterKey::is_drm_software:
+                value = static_cast<T>( mIsHybrid );
+                break;
+            default:
+                return false;
+        }
+        Debug( "Get value of parameter '{}' (ID={}): {}", getParameterKeyNames()[key_id], key_id, value );
+        return true;
+    }
+
+    // Read the string parameters directly from their source, without building a JSON object.
+    // Return false if the parameter is not handled so that the caller falls back to get(Json::Value&).
+    bool getString( const ParameterKey key_id, std::string& value ) const {
+        if ( mDaemonClient )
+            return false;
+        switch( key_id ) {
+            case ParameterKey::session_id:
+                value = mSessionID;
+                break;
+            case ParameterKey::controller_version:
+                value = mDrmVersionStr;
+                break;
+            case ParameterKey::derived_product:
+                value = mDerivedProduct;
+                break;
+            case ParameterKey::log_file_path:
+                value = sLogFilePath;
+                break;
+            default:
+                return false;
+        }
+        Debug( "Get value of parameter '{}' (ID={}): {}", getParameterKeyNames()[key_id], key_id, value );
+        return true;
     }
 
     Json::Value list_parameter_key() const {
@@ -2565,6 +3620,12 @@ public:
             Debug( "Calling Impl public constructor" );
             if ( f_user_asynch_error )
                 f_asynch_error = f_user_asynch_error;
+            if ( !mDaemonSocket.empty() ) {
+                // The DRM Controller is owned by the daemon: all calls are forwarded to it
+                mDaemonClient.reset( new DaemonClient( mDaemonSocket, mDaemonTimeout * 1000 ) );
+                Debug( "Exiting Impl public constructor: calls are forwarded to the DRM daemon on {}", mDaemonSocket );
+                return;
+            }
             // Determine DRM Ctrl TA existance by trying to initialize it
             mIsPnR = pnc_initialize_drm_ctrl_ta();
             if ( mIsPnR ) {
@@ -2588,6 +3649,14 @@ public:
                 Throw( DRM_BadArg, "Write register callback function must not be NULL. " );
             if ( !f_asynch_error )
                 Throw( DRM_BadArg, "Asynchronous error callback function must not be NULL. " );
+            if ( mRegisterTrace ) {
+                // Dump the register trace before reporting an asynchronous error
+                AsynchErrorCallback f_user_error = f_asynch_error;
+                f_asynch_error = [this, f_user_error]( const std::string& msg ) {
+                    dumpRegisterTrace( mRegisterTraceFile, false );
+                    f_user_error( msg );
+                };
+            }
             
             if ( mIsHybrid ) {
                 if ( mIsPnR )
@@ -2615,18 +3684,58 @@ public:
                 setenv("DRM_CONTROLLER_SLEEP_IN_MICRO_SECONDS", s_sleep_period.c_str(), 0);
             }
             initDrmInterface();
-            getHostAndCardInfo();
+            if ( mFastResumePending )
+                mHostDataPending = true;
+            else
+                getHostAndCardInfo();
+            // Build the objects which can fail before registering this instance or starting any thread
+            if ( !mSessionSpoolDir.empty() && !isConfigInNodeLock() )
+                mSessionSpool.reset( new SessionSpool( mSessionSpoolDir ) );
+            if ( !mDaemonServerSocket.empty() ) {
+                mDaemonServer.reset( new DaemonServer( mDaemonServerSocket, mDaemonSocketMode,
+                        [this]( uint64_t client_id, const Json::Value& request ) {
+                            return handleDaemonRequest( client_id, request );
+                        },
+                        [this]( uint64_t client_id ) {
+                            releaseDaemonClient( client_id, false );
+                        } ) );
+            }
+            if ( mMetricsEnabled ) {
+                Metrics::instance().acquire( this, [this]() {
+                    std::shared_ptr<const StatusSnapshot> snapshot = std::atomic_load( &mStatusSnapshot );
+                    if ( !snapshot || ( snapshot->expirationTime.time_since_epoch().count() == 0 ) )
+                        return (int64_t)0;
+                    return (int64_t)std::max<int64_t>( 0, std::chrono::duration_cast<std::chrono::seconds>(
+                            snapshot->expirationTime - TClock::now() ).count() );
+                }, mMetricsEndpoint );
+            }
+            // Post the close requests left by a previous process
+            if ( mSessionSpool && !mSessionSpool->list().empty() )
+                startSpoolFlushThread();
             Debug( "Exiting Impl public constructor" );
         
         } catch( const std::exception &e ) {
+            // Undo the registrations and stop the threads which may already use this instance
+            mDaemonServer.reset();
+            stopSpoolFlushThread();
+            Metrics::instance().release( this );
             Fatal( e.what() );
-            sLogger->flush();
+            flushLog();
             f_asynch_error( e.what() );
             throw;
         }   
     }
 
     ~Impl() {
+        if ( mDaemonClient ) {
+            // Closing the connection releases the session held by this client in the daemon
+            mDaemonClient.reset();
+            Debug( "Exiting Impl destructor" );
+            flushLog();
+            return;
+        }
+        // Stop serving the clients first: the clients still connected release the session
+        mDaemonServer.reset();
         try {
             TRY
                 Debug( "Calling Impl destructor" );
@@ -2639,16 +3748,25 @@ public:
 
             CATCH_AND_THROW
         } catch(...) {}
+        stopSpoolFlushThread();
+        Metrics::instance().release( this );
         unlockDrmToInstance();
         pnc_uninitialize_drm_ctrl_ta();
         Debug( "Exiting Impl destructor" );
-        sLogger->flush();
+        flushLog();
     }
 
     void activate( const bool& resume_session_request = false ) {
         TRY
             Debug( "Calling 'activate' with 'resume_session_request'={}", resume_session_request );
 
+            if ( mDaemonClient ) {
+                Json::Value request;
+                request["resume"] = resume_session_request;
+                callDaemon( "activate", request );
+                return;
+            }
+
             if ( isConfigInNodeLock() ) {
                 // Install the node-locked license
                 installNodelockedLicense();
@@ -2668,9 +3786,26 @@ public:
 
             } else {
                 // Recover pending session
+                if ( mFastResumePending && mSessionID.empty() ) {
+                    // Read the session ID and the license expiration time with a single mailbox access
+                    std::vector<uint32_t> words = readMailbox( eMailboxOffset::MB_SESSION_0,
+                            (uint32_t)eMailboxOffset::MB_USER - (uint32_t)eMailboxOffset::MB_SESSION_0 );
+                    uint64_t session_id;
+                    time_t t;
+                    std::memcpy( &session_id, words.data(), sizeof( session_id ) );
+                    std::memcpy( &t, words.data() + (uint32_t)eMailboxOffset::MB_LIC_EXP_0 - (uint32_t)eMailboxOffset::MB_SESSION_0,
+                                 sizeof( t ) );
+                    mSessionID = toUpHex( session_id );
+                    mExpirationTime = time_t_to_steady_clock( t );
+                    Debug( "Initialize expiration time from DRM registry: {}", time_t_to_string( t ) );
+                }
                 if ( mSessionID.empty() )
                     mSessionID = toUpHex( readMailbox<uint64_t>( eMailboxOffset::MB_SESSION_0 ) );
 
+                // The frequency check must fail the activation, and the host information must be
+                // collected before the background threads build their requests
+                completeDeferredInit();
+
                 if ( resume_session_request && isLicenseActive() ) {
                     Debug( "A session is still pending and latest license is still valid: "
                            "pending session is kept" );
@@ -2682,6 +3817,7 @@ public:
                     startSession();
                 }
             }
+            mFastResumePending = false;
             mThreadExit = false;
             startLicenseContinuityThread();
             if ( mHealthPeriod )
@@ -2696,6 +3832,13 @@ public:
         TRY
             Debug( "Calling 'deactivate' with 'pause_session_request'={}", pause_session_request );
 
+            if ( mDaemonClient ) {
+                Json::Value request;
+                request["pause"] = pause_session_request;
+                callDaemon( "deactivate", request );
+                return;
+            }
+
             if ( isConfigInNodeLock() ) {
                 return;
             }
@@ -2707,11 +3850,35 @@ public:
                 pauseSession();
             else
                 stopSession();
+            publishStatusSnapshot();
+        CATCH_AND_THROW
+    }
+
+    uint32_t read_metering( uint64_t* counts, size_t n ) const {
+        TRY
+            if ( ( counts == nullptr ) && ( n != 0 ) )
+                Throw( DRM_BadArg, "Metering output buffer is NULL. " );
+            if ( mDaemonClient ) {
+                Json::Value request;
+                request["n"] = (Json::UInt64)n;
+                Json::Value result = callDaemon( "read_metering", request );
+                const Json::Value& values = result["counts"];
+                for( Json::ArrayIndex i = 0; ( i < values.size() ) && ( i < n ); i++ )
+                    counts[i] = values[i].asUInt64();
+                return result["num_activators"].asUInt();
+            }
+            return readMetering( counts, n );
         CATCH_AND_THROW
     }
 
     void get( Json::Value& json_value ) const {
         TRY
+            if ( mDaemonClient ) {
+                Json::Value request;
+                request["params"] = json_value;
+                json_value = callDaemon( "get", request );
+                return;
+            }
             for( const std::string& key_str : json_value.getMemberNames() ) {
                 const ParameterKey key_id = findParameterKey( key_str );
                 Debug2( "Getting parameter '{}'", key_str );
@@ -2777,9 +3944,10 @@ public:
                         break;
                     }
                     case ParameterKey::license_duration: {
-                        json_value[key_str] = mLicenseDuration;
+                        uint32_t duration = mStatusCached ? getStatusSnapshot()->licenseDuration : mLicenseDuration;
+                        json_value[key_str] = duration;
                         Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
-                                mLicenseDuration );
+                                duration );
                         break;
                     }
                     case ParameterKey::num_activators: {
@@ -2797,14 +3965,14 @@ public:
                         break;
                     }
                     case ParameterKey::session_status: {
-                        bool status = isSessionRunning();
+                        bool status = mStatusCached ? getStatusSnapshot()->sessionRunning : isSessionRunning();
                         json_value[key_str] = status;
                         Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
                                status );
                         break;
                     }
                     case ParameterKey::license_status: {
-                        bool status = isLicenseActive();
+                        bool status = mStatusCached ? getStatusSnapshot()->licenseActive : isLicenseActive();
                         json_value[key_str] = status;
                         Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
                                status );
@@ -2817,6 +3985,19 @@ public:
                         // No "int64_t" support with JsonCpp < 1.7.5
                         unsigned long long int ip_metering = 0;
                         #endif
+                        if ( mMeteringCachePeriod ) {
+                            // Read from the metering snapshot like read_metering: unlike the health
+                            // request path, the health counter is not incremented
+                            std::shared_ptr<const MeteringSnapshot> snapshot = getMeteringSnapshot();
+                            json_value[key_str] = Json::arrayValue;
+                            for ( auto count: snapshot->counts )
+                                json_value[key_str].append( (decltype(ip_metering))count );
+                            if ( snapshot->counts.empty() )
+                                json_value[key_str].append(0);
+                            Debug( "Get value of parameter '{}' (ID={}) from metering snapshot: {}", key_str, key_id,
+                                   json_value[key_str].toStyledString() );
+                            break;
+                        }
                         Json::Value json_request = getMeteringHealth();
                         std::string meteringFileStr = json_request["meteringFile"].asString();
                         if  ( meteringFileStr.size() ) {
@@ -2873,15 +4054,7 @@ public:
                         break;
                     }
                     case ParameterKey::drm_license_type: {
-                        eLicenseType lic_type;
-                        bool is_nodelock = isDrmCtrlInNodelock();
-                        bool is_metering = isDrmCtrlInMetering();
-                        if ( is_metering )
-                            lic_type = eLicenseType::METERED;
-                        else if ( is_nodelock )
-                            lic_type = eLicenseType::NODE_LOCKED;
-                        else
-                            lic_type = eLicenseType::NONE;
+                        eLicenseType lic_type = mStatusCached ? getStatusSnapshot()->drmLicenseType : getDrmCtrlLicenseType();
                         auto it = LicenseTypeStringMap.find( lic_type );
                         std::string status = it->second;
                         json_value[key_str] = status;
@@ -3049,6 +4222,12 @@ public:
                                sLogFileAppend );
                         break;
                     }
+                    case ParameterKey::log_async: {
+                        json_value[key_str] = sLogAsync;
+                        Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
+                               sLogAsync );
+                        break;
+                    }
                     case ParameterKey::ws_verbosity: {
                         uint32_t wsVerbosity = getDrmWSClient().getVerbosity();
                         json_value[key_str] = wsVerbosity;
@@ -3070,9 +4249,8 @@ public:
                         break;
                     }
                     case ParameterKey::num_license_loaded: {
-                        uint32_t numberOfLicenseProvisioned;
-                        checkDRMCtlrRet( getDrmController().readNumberOfLicenseTimerLoadedStatusRegister(
-                                    numberOfLicenseProvisioned ) );
+                        uint32_t numberOfLicenseProvisioned = mStatusCached ? getStatusSnapshot()->numLicenseLoaded
+                                                                            : getNumLicenseLoaded();
                         json_value[key_str] = numberOfLicenseProvisioned;
                         Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
                                numberOfLicenseProvisioned );
@@ -3110,9 +4288,58 @@ public:
                         break;
                     }
                     case ParameterKey::controller_rom: {
-                        json_value[key_str] = mMailboxRoData;
+                        const Json::Value& mailboxRoData = getDesignInfo()->mailboxRoData;
+                        json_value[key_str] = mailboxRoData;
+                        Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
+                                mailboxRoData.toStyledString() );
+                        break;
+                    }
+                    case ParameterKey::metering_cache_period: {
+                        json_value[key_str] = mMeteringCachePeriod.load();
+                        Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
+                               mMeteringCachePeriod.load() );
+                        break;
+                    }
+                    case ParameterKey::status_cached: {
+                        json_value[key_str] = mStatusCached;
+                        Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
+                               mStatusCached );
+                        break;
+                    }
+                    case ParameterKey::status_version: {
+                        #if ((JSONCPP_VERSION_MAJOR ) >= 1 and ((JSONCPP_VERSION_MINOR) > 7 or ((JSONCPP_VERSION_MINOR) == 7 and JSONCPP_VERSION_PATCH >= 5)))
+                        uint64_t version = getStatusSnapshot()->version;
+                        #else
+                        // No "int64_t" support with JsonCpp < 1.7.5
+                        unsigned long long int version = getStatusSnapshot()->version;
+                        #endif
+                        json_value[key_str] = version;
                         Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
-                                mMailboxRoData.toStyledString() );
+                               version );
+                        break;
+                    }
+                    case ParameterKey::metrics: {
+                        json_value[key_str] = Metrics::instance().format();
+                        Debug( "Get value of parameter '{}' (ID={})", key_str, key_id );
+                        break;
+                    }
+                    case ParameterKey::controller_latency: {
+                        Json::Value latency_json = Json::objectValue;
+                        for( const auto& it: Metrics::instance().controllerOperations() ) {
+                            const LatencyHistogram::Snapshot& snapshot = it.second;
+                            Json::Value op_json;
+                            op_json["count"] = (Json::UInt64)snapshot.count;
+                            op_json["mean_us"] = snapshot.count ? (double)snapshot.sumNs / snapshot.count / 1000 : 0.0;
+                            op_json["max_us"] = (double)snapshot.maxNs / 1000;
+                            op_json["p50_us"] = (double)snapshot.quantileNs( 0.5 ) / 1000;
+                            op_json["p90_us"] = (double)snapshot.quantileNs( 0.9 ) / 1000;
+                            op_json["p99_us"] = (double)snapshot.quantileNs( 0.99 ) / 1000;
+                            op_json["p999_us"] = (double)snapshot.quantileNs( 0.999 ) / 1000;
+                            latency_json[it.first] = op_json;
+                        }
+                        json_value[key_str] = latency_json;
+                        Debug( "Get value of parameter '{}' (ID={}): {}", key_str, key_id,
+                               latency_json.toStyledString() );
                         break;
                     }
                     case ParameterKey::ParameterKeyCount: {
@@ -3146,6 +4373,12 @@ public:
 
     void set( const Json::Value& json_value ) {
         TRY
+            if ( mDaemonClient ) {
+                Json::Value request;
+                request["params"] = json_value;
+                callDaemon( "set", request );
+                return;
+            }
             for( Json::ValueConstIterator it = json_value.begin() ; it != json_value.end() ; it++ ) {
                 std::string key_str = it.key().asString();
                 const ParameterKey key_id = findParameterKey( key_str );
@@ -3155,7 +4388,7 @@ public:
                         sLogConsoleVerbosity = static_cast<spdlog::level::level_enum>( verbosityInt );
                         sLogger->sinks()[0]->set_level( sLogConsoleVerbosity );
                         if ( sLogConsoleVerbosity < sLogger->level() )
-                            sLogger->set_level( sLogConsoleVerbosity );
+                            setLogLevel( sLogConsoleVerbosity );
                         Debug( "Set parameter '{}' (ID={}) to value: {}", key_str, key_id,
                                 verbosityInt );
                         break;
@@ -3173,7 +4406,7 @@ public:
                         sLogFileVerbosity = static_cast<spdlog::level::level_enum>( verbosityInt );
                         sLogger->sinks()[1]->set_level( sLogFileVerbosity );
                         if ( sLogFileVerbosity < sLogger->level() )
-                            sLogger->set_level( sLogFileVerbosity );
+                            setLogLevel( sLogFileVerbosity );
                         Debug( "Set parameter '{}' (ID={}) to value: {}", key_str, key_id,
                                verbosityInt);
                         break;
@@ -3245,11 +4478,32 @@ public:
                                mWSApiRetryDuration );
                         break;
                     }
+                    case ParameterKey::metering_cache_period: {
+                        mMeteringCachePeriod = (*it).asUInt();
+                        Debug( "Set parameter '{}' (ID={}) to value: {}", key_str, key_id,
+                               mMeteringCachePeriod.load() );
+                        break;
+                    }
+                    case ParameterKey::status_cached: {
+                        mStatusCached = (*it).asBool();
+                        Debug( "Set parameter '{}' (ID={}) to value: {}", key_str, key_id,
+                               mStatusCached );
+                        break;
+                    }
+                    case ParameterKey::register_trace_dump: {
+                        std::string file_path = (*it).asString();
+                        if ( file_path.empty() )
+                            file_path = mRegisterTraceFile;
+                        dumpRegisterTrace( file_path );
+                        Debug( "Set parameter '{}' (ID={}) to value: {}", key_str, key_id,
+                               file_path );
+                        break;
+                    }
                     case ParameterKey::trigger_async_callback: {
                         std::string custom_msg = (*it).asString();
                         Exception e( DRM_Debug, custom_msg );
                         f_asynch_error( e.what() );
-                        sLogger->flush();
+                        flushLog();
                         Debug( "Set parameter '{}' (ID={}) to value: {}", key_str, key_id,
                                custom_msg );
                         break;
@@ -3307,6 +4561,11 @@ public:
 // DrmManager::Impl class definition
 /*************************************/
 
+#define IMPL_GET_SCALAR( T ) \
+    T scalar_value; \
+    if ( getScalar<T>( key_id, scalar_value ) ) \
+        return scalar_value;
+
 #define IMPL_GET_BODY \
     Json::Value json_value; \
     std::string key_str = findParameterString( key_id ); \
@@ -3316,6 +4575,9 @@ public:
 
 template<> std::string DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        std::string string_value;
+        if ( getString( key_id, string_value ) )
+            return string_value;
         IMPL_GET_BODY
         if ( json_value[key_str].isString() )
             return json_value[key_str].asString();
@@ -3325,6 +4587,7 @@ template<> std::string DrmManager::Impl::get( const ParameterKey key_id ) const
 
 template<> bool DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        IMPL_GET_SCALAR( bool )
         IMPL_GET_BODY
         return json_value[key_str].asBool();
     CATCH_AND_THROW
@@ -3332,6 +4595,7 @@ template<> bool DrmManager::Impl::get( const ParameterKey key_id ) const {
 
 template<> int32_t DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        IMPL_GET_SCALAR( int32_t )
         IMPL_GET_BODY
         return json_value[key_str].asInt();
     CATCH_AND_THROW
@@ -3339,6 +4603,7 @@ template<> int32_t DrmManager::Impl::get( const ParameterKey key_id ) const {
 
 template<> uint32_t DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        IMPL_GET_SCALAR( uint32_t )
         IMPL_GET_BODY
         return json_value[key_str].asUInt();
     CATCH_AND_THROW
@@ -3346,6 +4611,7 @@ template<> uint32_t DrmManager::Impl::get( const ParameterKey key_id ) const {
 
 template<> int64_t DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        IMPL_GET_SCALAR( int64_t )
         IMPL_GET_BODY
         return json_value[key_str].asInt64();
     CATCH_AND_THROW
@@ -3353,6 +4619,7 @@ template<> int64_t DrmManager::Impl::get( const ParameterKey key_id ) const {
 
 template<> uint64_t DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        IMPL_GET_SCALAR( uint64_t )
         IMPL_GET_BODY
         return json_value[key_str].asUInt64();
     CATCH_AND_THROW
@@ -3360,6 +4627,7 @@ template<> uint64_t DrmManager::Impl::get( const ParameterKey key_id ) const {
 
 template<> float DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        IMPL_GET_SCALAR( float )
         IMPL_GET_BODY
         return json_value[key_str].asFloat();
     CATCH_AND_THROW
@@ -3367,6 +4635,7 @@ template<> float DrmManager::Impl::get( const ParameterKey key_id ) const {
 
 template<> double DrmManager::Impl::get( const ParameterKey key_id ) const {
     TRY
+        IMPL_GET_SCALAR( double )
         IMPL_GET_BODY
         return json_value[key_str].asDouble();
     CATCH_AND_THROW
@@ -3460,6 +4729,10 @@ void DrmManager::deactivate( const bool& pause_session ) {
     pImpl->deactivate( pause_session );
 }
 
+uint32_t DrmManager::read_metering( uint64_t* counts, size_t n ) const {
+    return pImpl->read_metering( counts, n );
+}
+
 void DrmManager::get( Json::Value& json_value ) const {
     pImpl->get( json_value );
 }
@@ -16,13 +16,76 @@ limitations under the License.
 
 #include <iostream>
 #include <cstddef>
+#include <chrono>
+#include <condition_variable>
 #include "log.h"
+#include "spdlog/sinks/base_sink.h"
+
+#define LOG_FLUSH_TIMEOUT_MS    1000
 
 
 namespace Accelize {
     namespace DRM {
 
+        // Completion of the flushes queued by flushLog in the thread pool. Defined before the
+        // pool so that they are still alive when its destruction writes the pending messages
+        static std::mutex sFlushRequestMutex;       // Keeps the requests in the order of their ticket
+        static std::mutex sFlushMutex;
+        static std::condition_variable sFlushCondVar;
+        static uint64_t sFlushRequested = 0;
+        static uint64_t sFlushDone = 0;
+        static std::shared_ptr<spdlog::async_logger> sFlushLogger;
+        static std::weak_ptr<spdlog::details::thread_pool> sFlushThreadPool;
+
+        std::shared_ptr<spdlog::details::thread_pool> sLogThreadPool;
         std::shared_ptr<spdlog::logger> sLogger;
+        std::atomic<int> sLogLevel( spdlog::level::trace );
+
+        // Sink notifying flushLog when the background thread writes its ticket
+        class FlushNotifierSink: public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+        protected:
+            void sink_it_( const spdlog::details::log_msg& msg ) override {
+                uint64_t ticket = std::stoull( std::string( msg.payload.data(), msg.payload.size() ) );
+                std::lock_guard<std::mutex> lock( sFlushMutex );
+                if ( ticket > sFlushDone )
+                    sFlushDone = ticket;
+                sFlushCondVar.notify_all();
+            }
+            void flush_() override {}
+        };
+
+        void setLogLevel( spdlog::level::level_enum level ) {
+            sLogger->set_level( level );
+            sLogLevel.store( level, std::memory_order_relaxed );
+        }
+
+        void flushLog() {
+            std::shared_ptr<spdlog::logger> logger = sLogger;
+            if ( !logger )
+                return;
+            logger->flush();
+            std::shared_ptr<spdlog::details::thread_pool> pool = sLogThreadPool;
+            if ( !pool )
+                return;
+            // The asynchronous flush is only queued: queue a ticket behind it. The single
+            // background thread processes the queue in order, so once the ticket is written
+            // the messages logged before this call are written and the sinks are flushed.
+            uint64_t ticket;
+            {
+                std::lock_guard<std::mutex> lock( sFlushRequestMutex );
+                if ( sFlushThreadPool.lock() != pool ) {
+                    sFlushLogger = std::make_shared<spdlog::async_logger>( "drmlib_flush",
+                            std::make_shared<FlushNotifierSink>(), pool, spdlog::async_overflow_policy::block );
+                    sFlushThreadPool = pool;
+                }
+                ticket = ++sFlushRequested;
+                sFlushLogger->info( "{}", ticket );
+            }
+            // The ticket may be dropped by the overrun_oldest policy: the wait is bounded
+            std::unique_lock<std::mutex> lock( sFlushMutex );
+            sFlushCondVar.wait_for( lock, std::chrono::milliseconds( LOG_FLUSH_TIMEOUT_MS ),
+                                    [ticket]{ return sFlushDone >= ticket; } );
+        }
 
     }
 }
@@ -0,0 +1,426 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "metrics.h"
+#include "accelize/drm/error.h"
+#include "log.h"
+#include "utils.h"
+
+
+namespace Accelize {
+namespace DRM {
+
+
+static const std::vector<double> WS_REQUEST_BOUNDS = { 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120 };
+static const std::vector<double> CTRL_BOUNDS = { 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10 };
+
+static const int SERVER_POLL_PERIOD_MS = 200;
+static const int SERVER_SEND_TIMEOUT_MS = 1000;     // Maximum time to send a response to a client
+static const std::string ENDPOINT_UNIX = "unix:";
+static const std::string ENDPOINT_TCP = "tcp:";
+
+std::atomic<uint32_t> Metrics::sEnabled{ 0 };
+
+
+// Format a floating point value as required by OpenMetrics (always with a decimal point)
+static std::string formatFloat( double value ) {
+    std::string str = fmt::format( "{}", value );
+    if ( str.find_first_of( ".e" ) == std::string::npos )
+        str += ".0";
+    return str;
+}
+
+static void formatHeader( std::string& text, const std::string& name, const std::string& type,
+                          const std::string& help ) {
+    text += fmt::format( "# TYPE {} {}\n# HELP {} {}\n", name, type, name, help );
+}
+
+static void formatCounter( std::string& text, const std::string& name, const std::string& help,
+                           const MetricCounter& counter ) {
+    formatHeader( text, name, "counter", help );
+    text += fmt::format( "{}_total {}\n", name, counter.value() );
+}
+
+
+MetricHistogram::MetricHistogram( const std::vector<double>& bounds )
+    : mBounds( bounds ), mBuckets( new std::atomic<uint64_t>[bounds.size() + 1] ) {
+    for( size_t i = 0; i <= mBounds.size(); i++ )
+        mBuckets[i].store( 0 );
+}
+
+void MetricHistogram::observe( const std::chrono::steady_clock::duration& duration ) {
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( duration ).count();
+    double sec = (double)ns / 1e9;
+    size_t i = 0;
+    while( ( i < mBounds.size() ) && ( sec > mBounds[i] ) )
+        i++;
+    mBuckets[i].fetch_add( 1, std::memory_order_relaxed );
+    mSumNs.fetch_add( ns, std::memory_order_relaxed );
+}
+
+void MetricHistogram::format( std::string& text, const std::string& name, const std::string& labels ) const {
+    std::string sep = labels.empty() ? "" : ",";
+    uint64_t cumulated = 0;
+    for( size_t i = 0; i < mBounds.size(); i++ ) {
+        cumulated += mBuckets[i].load( std::memory_order_relaxed );
+        text += fmt::format( "{}_bucket{{{}{}le=\"{}\"}} {}\n", name, labels, sep, formatFloat( mBounds[i] ), cumulated );
+    }
+    cumulated += mBuckets[mBounds.size()].load( std::memory_order_relaxed );
+    // Count is derived from the buckets so that the samples stay consistent while recording
+    text += fmt::format( "{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, sep, cumulated );
+    std::string label_set = labels.empty() ? "" : fmt::format( "{{{}}}", labels );
+    text += fmt::format( "{}_sum{} {}\n", name, label_set,
+                         formatFloat( (double)mSumNs.load( std::memory_order_relaxed ) / 1e9 ) );
+    text += fmt::format( "{}_count{} {}\n", name, label_set, cumulated );
+}
+
+
+LatencyHistogram::LatencyHistogram() : mShards( new Shard[NB_SHARDS] ) {
+    for( uint32_t s = 0; s < NB_SHARDS; s++ ) {
+        for( uint32_t i = 0; i < NB_BUCKETS; i++ )
+            mShards[s].buckets[i].store( 0 );
+        mShards[s].sumNs.store( 0 );
+        mShards[s].maxNs.store( 0 );
+    }
+}
+
+uint32_t LatencyHistogram::bucketIndex( uint64_t ns ) {
+    if ( ns < ( 1ULL << MIN_EXPONENT ) )
+        return 0;
+    uint32_t exponent = 63 - __builtin_clzll( ns );
+    if ( exponent >= MAX_EXPONENT )
+        return NB_BUCKETS - 1;
+    uint32_t sub_bucket = ( ns >> ( exponent - SUB_BUCKET_BITS ) ) & ( ( 1 << SUB_BUCKET_BITS ) - 1 );
+    return ( ( exponent - MIN_EXPONENT ) << SUB_BUCKET_BITS ) + sub_bucket + 1;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound( uint32_t index ) {
+    if ( index == 0 )
+        return 1ULL << MIN_EXPONENT;
+    if ( index >= NB_BUCKETS - 1 )
+        return UINT64_MAX;
+    uint32_t exponent = ( ( index - 1 ) >> SUB_BUCKET_BITS ) + MIN_EXPONENT;
+    uint64_t sub_bucket = ( index - 1 ) & ( ( 1 << SUB_BUCKET_BITS ) - 1 );
+    return ( 1ULL << exponent ) + ( ( sub_bucket + 1 ) << ( exponent - SUB_BUCKET_BITS ) );
+}
+
+void LatencyHistogram::record( uint64_t ns ) {
+    static std::atomic<uint32_t> sNextThread{ 0 };
+    static thread_local uint32_t shard_index = sNextThread++ % NB_SHARDS;
+    Shard& shard = mShards[shard_index];
+    shard.buckets[bucketIndex( ns )].fetch_add( 1, std::memory_order_relaxed );
+    shard.sumNs.fetch_add( ns, std::memory_order_relaxed );
+    uint64_t max = shard.maxNs.load( std::memory_order_relaxed );
+    while( ( ns > max ) && !shard.maxNs.compare_exchange_weak( max, ns, std::memory_order_relaxed ) );
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign( NB_BUCKETS, 0 );
+    for( uint32_t s = 0; s < NB_SHARDS; s++ ) {
+        for( uint32_t i = 0; i < NB_BUCKETS; i++ ) {
+            uint64_t n = mShards[s].buckets[i].load( std::memory_order_relaxed );
+            snapshot.buckets[i] += n;
+            snapshot.count += n;
+        }
+        snapshot.sumNs += mShards[s].sumNs.load( std::memory_order_relaxed );
+        snapshot.maxNs = std::max( snapshot.maxNs, mShards[s].maxNs.load( std::memory_order_relaxed ) );
+    }
+    return snapshot;
+}
+
+uint64_t LatencyHistogram::Snapshot::quantileNs( double quantile ) const {
+    if ( count == 0 )
+        return 0;
+    uint64_t rank = (uint64_t)ceil( quantile * (double)count );
+    if ( rank == 0 )
+        rank = 1;
+    uint64_t cumulated = 0;
+    for( uint32_t i = 0; i < buckets.size(); i++ ) {
+        cumulated += buckets[i];
+        if ( cumulated >= rank )
+            return std::min( bucketUpperBound( i ), maxNs );
+    }
+    return maxNs;
+}
+
+
+Metrics::Metrics()
+    : licenseRequestDuration( WS_REQUEST_BOUNDS ),
+      healthRequestDuration( WS_REQUEST_BOUNDS ),
+      wsRequestDuration( WS_REQUEST_BOUNDS ),
+      setLicenseDuration( CTRL_BOUNDS ),
+      statusWaitDuration( CTRL_BOUNDS ) {}
+
+Metrics& Metrics::instance() {
+    static Metrics* sMetrics = new Metrics();
+    return *sMetrics;
+}
+
+void Metrics::acquire( const void* owner, std::function<int64_t()> time_left, const std::string& endpoint ) {
+    std::lock_guard<std::mutex> server_lock( mServerMutex );
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        if ( mInstances.count( owner ) )
+            return;
+    }
+    bool use_endpoint = false;
+    if ( !endpoint.empty() ) {
+        if ( mEndpointUsers == 0 ) {
+            startServer( endpoint );
+            use_endpoint = true;
+        } else if ( endpoint == mEndpoint ) {
+            use_endpoint = true;
+        } else {
+            Warning( "Metrics endpoint '{}' ignored: statistics are already served on '{}'", endpoint, mEndpoint );
+        }
+        if ( use_endpoint )
+            mEndpointUsers++;
+    }
+    std::lock_guard<std::mutex> lock( mMutex );
+    mInstances[owner] = Instance{ mNextIndex++, time_left, use_endpoint };
+    sEnabled++;
+}
+
+void Metrics::release( const void* owner ) {
+    std::lock_guard<std::mutex> server_lock( mServerMutex );
+    bool use_endpoint;
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        auto it = mInstances.find( owner );
+        if ( it == mInstances.end() )
+            return;
+        use_endpoint = it->second.endpoint;
+        mInstances.erase( it );
+        sEnabled--;
+    }
+    // The server thread must be stopped without holding mMutex, used to format the statistics
+    if ( use_endpoint && ( --mEndpointUsers == 0 ) )
+        stopServer();
+}
+
+LatencyHistogram& Metrics::controllerOperation( const std::string& call ) {
+    // Extract the function name from the call expression, e.g. "getDrmController().activate( key )"
+    size_t start = call.find( "()." );
+    start = ( start == std::string::npos ) ? 0 : start + 3;
+    size_t end = call.find( '(', start );
+    std::string name = call.substr( start, ( end == std::string::npos ) ? std::string::npos : end - start );
+
+    std::lock_guard<std::mutex> lock( mOperationsMutex );
+    std::unique_ptr<LatencyHistogram>& histogram = mOperations[name];
+    if ( !histogram )
+        histogram.reset( new LatencyHistogram() );
+    return *histogram;
+}
+
+std::map<std::string, LatencyHistogram::Snapshot> Metrics::controllerOperations() const {
+    std::map<std::string, LatencyHistogram::Snapshot> snapshots;
+    std::lock_guard<std::mutex> lock( mOperationsMutex );
+    for( const auto& it: mOperations )
+        snapshots[it.first] = it.second->snapshot();
+    return snapshots;
+}
+
+std::string Metrics::format() const {
+    std::string text;
+
+    formatHeader( text, "drm_license_request_seconds", "histogram",
+                  "Duration of the license requests to the License Web Service, retries included." );
+    licenseRequestDuration.format( text, "drm_license_request_seconds" );
+    formatCounter( text, "drm_license_request_retries", "Number of retries of the license requests.",
+                   licenseRequestRetries );
+    formatCounter( text, "drm_license_request_errors", "Number of failed license requests.",
+                   licenseRequestErrors );
+
+    formatHeader( text, "drm_health_request_seconds", "histogram",
+                  "Duration of the health requests to the License Web Service, retries included." );
+    healthRequestDuration.format( text, "drm_health_request_seconds" );
+    formatCounter( text, "drm_health_request_retries", "Number of retries of the health requests.",
+                   healthRequestRetries );
+    formatCounter( text, "drm_health_request_errors", "Number of failed health requests.",
+                   healthRequestErrors );
+
+    formatCounter( text, "drm_oauth2_token_refreshes", "Number of OAuth2 tokens requested.", oauth2Refreshes );
+    formatHeader( text, "drm_ws_http_request_seconds", "histogram",
+                  "Duration of each HTTP request to the Web Service." );
+    wsRequestDuration.format( text, "drm_ws_http_request_seconds" );
+    formatCounter( text, "drm_ws_http_request_errors", "Number of HTTP requests which failed or returned an error code.",
+                   wsRequestErrors );
+
+    formatHeader( text, "drm_set_license_seconds", "histogram",
+                  "Duration of the provisioning of a license in the DRM Controller." );
+    setLicenseDuration.format( text, "drm_set_license_seconds" );
+    formatHeader( text, "drm_status_wait_seconds", "histogram",
+                  "Time spent waiting for the DRM Controller status registers." );
+    statusWaitDuration.format( text, "drm_status_wait_seconds" );
+    formatCounter( text, "drm_licenses_loaded", "Number of licenses provisioned in the DRM Controllers.",
+                   licensesLoaded );
+    formatCounter( text, "drm_register_reads", "Number of DRM Controller register reads.", registerReads );
+    formatCounter( text, "drm_register_writes", "Number of DRM Controller register writes.", registerWrites );
+    formatCounter( text, "drm_register_errors", "Number of DRM Controller register accesses which failed.",
+                   registerErrors );
+
+    // Controller operation latencies, with a bucket every 4 powers of two from 1 us
+    formatHeader( text, "drm_controller_operation_seconds", "histogram",
+                  "Duration of the DRM Controller operations." );
+    for( const auto& it: controllerOperations() ) {
+        const LatencyHistogram::Snapshot& snapshot = it.second;
+        uint64_t cumulated = 0;
+        uint32_t index = 0;
+        for( uint32_t exponent = 10; exponent <= LatencyHistogram::MAX_EXPONENT; exponent += 2 ) {
+            uint64_t bound = 1ULL << exponent;
+            while( LatencyHistogram::bucketUpperBound( index ) <= bound )
+                cumulated += snapshot.buckets[index++];
+            text += fmt::format( "drm_controller_operation_seconds_bucket{{operation=\"{}\",le=\"{}\"}} {}\n",
+                                 it.first, formatFloat( (double)bound / 1e9 ), cumulated );
+        }
+        text += fmt::format( "drm_controller_operation_seconds_bucket{{operation=\"{}\",le=\"+Inf\"}} {}\n",
+                             it.first, snapshot.count );
+        text += fmt::format( "drm_controller_operation_seconds_sum{{operation=\"{}\"}} {}\n",
+                             it.first, formatFloat( (double)snapshot.sumNs / 1e9 ) );
+        text += fmt::format( "drm_controller_operation_seconds_count{{operation=\"{}\"}} {}\n",
+                             it.first, snapshot.count );
+    }
+
+    formatHeader( text, "drm_license_time_left_seconds", "gauge",
+                  "Time left before the expiration of the licenses provisioned by each DRM Manager." );
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        for( const auto& it: mInstances )
+            text += fmt::format( "drm_license_time_left_seconds{{instance=\"{}\"}} {}\n",
+                                 it.second.index, it.second.timeLeft() );
+    }
+    text += "# EOF\n";
+    return text;
+}
+
+void Metrics::startServer( const std::string& endpoint ) {
+    int fd;
+    if ( endpoint.compare( 0, ENDPOINT_UNIX.size(), ENDPOINT_UNIX ) == 0 ) {
+        std::string path = endpoint.substr( ENDPOINT_UNIX.size() );
+        struct sockaddr_un addr;
+        memset( &addr, 0, sizeof( addr ) );
+        if ( path.empty() || ( path.size() >= sizeof( addr.sun_path ) ) )
+            Throw( DRM_BadArg, "Invalid metrics endpoint '{}': bad socket path. ", endpoint );
+        addr.sun_family = AF_UNIX;
+        strncpy( addr.sun_path, path.c_str(), sizeof( addr.sun_path ) - 1 );
+        removeStaleSocket( path );
+        fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+        if ( fd < 0 )
+            Throw( DRM_ExternFail, "Failed to create metrics socket: {}. ", strerror( errno ) );
+        if ( bind( fd, (struct sockaddr*)&addr, sizeof( addr ) ) ) {
+            close( fd );
+            Throw( DRM_ExternFail, "Failed to bind metrics socket to {}: {}. ", path, strerror( errno ) );
+        }
+    } else if ( endpoint.compare( 0, ENDPOINT_TCP.size(), ENDPOINT_TCP ) == 0 ) {
+        int port = 0;
+        try {
+            port = std::stoi( endpoint.substr( ENDPOINT_TCP.size() ) );
+        } catch( const std::exception& ) {}
+        if ( ( port <= 0 ) || ( port > 65535 ) )
+            Throw( DRM_BadArg, "Invalid metrics endpoint '{}': bad port number. ", endpoint );
+        struct sockaddr_in addr;
+        memset( &addr, 0, sizeof( addr ) );
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons( (uint16_t)port );
+        addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        fd = socket( AF_INET, SOCK_STREAM, 0 );
+        if ( fd < 0 )
+            Throw( DRM_ExternFail, "Failed to create metrics socket: {}. ", strerror( errno ) );
+        int reuse = 1;
+        setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof( reuse ) );
+        if ( bind( fd, (struct sockaddr*)&addr, sizeof( addr ) ) ) {
+            close( fd );
+            Throw( DRM_ExternFail, "Failed to bind metrics socket to 127.0.0.1:{}: {}. ", port, strerror( errno ) );
+        }
+    } else {
+        Throw( DRM_BadArg, "Invalid metrics endpoint '{}': must start with '{}' or '{}'. ",
+               endpoint, ENDPOINT_UNIX, ENDPOINT_TCP );
+    }
+    if ( listen( fd, 8 ) ) {
+        close( fd );
+        Throw( DRM_ExternFail, "Failed to listen on metrics endpoint {}: {}. ", endpoint, strerror( errno ) );
+    }
+    mServerFd = fd;
+    mEndpoint = endpoint;
+    mServerStop = false;
+    mServerThread = std::thread( &Metrics::serve, this );
+    Debug( "Serving metrics on {}", endpoint );
+}
+
+void Metrics::stopServer() {
+    if ( !mServerThread.joinable() )
+        return;
+    mServerStop = true;
+    mServerThread.join();
+    close( mServerFd );
+    mServerFd = -1;
+    if ( mEndpoint.compare( 0, ENDPOINT_UNIX.size(), ENDPOINT_UNIX ) == 0 )
+        unlink( mEndpoint.substr( ENDPOINT_UNIX.size() ).c_str() );
+    mEndpoint.clear();
+}
+
+void Metrics::serve() {
+    struct pollfd pfd;
+    pfd.fd = mServerFd;
+    pfd.events = POLLIN;
+    while( !mServerStop ) {
+        if ( poll( &pfd, 1, SERVER_POLL_PERIOD_MS ) <= 0 )
+            continue;
+        int client = accept( mServerFd, NULL, NULL );
+        if ( client < 0 )
+            continue;
+        // Consume the request, whatever it is: the same document is always returned
+        struct timeval tv = { 0, SERVER_POLL_PERIOD_MS * 1000 };
+        setsockopt( client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+        // A client which does not read the response must not block the server
+        struct timeval send_tv = { SERVER_SEND_TIMEOUT_MS / 1000, ( SERVER_SEND_TIMEOUT_MS % 1000 ) * 1000 };
+        setsockopt( client, SOL_SOCKET, SO_SNDTIMEO, &send_tv, sizeof( send_tv ) );
+        TClock::time_point send_deadline = TClock::now() + std::chrono::milliseconds( SERVER_SEND_TIMEOUT_MS );
+        char request[1024];
+        if ( recv( client, request, sizeof( request ), 0 ) >= 0 ) {
+            std::string body = format();
+            std::string response = fmt::format(
+                    "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                    "Content-Length: {}\r\n"
+                    "Connection: close\r\n\r\n", body.size() );
+            response += body;
+            size_t sent = 0;
+            while( ( sent < response.size() ) && ( TClock::now() < send_deadline ) ) {
+                ssize_t n = send( client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL );
+                if ( n <= 0 )
+                    break;
+                sent += (size_t)n;
+            }
+        }
+        close( client );
+    }
+}
+
+
+}
+}
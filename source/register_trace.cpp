@@ -0,0 +1,109 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <fstream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "register_trace.h"
+#include "accelize/drm/error.h"
+#include "log.h"
+
+
+namespace Accelize {
+namespace DRM {
+
+
+static uint32_t getThreadId() {
+    static thread_local uint32_t tid = (uint32_t)syscall( SYS_gettid );
+    return tid;
+}
+
+RegisterTrace::RegisterTrace( size_t capacity ) : mMask( 0 ), mIndex( 0 ) {
+    size_t size = 1;
+    while( size < capacity )
+        size <<= 1;
+    mEntries.resize( size );
+    mSequences.reset( new std::atomic<uint64_t>[size] );
+    for( size_t i = 0; i < size; i++ )
+        mSequences[i].store( 0, std::memory_order_relaxed );
+    mMask = size - 1;
+}
+
+void RegisterTrace::record( uint8_t access, uint32_t page, uint32_t offset, uint32_t value,
+                            const TClock::time_point& start, int32_t errcode ) {
+    TClock::time_point end = TClock::now();
+    RegisterTraceEntry entry;
+    entry.timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( start.time_since_epoch() ).count();
+    entry.thread = getThreadId();
+    entry.offset = offset;
+    entry.value = value;
+    entry.latency = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>( end - start ).count();
+    entry.access = access;
+    entry.page = ( page > 0xFF ) ? 0xFF : (uint8_t)page;
+    entry.errcode = (uint16_t)errcode;
+    entry.reserved = 0;
+
+    uint64_t idx = mIndex.fetch_add( 1, std::memory_order_relaxed );
+    size_t slot = idx & mMask;
+    mSequences[slot].store( 2 * idx + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    memcpy( &mEntries[slot], &entry, sizeof( entry ) );
+    mSequences[slot].store( 2 * idx + 2, std::memory_order_release );
+}
+
+size_t RegisterTrace::dump( const std::string& file_path, uint32_t ctrl_version ) const {
+    uint64_t index = mIndex.load( std::memory_order_acquire );
+    uint64_t first = ( index < mEntries.size() ) ? 0 : index - mEntries.size();
+
+    // Copy the entries which are completely written and not overwritten during the copy
+    std::vector<RegisterTraceEntry> entries;
+    entries.reserve( (size_t)( index - first ) );
+    for( uint64_t i = first; i < index; i++ ) {
+        size_t slot = i & mMask;
+        uint64_t seq = mSequences[slot].load( std::memory_order_acquire );
+        if ( seq != 2 * i + 2 )
+            continue;
+        RegisterTraceEntry entry;
+        memcpy( &entry, &mEntries[slot], sizeof( entry ) );
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if ( mSequences[slot].load( std::memory_order_relaxed ) != seq )
+            continue;
+        entries.push_back( entry );
+    }
+    uint64_t count = entries.size();
+    uint64_t overwritten = index - count;
+
+    std::ofstream ofs( file_path, std::ios::binary | std::ios::trunc );
+    if ( !ofs )
+        Throw( DRM_ExternFail, "Unable to create register trace file {}: {}. ", file_path, strerror( errno ) );
+
+    const char magic[8] = { 'D', 'R', 'M', 'T', 'R', 'A', 'C', 'E' };
+    uint32_t header[4] = { FORMAT_VERSION, (uint32_t)sizeof( RegisterTraceEntry ), ctrl_version, 0 };
+    ofs.write( magic, sizeof( magic ) );
+    ofs.write( reinterpret_cast<const char*>( header ), sizeof( header ) );
+    ofs.write( reinterpret_cast<const char*>( &count ), sizeof( count ) );
+    ofs.write( reinterpret_cast<const char*>( &overwritten ), sizeof( overwritten ) );
+    ofs.write( reinterpret_cast<const char*>( entries.data() ), count * sizeof( RegisterTraceEntry ) );
+    if ( !ofs )
+        Throw( DRM_ExternFail, "Failed to write register trace file {}. ", file_path );
+    return (size_t)count;
+}
+
+
+}
+}
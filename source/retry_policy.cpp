@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include "retry_policy.h"
+#include "accelize/drm/error.h"
+#include "log.h"
+#include "utils.h"
+
+
+namespace Accelize {
+namespace DRM {
+
+
+double uniformRandom( double min_value, double max_value ) {
+    // Each thread has its own generator, seeded differently on each host and in each process
+    static thread_local std::mt19937_64 generator( std::random_device{}() );
+    if ( max_value <= min_value )
+        return min_value;
+    return std::uniform_real_distribution<double>( min_value, max_value )( generator );
+}
+
+
+RetryPolicy RetryPolicy::fromJson( const Json::Value& json_value, const std::string& name ) {
+    RetryPolicy policy;
+    if ( json_value.isNull() )
+        return policy;
+    if ( !json_value.isObject() )
+        Throw( DRM_BadArg, "Invalid value for {}: must be an object. ", name );
+    policy.enabled = JVgetOptional( json_value, "enabled", Json::booleanValue, true ).asBool();
+    policy.basePeriod = JVgetOptional( json_value, "base_period", Json::realValue, policy.basePeriod ).asDouble();
+    policy.maxPeriod = JVgetOptional( json_value, "max_period", Json::realValue, policy.maxPeriod ).asDouble();
+    policy.multiplier = JVgetOptional( json_value, "multiplier", Json::realValue, policy.multiplier ).asDouble();
+    policy.deadlineRatio = JVgetOptional( json_value, "deadline_ratio", Json::realValue, policy.deadlineRatio ).asDouble();
+    if ( policy.basePeriod <= 0 )
+        Throw( DRM_BadArg, "Invalid value for {}.base_period: {}, must be greater than 0. ", name, policy.basePeriod );
+    if ( policy.maxPeriod < policy.basePeriod )
+        Throw( DRM_BadArg, "Invalid value for {}.max_period: {}, must be greater than or equal to base_period ({}). ",
+               name, policy.maxPeriod, policy.basePeriod );
+    if ( policy.multiplier < 1 )
+        Throw( DRM_BadArg, "Invalid value for {}.multiplier: {}, must be greater than or equal to 1. ",
+               name, policy.multiplier );
+    if ( ( policy.deadlineRatio <= 0 ) || ( policy.deadlineRatio > 1 ) )
+        Throw( DRM_BadArg, "Invalid value for {}.deadline_ratio: {}, must be in ]0, 1]. ",
+               name, policy.deadlineRatio );
+    return policy;
+}
+
+Json::Value RetryPolicy::toJson() const {
+    Json::Value json_value;
+    json_value["enabled"] = enabled;
+    json_value["base_period"] = basePeriod;
+    json_value["max_period"] = maxPeriod;
+    json_value["multiplier"] = multiplier;
+    json_value["deadline_ratio"] = deadlineRatio;
+    return json_value;
+}
+
+
+RetryBackoff::TClock::duration RetryBackoff::next( const TClock::time_point& deadline, int32_t retry_after_ms ) {
+    double time_left = std::max( 0.0, std::chrono::duration<double>( deadline - TClock::now() ).count() );
+
+    // Upper bound of the wait: exponential growth, then limited by the deadline
+    double bound = mPolicy.basePeriod * std::pow( mPolicy.multiplier, (double)std::min<uint32_t>( mAttempt, 64 ) );
+    bound = std::min( { bound, mPolicy.maxPeriod, time_left * mPolicy.deadlineRatio } );
+    mAttempt++;
+
+    double wait = uniformRandom( 0, bound );
+    if ( retry_after_ms >= 0 ) {
+        double retry_after = retry_after_ms / 1000.0;
+        if ( retry_after < time_left )
+            wait = std::max( wait, retry_after );
+        else
+            Debug( "Retry-After delay of {} s ignored: it ends after the deadline", retry_after );
+    }
+    return std::chrono::duration_cast<TClock::duration>( std::chrono::duration<double>( wait ) );
+}
+
+
+}
+}
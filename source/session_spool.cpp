@@ -0,0 +1,164 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "session_spool.h"
+#include "accelize/drm/error.h"
+#include "log.h"
+#include "utils.h"
+
+
+namespace Accelize {
+namespace DRM {
+
+
+static const char* cSpoolExtension = ".json";
+
+static bool hasSpoolExtension( const std::string& name ) {
+    size_t ext_len = strlen( cSpoolExtension );
+    return ( name.size() > ext_len ) && ( name.compare( name.size() - ext_len, ext_len, cSpoolExtension ) == 0 );
+}
+
+SessionSpool::SessionSpool( const std::string& dir_path ) : mDirPath( dir_path ) {
+    if ( !makeDirs( mDirPath, 0700 ) )
+        Throw( DRM_ExternFail, "Failed to create the session spool directory '{}'. ", mDirPath );
+}
+
+std::string SessionSpool::push( const std::string& session_id, const Json::Value& request_json ) const {
+    uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch() ).count();
+    std::string file_path = fmt::format( "{}{}{:020}_{}{}", mDirPath, PATH_SEP, timestamp, session_id, cSpoolExtension );
+    std::string tmp_path = file_path + ".tmp";
+    std::string content = saveJsonToString( request_json );
+
+    // Write under a temporary name, then rename once the content is on disk
+    int fd = open( tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600 );
+    if ( fd < 0 )
+        Throw( DRM_ExternFail, "Unable to create session spool file {}: {}. ", tmp_path, strerror( errno ) );
+    ssize_t written = write( fd, content.data(), content.size() );
+    bool synced = ( fsync( fd ) == 0 );
+    close( fd );
+    if ( ( written != (ssize_t)content.size() ) || !synced || rename( tmp_path.c_str(), file_path.c_str() ) ) {
+        int err = errno;
+        unlink( tmp_path.c_str() );
+        Throw( DRM_ExternFail, "Failed to write session spool file {}: {}. ", file_path, strerror( err ) );
+    }
+
+    // Sync the directory entry
+    int dir_fd = open( mDirPath.c_str(), O_RDONLY );
+    if ( dir_fd >= 0 ) {
+        fsync( dir_fd );
+        close( dir_fd );
+    }
+    Debug( "Saved close request of session {} in spool file {}", session_id, file_path );
+    return file_path;
+}
+
+std::vector<std::string> SessionSpool::list() const {
+    std::vector<std::string> names;
+    DIR* dir = opendir( mDirPath.c_str() );
+    if ( dir == NULL )
+        return names;
+    struct dirent* entry;
+    while( ( entry = readdir( dir ) ) != NULL ) {
+        std::string name( entry->d_name );
+        if ( hasSpoolExtension( name ) )
+            names.push_back( name );
+    }
+    closedir( dir );
+    // File names start with a fixed width timestamp
+    std::sort( names.begin(), names.end() );
+    std::vector<std::string> paths;
+    for( const std::string& name: names )
+        paths.push_back( mDirPath + PATH_SEP + name );
+    return paths;
+}
+
+SessionSpool::FlushResult SessionSpool::flush( DrmWSClient& ws_client, const std::atomic<bool>& abort_flag ) const {
+    FlushResult result;
+
+    for( const std::string& file_path: list() ) {
+        if ( abort_flag.load() )
+            break;
+
+        // Lock the file so that a single process posts the request
+        int fd = open( file_path.c_str(), O_RDONLY );
+        if ( fd < 0 )
+            continue;   // Already posted by another process
+        struct stat info;
+        if ( ( flock( fd, LOCK_EX | LOCK_NB ) != 0 ) || ( fstat( fd, &info ) != 0 ) || ( info.st_nlink == 0 ) ) {
+            close( fd );
+            continue;   // Being posted, or already posted, by another process
+        }
+
+        bool remove_file = false;
+        bool stop = false;
+        std::string session_id;
+        try {
+            Json::Value request_json = parseJsonFile( file_path );
+            session_id = JVgetOptional( request_json, "sessionId", Json::stringValue, "" ).asString();
+            int32_t timeout_msec = ws_client.getRequestTimeoutMS();
+            // An authentication error says nothing about the request: it is kept in any case
+            try {
+                ws_client.requestOAuth2token( timeout_msec, &result.retryAfterMS );
+            } catch( const Exception& e ) {
+                if ( e.getErrCode() == DRM_Exit )
+                    throw;
+                Throw( DRM_WSMayRetry, "Authentication failed: {}", e.what() );
+            }
+            ws_client.requestLicense( request_json, timeout_msec, &result.retryAfterMS );
+            Info( "DRM session {} closed from spool file {}.", session_id, file_path );
+            result.posted ++;
+            remove_file = true;
+        } catch( const Exception& e ) {
+            switch( e.getErrCode() ) {
+                case DRM_BadFormat:
+                case DRM_WSReqError:
+                case DRM_WSRespError:
+                    // Posting this request again would fail the same way
+                    Error( "Dropping session spool file {}: {}", file_path, e.what() );
+                    result.dropped.push_back( session_id );
+                    remove_file = true;
+                    break;
+                case DRM_Exit:
+                    Debug( "Session spool flush aborted" );
+                    stop = true;
+                    break;
+                default:
+                    Warning( "Failed to post session spool file {}, keeping it for a next attempt: {}", file_path, e.what() );
+                    result.retry = true;
+                    stop = true;
+            }
+        }
+        if ( remove_file && unlink( file_path.c_str() ) )
+            Warning( "Failed to remove session spool file {}: {}", file_path, strerror( errno ) );
+        close( fd );
+        if ( stop )
+            break;
+    }
+    return result;
+}
+
+}
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "shared_mutex.h"
+
+
+namespace Accelize {
+namespace DRM {
+
+
+// Number of shared ownerships held by the current thread, over all the mutexes
+static thread_local uint32_t tSharedDepth = 0;
+
+
+void RecursiveSharedMutex::lock() {
+    std::unique_lock<std::mutex> lock( mMutex );
+    std::thread::id self = std::this_thread::get_id();
+    if ( mOwnerDepth && ( mOwner == self ) ) {
+        mOwnerDepth++;
+        return;
+    }
+    mWaitingWriters++;
+    mCondVar.wait( lock, [this]{ return ( mOwnerDepth == 0 ) && ( mSharedCount == 0 ); } );
+    mWaitingWriters--;
+    mOwner = self;
+    mOwnerDepth = 1;
+}
+
+void RecursiveSharedMutex::unlock() {
+    std::lock_guard<std::mutex> lock( mMutex );
+    if ( --mOwnerDepth == 0 ) {
+        mOwner = std::thread::id();
+        mCondVar.notify_all();
+    }
+}
+
+void RecursiveSharedMutex::lock_shared() {
+    std::unique_lock<std::mutex> lock( mMutex );
+    if ( mOwnerDepth && ( mOwner == std::this_thread::get_id() ) ) {
+        // Already owned exclusively by this thread
+        mOwnerDepth++;
+        return;
+    }
+    if ( tSharedDepth )
+        // A nested shared section must not wait for the queued writers: they wait for this thread
+        mCondVar.wait( lock, [this]{ return mOwnerDepth == 0; } );
+    else
+        mCondVar.wait( lock, [this]{ return ( mOwnerDepth == 0 ) && ( mWaitingWriters == 0 ); } );
+    mSharedCount++;
+    tSharedDepth++;
+}
+
+void RecursiveSharedMutex::unlock_shared() {
+    std::lock_guard<std::mutex> lock( mMutex );
+    if ( mOwnerDepth && ( mOwner == std::this_thread::get_id() ) ) {
+        mOwnerDepth--;
+        return;
+    }
+    tSharedDepth--;
+    if ( --mSharedCount == 0 )
+        mCondVar.notify_all();
+}
+
+
+}
+}
@@ -19,6 +19,11 @@ limitations under the License.
 #include <sys/stat.h>
 #if defined(_WIN32)
 #include <direct.h>   // _mkdir
+#else
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #endif
 
 #include "utils.h"
@@ -106,6 +111,34 @@ bool makeDirs( const std::string& dir_path, mode_t mode ) {
     return isDir( dir_path );
 }
 
+void removeStaleSocket( const std::string& socket_path ) {
+#if !defined(_WIN32)
+    struct stat st;
+    if ( lstat( socket_path.c_str(), &st ) )
+        return;
+    if ( !S_ISSOCK( st.st_mode ) )
+        Throw( DRM_BadUsage, "Cannot create socket {}: the path exists and is not a socket. ", socket_path );
+    // A socket accepting connections belongs to a running process and is kept
+    struct sockaddr_un addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    strncpy( addr.sun_path, socket_path.c_str(), sizeof( addr.sun_path ) - 1 );
+    int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( fd < 0 )
+        Throw( DRM_ExternFail, "Failed to create socket: {}. ", strerror( errno ) );
+    int ret = connect( fd, (struct sockaddr*)&addr, sizeof( addr ) );
+    int err = errno;
+    close( fd );
+    if ( ret == 0 )
+        Throw( DRM_BadUsage, "Socket {} is already served by another process. ", socket_path );
+    if ( err != ECONNREFUSED )
+        Throw( DRM_ExternFail, "Failed to check socket {}: {}. ", socket_path, strerror( err ) );
+    Debug( "Removing stale socket {}", socket_path );
+    if ( unlink( socket_path.c_str() ) && ( errno != ENOENT ) )
+        Throw( DRM_ExternFail, "Failed to remove stale socket {}: {}. ", socket_path, strerror( errno ) );
+#endif
+}
+
 
 std::string typeToString( const Json::ValueType& type ) {
     std::string sType;
@@ -334,5 +367,15 @@ uint64_t str2int64( std::string num_str )
 }
 
 
+uint32_t getDrmRegisterOffset( const std::string& regName )
+{
+    if ( regName == "DrmPageRegister" )
+        return 0;
+    if ( regName.substr( 0, 15 ) == "DrmRegisterLine" )
+        return (uint32_t)std::stoul( regName.substr( 15 ) ) * 4 + 4;
+    Unreachable( "Unsupported regName argument: {}. ", regName ); //LCOV_EXCL_LINE
+}
+
+
 }
 }
@@ -16,6 +16,9 @@ limitations under the License.
 
 #include <iostream>
 #include <sstream>
+#include <cctype>
+#include <ctime>
+#include <algorithm>
 #include <curl/curl.h>
 #include <chrono>
 #include <unistd.h>
@@ -24,6 +27,7 @@ limitations under the License.
 #include "log.h"
 #include "utils.h"
 #include "ws_client.h"
+#include "metrics.h"
 
 namespace Accelize {
 namespace DRM {
@@ -34,6 +38,8 @@ CurlEasyPost::CurlEasyPost( const uint32_t& connection_timeout_ms ) {
     if ( !mCurl )
         Throw( DRM_ExternFail, "Curl : cannot init curl_easy" );
     curl_easy_setopt( mCurl, CURLOPT_WRITEFUNCTION, &CurlEasyPost::curl_write_callback );
+    curl_easy_setopt( mCurl, CURLOPT_HEADERFUNCTION, &CurlEasyPost::curl_header_callback );
+    curl_easy_setopt( mCurl, CURLOPT_HEADERDATA, this );
     curl_easy_setopt( mCurl, CURLOPT_ERRORBUFFER, mErrBuff.data() );
     curl_easy_setopt( mCurl, CURLOPT_FOLLOWLOCATION, 1L );
     curl_easy_setopt( mCurl, CURLOPT_NOPROGRESS, 1L);
@@ -83,24 +89,72 @@ void CurlEasyPost::setPostFields( const std::string& postfields ) {
     curl_easy_setopt( mCurl, CURLOPT_COPYPOSTFIELDS, postfields.c_str() );
 }
 
+void CurlEasyPost::parseRetryAfter( const std::string& header ) {
+    static const std::string name( "retry-after:" );
+    if ( header.size() <= name.size() )
+        return;
+    for( size_t i = 0; i < name.size(); i++ ) {
+        if ( tolower( header[i] ) != name[i] )
+            return;
+    }
+    std::string value = header.substr( name.size() );
+    value.erase( 0, value.find_first_not_of( " \t" ) );
+    value.erase( value.find_last_not_of( " \t\r\n" ) + 1 );
+    if ( value.empty() )
+        return;
+    if ( isdigit( value[0] ) ) {
+        // Delay in seconds
+        mRetryAfterMS = (int32_t)std::min<unsigned long>( strtoul( value.c_str(), NULL, 10 ), INT32_MAX / 1000 ) * 1000;
+    } else {
+        // HTTP date
+        time_t date = curl_getdate( value.c_str(), NULL );
+        if ( date < 0 )
+            return;
+        time_t now = time( NULL );
+        mRetryAfterMS = ( date > now ) ? (int32_t)std::min<time_t>( date - now, INT32_MAX / 1000 ) * 1000 : 0;
+    }
+    Debug( "Server requested to retry after {} ms", mRetryAfterMS );
+}
+
+void CurlEasyPost::setAbortFlag( const std::atomic<bool>* abort_flag ) {
+    mAbortFlag = abort_flag;
+    if ( abort_flag == NULL ) {
+        curl_easy_setopt( mCurl, CURLOPT_NOPROGRESS, 1L );
+        return;
+    }
+    // The progress callback is called at least once per second, even when no data is transferred
+    curl_easy_setopt( mCurl, CURLOPT_XFERINFOFUNCTION, &CurlEasyPost::curl_xferinfo_callback );
+    curl_easy_setopt( mCurl, CURLOPT_XFERINFODATA, (void*)abort_flag );
+    curl_easy_setopt( mCurl, CURLOPT_NOPROGRESS, 0L );
+}
+
 uint32_t CurlEasyPost::perform( const std::string url, std::string* response, const int32_t timeout_msec ) {
     CURLcode res;
     uint32_t resp_code;
 
     if ( timeout_msec <= 0 )
         Throw( DRM_WSTimedOut, "Did not perform HTTP request to Accelize webservice because timeout is reached. " );
+    if ( mAbortFlag && mAbortFlag->load() )
+        Throw( DRM_Exit, "Did not perform HTTP request to Accelize webservice because exit is requested. " );
 
     // Configure and execute CURL command
+    mRetryAfterMS = -1;
     curl_easy_setopt( mCurl, CURLOPT_URL, url.c_str() );
     if ( mHeaders_p ) {
         curl_easy_setopt( mCurl, CURLOPT_HTTPHEADER, mHeaders_p );
     }
     curl_easy_setopt( mCurl, CURLOPT_WRITEDATA, response );
     curl_easy_setopt( mCurl, CURLOPT_TIMEOUT_MS, timeout_msec );
-    res = curl_easy_perform( mCurl );
+    {
+        MetricTimer metric_timer( Metrics::instance().wsRequestDuration );
+        res = curl_easy_perform( mCurl );
+    }
 
     // Analyze libcurl response
+    if ( ( res == CURLE_ABORTED_BY_CALLBACK ) && mAbortFlag && mAbortFlag->load() )
+        Throw( DRM_Exit, "HTTP request to Accelize webservice aborted because exit is requested. " );
     if ( res != CURLE_OK ) {
+        MetricInc( wsRequestErrors );
         // A libcurl error occurred
         if ( res == CURLE_COULDNT_RESOLVE_PROXY
           || res == CURLE_COULDNT_RESOLVE_HOST
@@ -114,6 +168,8 @@ uint32_t CurlEasyPost::perform( const std::string url, std::string* response, co
         }
     }
     curl_easy_getinfo( mCurl, CURLINFO_RESPONSE_CODE, &resp_code );
+    if ( httpCode2DrmCode( resp_code ) != DRM_OK )
+        MetricInc( wsRequestErrors );
     Debug( "Received code {} from {} in {} ms. ", resp_code, url, getTotalTime() * 1000 );
     return resp_code;
 }
@@ -127,10 +183,13 @@ double CurlEasyPost::getTotalTime() {
 
 
 
-DrmWSClient::DrmWSClient( const std::string &conf_file_path, const std::string &cred_file_path ) {
+DrmWSClient::DrmWSClient( const std::string &conf_file_path, const std::string &cred_file_path,
+                          const std::atomic<bool>* abort_flag ) {
 
     std::string url;
 
+    mAbortFlag = abort_flag;
+
     mOAuth2Token = std::string("");
     mTokenValidityPeriod = 0;
     mTokenExpirationMargin = cTokenExpirationMargin;
@@ -227,7 +286,7 @@ bool DrmWSClient::isTokenValid() const {
     }
 }
 
-void DrmWSClient::requestOAuth2token( int32_t timeout_msec ) {
+void DrmWSClient::requestOAuth2token( int32_t timeout_msec, int32_t* retry_after_ms ) {
 
     // Check if a token exists
     if ( !mOAuth2Token.empty() ) {
@@ -238,9 +297,11 @@ void DrmWSClient::requestOAuth2token( int32_t timeout_msec ) {
     }
 
     // Setup a request to get a new token
+    MetricInc( oauth2Refreshes );
     CurlEasyPost req( mConnectionTimeoutMS );
     req.setVerbosity( mVerbosity );
     req.setHostResolves( mHostResolvesJson );
+    req.setAbortFlag( mAbortFlag );
     std::stringstream ss;
     ss << "grant_type=client_credentials";
     ss << "&client_id=" << mClientId;
@@ -252,6 +313,8 @@ void DrmWSClient::requestOAuth2token( int32_t timeout_msec ) {
     if ( timeout_msec >= mRequestTimeoutMS )
         timeout_msec = mRequestTimeoutMS;
     Debug( "Starting OAuthentication request to {}", mOAuth2Url );
+    if ( retry_after_ms )
+        *retry_after_ms = -1;
     long resp_code = req.perform( mOAuth2Url, &response, timeout_msec );
 
     // Parse response
@@ -265,6 +328,8 @@ void DrmWSClient::requestOAuth2token( int32_t timeout_msec ) {
     }
     // Analyze response
     DRM_ErrorCode drm_error = CurlEasyPost::httpCode2DrmCode( resp_code );
+    if ( ( drm_error == DRM_WSMayRetry ) && retry_after_ms )
+        *retry_after_ms = req.getRetryAfterMS();
     if ( drm_error != DRM_OK )
         Throw( drm_error, "OAuth2 Web Service error {}: {}. ", resp_code, response );
 
@@ -279,12 +344,13 @@ void DrmWSClient::requestOAuth2token( int32_t timeout_msec ) {
 }
 
 Json::Value DrmWSClient::requestMetering( const std::string url, const Json::Value& json_req,
-                                          int32_t timeout_msec ) {
+                                          int32_t timeout_msec, int32_t* retry_after_ms ) {
 
     // Create new request
     CurlEasyPost req( mConnectionTimeoutMS );
     req.setVerbosity( mVerbosity );
     req.setHostResolves( mHostResolvesJson );
+    req.setAbortFlag( mAbortFlag );
     req.appendHeader( "Accept: application/vnd.accelize.v1+json" );
     req.appendHeader( "Content-Type: application/json" );
     std::string token_header("Authorization: Bearer ");
@@ -297,6 +363,8 @@ Json::Value DrmWSClient::requestMetering( const std::string url, const Json::Val
         timeout_msec = mRequestTimeoutMS;
     // Send request and wait response
     std::string response;
+    if ( retry_after_ms )
+        *retry_after_ms = -1;
     long resp_code = req.perform( url, &response, timeout_msec );
 
     // Parse response
@@ -313,6 +381,8 @@ Json::Value DrmWSClient::requestMetering( const std::string url, const Json::Val
     DRM_ErrorCode drm_error = CurlEasyPost::httpCode2DrmCode( resp_code );
     if ( resp_code == 401 )
         drm_error = DRM_WSError;
+    if ( ( drm_error == DRM_WSMayRetry ) && retry_after_ms )
+        *retry_after_ms = req.getRetryAfterMS();
     // An error occurred
     if ( drm_error != DRM_OK )
         Throw( drm_error, "Metering Web Service error {}: {}. ", resp_code, response );
@@ -326,14 +396,14 @@ Json::Value DrmWSClient::requestMetering( const std::string url, const Json::Val
     return json_resp;
 }
 
-Json::Value DrmWSClient::requestLicense( const Json::Value& json_req, int32_t timeout_msec ) {
+Json::Value DrmWSClient::requestLicense( const Json::Value& json_req, int32_t timeout_msec, int32_t* retry_after_ms ) {
     Debug( "Starting License request to {} with data:\n{}", mLicenseUrl, json_req.toStyledString() );
-    return requestMetering( mLicenseUrl, json_req, timeout_msec );
+    return requestMetering( mLicenseUrl, json_req, timeout_msec, retry_after_ms );
 }
 
-Json::Value DrmWSClient::requestHealth( const Json::Value& json_req, int32_t timeout_msec ) {
+Json::Value DrmWSClient::requestHealth( const Json::Value& json_req, int32_t timeout_msec, int32_t* retry_after_ms ) {
     Debug( "Starting Health request to {} with data:\n{}", mHealthUrl, json_req.toStyledString() );
-    return requestMetering( mHealthUrl, json_req, timeout_msec );
+    return requestMetering( mHealthUrl, json_req, timeout_msec, retry_after_ms );
 }
 
 }
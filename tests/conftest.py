@@ -669,7 +669,11 @@ def accelize_drm(pytestconfig):
         ref_designs = None
         print('No ref design available for this FPGA driver: %s' % fpga_driver_name)
 
-    if fpga_image is None or hdk_version:
+    if fpga_driver_name == 'simulator':
+        # The simulator models the DRM Controller of the specified HDK version: no FPGA image
+        if hdk_version:
+            hdk_version = hdk_version.strip('v')
+    elif fpga_image is None or hdk_version:
         # Use specified HDK version
         if hdk_version:
             hdk_version = hdk_version.strip('v')
@@ -713,6 +717,8 @@ def accelize_drm(pytestconfig):
         print('DRIVER EXTRA:', fpga_driver_extra)
     else:
         fpga_driver_extra = {}
+    if fpga_driver_name == 'simulator' and hdk_version:
+        fpga_driver_extra.setdefault('hdk_version', hdk_version)
     fpga_driver = list()
     for slot_id in fpga_slot_id:
         try:
@@ -971,7 +977,7 @@ def conf_json(request, pytestconfig, tmpdir, accelize_drm):
         log_param['log_file_append'] = pytestconfig.getoption("logfileappend")
     # Save config to JSON file
     drm_param = {}
-    if 'som' in accelize_drm.pytest_fpga_image:
+    if accelize_drm.pytest_fpga_image and 'som' in accelize_drm.pytest_fpga_image:
         drm_param.update({'drm_software': True, 'bypass_frequency_detection':True})
     json_conf = ConfJson(tmpdir, pytestconfig.getoption("server"), pytestconfig.getoption("drm_frequency"),
                         settings=log_param, design=design_param, drm=drm_param)
@@ -0,0 +1,276 @@
+# coding=utf-8
+"""
+Fault-injecting register bus.
+
+Wraps the register callbacks of any FPGA driver of "tests.fpga_drivers" to
+reproduce a slow or glitchy AXI-Lite access: configurable latency
+distributions, sporadic read and write errors and stuck status bits. Use it
+in place of the driver to instantiate accelize_drm.DrmManager:
+
+    bus = FaultInjectingBus(driver, read_latency=lognormal(50e-6, 1.0),
+                            read_error_rate=1e-4)
+    drm_manager = accelize_drm.DrmManager(conf_path, cred_path,
+        bus.read_register_callback, bus.write_register_callback, async_cb)
+
+The register offsets received by the callbacks are relative to the DRM
+Controller: offset 0 is the page register, offset 4 * (index + 1) is the
+register line "index" of the selected page.
+"""
+from math import log as _log
+from random import random as _random, uniform as _uniform, \
+    expovariate as _expovariate, lognormvariate as _lognormvariate
+from threading import Lock as _Lock
+from time import sleep as _sleep
+
+__all__ = ['FaultInjectingBus', 'constant', 'uniform', 'exponential',
+           'lognormal', 'spikes', 'STATUS_REGISTER', 'STATUS_BITS']
+
+# Location (page, index) of the DRM Controller status register
+STATUS_REGISTER = (0, 15)
+
+# Status register bit positions
+STATUS_BITS = {
+    'dna_ready': 0,
+    'vlnv_ready': 1,
+    'activation_done': 2,
+    'metering_ready': 6,
+    'license_timer_init_loaded': 9,
+    'end_session_metering_ready': 10,
+    'asynchronous_metering_ready': 12,
+    'license_timer_sample_ready': 13,
+    'session_running': 15,
+    'activation_codes_transmitted': 16,
+}
+
+
+def constant(delay):
+    """Fixed latency in seconds"""
+    return lambda: delay
+
+
+def uniform(low, high):
+    """Latency uniformly distributed between low and high seconds"""
+    return lambda: _uniform(low, high)
+
+
+def exponential(mean):
+    """Exponentially distributed latency of the specified mean in seconds"""
+    return lambda: _expovariate(1.0 / mean)
+
+
+def lognormal(median, sigma):
+    """Log-normally distributed latency: heavy tail above the median in seconds"""
+    mu = _log(median)
+    return lambda: _lognormvariate(mu, sigma)
+
+
+def spikes(base, rate, spike):
+    """
+    Latency of the "base" distribution with occasional spikes.
+
+    Args:
+        base (function): Latency distribution between the spikes.
+        rate (float): Probability of a spike on each access.
+        spike (function): Latency distribution of the spikes.
+    """
+    return lambda: spike() if _random() < rate else base()
+
+
+class FaultInjectingBus:
+    """
+    Register callbacks of a driver with injected faults.
+
+    Args:
+        driver (tests.fpga_drivers.FpgaDriverBase): Wrapped FPGA driver.
+        read_latency (function): Returns the latency in seconds added to each
+            read. None to add no latency.
+        write_latency (function): Returns the latency in seconds added to
+            each write. None to add no latency.
+        read_error_rate (float): Probability that a read returns an error.
+        write_error_rate (float): Probability that a write returns an error.
+        error_code (int): Code returned by the failing accesses.
+        stuck_bits (dict): Bits forced on read, as
+            {(page, index): (mask, value)}. See "stick" and "STATUS_REGISTER".
+    """
+
+    _CONFIG = ('read_latency', 'write_latency', 'read_error_rate',
+               'write_error_rate', 'error_code', 'stuck_bits')
+
+    def __init__(self, driver, read_latency=None, write_latency=None,
+                 read_error_rate=0.0, write_error_rate=0.0, error_code=1,
+                 stuck_bits=None):
+        self._driver = driver
+        self._lock = _Lock()
+        self._page = None
+        self._in_flight = 0
+        self.read_latency = read_latency
+        self.write_latency = write_latency
+        self.read_error_rate = read_error_rate
+        self.write_error_rate = write_error_rate
+        self.error_code = error_code
+        self.stuck_bits = dict(stuck_bits or {})
+        self.reset_stats()
+        self._read_register_callback = self._get_read_register_callback()
+        self._write_register_callback = self._get_write_register_callback()
+
+    @property
+    def driver(self):
+        """Wrapped FPGA driver"""
+        return self._driver
+
+    @property
+    def read_register_callback(self):
+        """Read register callback to pass to "accelize_drm.DrmManager"."""
+        return self._read_register_callback
+
+    @property
+    def write_register_callback(self):
+        """Write register callback to pass to "accelize_drm.DrmManager"."""
+        return self._write_register_callback
+
+    def configure(self, **config):
+        """Update the fault configuration while the bus is in use"""
+        unknown = set(config) - set(self._CONFIG)
+        if unknown:
+            raise ValueError('Unknown fault configuration: %s' % ', '.join(sorted(unknown)))
+        with self._lock:
+            for key, value in config.items():
+                setattr(self, key, value)
+
+    def clear(self):
+        """Remove all the faults"""
+        self.configure(read_latency=None, write_latency=None, read_error_rate=0.0,
+                       write_error_rate=0.0, stuck_bits={})
+
+    def stick(self, bit, value, register=STATUS_REGISTER):
+        """
+        Force a bit on read.
+
+        Args:
+            bit (int or str): Bit position or name in "STATUS_BITS".
+            value (int): Forced bit value, 0 or 1.
+            register (tuple): Register location (page, index).
+        """
+        mask = 1 << STATUS_BITS.get(bit, bit)
+        with self._lock:
+            stuck_mask, stuck_value = self.stuck_bits.get(register, (0, 0))
+            self.stuck_bits[register] = (
+                stuck_mask | mask, (stuck_value & ~mask) | (mask if value else 0))
+
+    def unstick(self, register=STATUS_REGISTER):
+        """Release the bits forced on the specified register"""
+        with self._lock:
+            self.stuck_bits.pop(register, None)
+
+    def reset_stats(self):
+        """Reset the access statistics"""
+        with self._lock:
+            self._stats = dict(reads=0, writes=0, read_errors=0, write_errors=0,
+                               stuck_reads=0, delay_s=0.0, max_delay_s=0.0,
+                               max_concurrency=0)
+
+    def stats(self):
+        """
+        Access statistics.
+
+        Returns:
+            dict: Number of accesses, of injected errors, of reads altered by
+                stuck bits, total and maximum injected latency in seconds,
+                maximum number of callbacks running at the same time.
+        """
+        with self._lock:
+            return dict(self._stats)
+
+    def _enter(self):
+        """Account a callback call entering"""
+        with self._lock:
+            self._in_flight += 1
+            self._stats['max_concurrency'] = max(self._stats['max_concurrency'], self._in_flight)
+
+    def _leave(self):
+        """Account a callback call leaving"""
+        with self._lock:
+            self._in_flight -= 1
+
+    def _inject(self, access):
+        """Account an access, return its latency and if it fails"""
+        with self._lock:
+            latency = getattr(self, access + '_latency')
+            delay = max(0.0, latency()) if latency else 0.0
+            error = _random() < getattr(self, access + '_error_rate')
+            self._stats[access + 's'] += 1
+            self._stats['delay_s'] += delay
+            self._stats['max_delay_s'] = max(self._stats['max_delay_s'], delay)
+            if error:
+                self._stats[access + '_errors'] += 1
+        if delay:
+            _sleep(delay)
+        return error
+
+    def _location(self, register_offset):
+        """Return the (page, index) location of a register offset"""
+        if register_offset == 0:
+            return None
+        return self._page, (register_offset - 4) // 4
+
+    def _get_read_register_callback(self):
+        read_register = self._driver.read_register_callback
+
+        def read_register_faulty(register_offset, returned_data, bus=self):
+            """
+            Read register with injected faults.
+
+            Args:
+                register_offset (int): Offset
+                returned_data (int pointer): Return data.
+                bus (FaultInjectingBus): Keep a reference to the bus.
+            """
+            bus._enter()
+            try:
+                if bus._inject('read'):
+                    return bus.error_code
+                ret = read_register(register_offset, returned_data)
+                if ret or not bus.stuck_bits:
+                    return ret
+                stuck = bus.stuck_bits.get(bus._location(register_offset))
+                if stuck:
+                    mask, value = stuck
+                    # Pointer from ctypes callbacks or reference from "driver.read_register"
+                    data = getattr(returned_data, '_obj', None)
+                    if data is None:
+                        data = returned_data.contents
+                    data.value = (data.value & ~mask) | (value & mask)
+                    with bus._lock:
+                        bus._stats['stuck_reads'] += 1
+                return ret
+            finally:
+                bus._leave()
+
+        return read_register_faulty
+
+    def _get_write_register_callback(self):
+        write_register = self._driver.write_register_callback
+
+        def write_register_faulty(register_offset, data_to_write, bus=self):
+            """
+            Write register with injected faults.
+
+            Args:
+                register_offset (int): Offset
+                data_to_write (int): Data to write.
+                bus (FaultInjectingBus): Keep a reference to the bus.
+            """
+            bus._enter()
+            try:
+                if bus._inject('write'):
+                    if register_offset == 0:
+                        bus._page = None
+                    return bus.error_code
+                ret = write_register(register_offset, data_to_write)
+                if register_offset == 0:
+                    bus._page = None if ret else data_to_write
+                return ret
+            finally:
+                bus._leave()
+
+        return write_register_faulty
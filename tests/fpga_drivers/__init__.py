@@ -27,7 +27,8 @@ def get_driver(name):
     Args:
         name (str): Driver name. Possible values:
             `aws_f1` (AWS F1 instances types),
-            `aws_xrt` (AWS XRT).
+            `aws_xrt` (AWS XRT),
+            `simulator` (DRM Controller software model, no FPGA).
 
     Returns:
         FpgaDriverBase subclass: driver class.
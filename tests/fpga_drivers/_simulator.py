@@ -0,0 +1,207 @@
+# coding=utf-8
+"""
+DRM Controller simulator driver for Accelize DRM Python library
+
+Requires "libdrm_controller_sim" library built from "tests/simulator" with the
+"TESTS" CMake option.
+"""
+from ctypes import (
+    cdll as _cdll, POINTER as _POINTER, byref as _byref, c_uint32 as _c_uint32,
+    c_int as _c_int, c_char_p as _c_char_p, c_void_p as _c_void_p)
+from os.path import basename as _basename, dirname as _dirname, join as _join, isfile as _isfile
+from re import match as _match
+from threading import Lock as _Lock
+
+from tests.fpga_drivers import FpgaDriverBase as _FpgaDriverBase
+
+__all__ = ['FpgaDriver']
+
+_DEFAULT_HDK_VERSION = '7.0.0'
+
+
+class FpgaDriver(_FpgaDriverBase):
+    """
+    Generates functions to use the DRM Controller simulator with
+    accelize_drm.DrmManager.
+
+    There is no FPGA: the register accesses are served by a software model of
+    the DRM Controller and of the test activators.
+
+    Args:
+        fpga_slot_id (int): Unused with this driver.
+        fpga_image (str): Unused with this driver.
+        drm_ctrl_base_addr (int): DRM Controller base address.
+        log_dir (path-like object): Unused with this driver.
+        hdk_version (str): HDK version of the simulated DRM Controller.
+        nb_activators (int): Number of simulated activators.
+        drm_frequency (int): Frequency in MHz of the simulated DRM clock.
+    """
+    _name = _match(r'_(.+)\.py', _basename(__file__)).group(1)
+
+    @staticmethod
+    def _get_driver():
+        """
+        Get FPGA driver
+
+        Returns:
+            ctypes.CDLL: Simulator library.
+        """
+        # Use the library of the build directory if available
+        lib_path = _join(_dirname(_dirname(__file__)), 'libdrm_controller_sim.so')
+        if not _isfile(lib_path):
+            lib_path = 'libdrm_controller_sim.so'
+        return _cdll.LoadLibrary(lib_path)
+
+    @staticmethod
+    def _get_lock():
+        """
+        Get a lock on the FPGA driver
+        """
+        return _Lock
+
+    def _clear_fpga(self):
+        """
+        Clear FPGA
+        """
+
+    def _program_fpga(self, fpga_image):
+        """
+        Program the FPGA with the specified image.
+
+        Args:
+            fpga_image (str): FPGA image.
+        """
+
+    def _reset_fpga(self):
+        """
+        Reset FPGA including FPGA image: start a new simulator
+        """
+        self._uninit_fpga()
+        self._init_fpga()
+
+    def _init_fpga(self):
+        """
+        Initialize FPGA handle with driver library.
+        """
+        sim_alloc = self._fpga_library.DrmControllerSim_alloc
+        sim_alloc.restype = _c_int  # return code
+        sim_alloc.argtypes = (
+            _POINTER(_c_void_p),  # p_sim
+            _c_char_p,  # hdk_version
+            _c_uint32  # nb_activators
+        )
+        hdk_version = str(getattr(self, 'hdk_version', None) or _DEFAULT_HDK_VERSION).strip('v')
+        self._fpga_handle = _c_void_p()
+        if sim_alloc(_byref(self._fpga_handle), hdk_version.encode(),
+                     int(getattr(self, 'nb_activators', 1))):
+            raise RuntimeError(
+                "Unable to create a simulator of HDK version %s" % hdk_version)
+
+        drm_frequency = getattr(self, 'drm_frequency', None)
+        if drm_frequency:
+            sim_set_frequency = self._fpga_library.DrmControllerSim_set_frequency
+            sim_set_frequency.restype = _c_int  # return code
+            sim_set_frequency.argtypes = (_c_void_p, _c_uint32, _c_uint32)
+            if sim_set_frequency(self._fpga_handle, int(drm_frequency), 250):
+                raise RuntimeError(
+                    "Invalid simulator frequency: %s MHz" % drm_frequency)
+
+    def _uninit_fpga(self):
+        """
+        Release the simulator.
+        """
+        if getattr(self, '_fpga_handle', None):
+            sim_free = self._fpga_library.DrmControllerSim_free
+            sim_free.restype = None
+            sim_free.argtypes = (_POINTER(_c_void_p),)
+            sim_free(_byref(self._fpga_handle))
+            self._fpga_handle = None
+
+    @property
+    def native_registers(self):
+        """
+        Native register backend that accesses the simulator without Python.
+
+        Returns:
+            accelize_drm.registers.NativeRegisters: Register backend to pass
+                as "read_register" to "accelize_drm.DrmManager".
+        """
+        from accelize_drm.registers import NativeRegisters
+        return NativeRegisters(
+            self._fpga_library.DrmControllerSim_read_register_callback,
+            self._fpga_library.DrmControllerSim_write_register_callback,
+            self._fpga_handle, self._drm_ctrl_base_addr)
+
+    def _get_read_register_callback(self):
+        """
+        Read register callback.
+
+        Returns:
+            function: Read register callback
+        """
+        sim_read_register = self._fpga_library.DrmControllerSim_read_register
+        sim_read_register.restype = _c_int  # return code
+        sim_read_register.argtypes = (
+            _c_void_p,  # sim
+            _c_uint32,  # offset
+            _POINTER(_c_uint32)  # value
+        )
+        self._fpga_read_register = sim_read_register
+
+        def read_register(register_offset, returned_data, driver=self):
+            """
+            Read register.
+
+            Args:
+                register_offset (int): Offset
+                returned_data (int pointer): Return data.
+                driver (accelize_drm.fpga_drivers._simulator.FpgaDriver):
+                    Keep a reference to driver.
+            """
+            try:
+                with driver._fpga_register_lock():
+                    return driver._fpga_read_register(
+                        driver._fpga_handle,
+                        driver._drm_ctrl_base_addr + register_offset,
+                        returned_data)
+            except AttributeError:
+                return -1
+
+        return read_register
+
+    def _get_write_register_callback(self):
+        """
+        Write register callback.
+
+        Returns:
+            function: Write register callback
+        """
+        sim_write_register = self._fpga_library.DrmControllerSim_write_register
+        sim_write_register.restype = _c_int  # return code
+        sim_write_register.argtypes = (
+            _c_void_p,  # sim
+            _c_uint32,  # offset
+            _c_uint32  # value
+        )
+        self._fpga_write_register = sim_write_register
+
+        def write_register(register_offset, data_to_write, driver=self):
+            """
+            Write register.
+
+            Args:
+                register_offset (int): Offset
+                data_to_write (int): Data to write.
+                driver (accelize_drm.fpga_drivers._simulator.FpgaDriver):
+                    Keep a reference to driver.
+            """
+            try:
+                with driver._fpga_register_lock():
+                    return driver._fpga_write_register(
+                        driver._fpga_handle,
+                        driver._drm_ctrl_base_addr + register_offset,
+                        data_to_write)
+            except AttributeError:
+                return -1
+
+        return write_register
@@ -0,0 +1,618 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "drm_controller_sim.h"
+
+
+namespace {
+
+typedef std::chrono::steady_clock TClock;
+
+// Register line indexes of page 0, identical for all the HDK versions from 3.1.0
+const uint32_t IDX_COMMAND = 0;
+const uint32_t IDX_LICENSE_START_ADDRESS = 1;           // 2 words
+const uint32_t IDX_LICENSE_TIMER = 3;                   // 12 words
+const uint32_t NB_LICENSE_TIMER_WORDS = 12;
+const uint32_t IDX_STATUS = 15;
+const uint32_t IDX_ERROR = 16;
+const uint32_t IDX_DNA = 17;                            // 4 words
+const uint32_t IDX_SAAS_CHALLENGE = 21;                 // 4 words
+const uint32_t IDX_SAMPLED_LICENSE_TIMER_COUNT = 25;    // 2 words
+const uint32_t IDX_VERSION = 27;
+const uint32_t IDX_ADAPTIVE_PROPORTION_TEST = 28;       // From 4.2.0
+const uint32_t IDX_REPETITION_COUNT_TEST = 29;          // From 4.2.0
+
+// Pages
+enum : uint32_t { PAGE_REGISTERS = 0, PAGE_VLNV, PAGE_LICENSE, PAGE_TRACE, PAGE_METERING, PAGE_MAILBOX };
+const uint32_t MAX_PAGE_WORDS = 0x3FFB;                 // Register lines below the frequency detection registers
+
+// Commands
+const uint32_t CMD_EXTRACT_DNA = 0x001;
+const uint32_t CMD_EXTRACT_VLNV = 0x002;
+const uint32_t CMD_ACTIVATE = 0x004;
+const uint32_t CMD_NOP = 0x020;
+const uint32_t CMD_END_SESSION_EXTRACT_METERING = 0x040;
+const uint32_t CMD_EXTRACT_METERING = 0x080;
+const uint32_t CMD_SAMPLE_LICENSE_TIMER = 0x100;
+const uint32_t CMD_OPERATION_MASK = 0x1FF;
+const uint32_t CMD_SEMAPHORE_REQUEST = 0x80000000;      // From 7.0.0
+
+// Status bit positions
+enum : uint32_t {
+    ST_DNA_READY = 0, ST_VLNV_READY, ST_ACTIVATION_DONE, ST_AUTO_ENABLED, ST_AUTO_BUSY, ST_METERING_ENABLED,
+    ST_METERING_READY, ST_SAAS_CHALLENGE_READY, ST_LICENSE_TIMER_ENABLED, ST_LICENSE_TIMER_INIT_LOADED,
+    ST_END_SESSION_METERING_READY, ST_HEART_BEAT_MODE_ENABLED, ST_ASYNCHRONOUS_METERING_READY,
+    ST_LICENSE_TIMER_SAMPLE_READY, ST_LICENSE_TIMER_COUNT_EMPTY, ST_SESSION_RUNNING, ST_ACTIVATION_CODES_TRANSMITTED,
+    ST_LICENSE_NODE_LOCK, ST_LICENSE_METERING, ST_LICENSE_TIMER_LOADED_NUMBER, ST_SECURITY_ALERT = 21,
+    ST_SEMAPHORE_ACKNOWLEDGE = 22
+};
+
+// Error codes
+const uint8_t ERR_NOT_READY = 0xFF;
+const uint8_t ERR_NO_ERROR = 0x00;
+
+// Frequency detection registers
+const uint32_t REG_FREQ_DETECTION_VERSION = 0xFFF0;
+const uint32_t REG_FREQ_DETECTION_COUNTER_DRMACLK = 0xFFF4;
+const uint32_t REG_FREQ_DETECTION_COUNTER_AXIACLK = 0xFFF8;
+const uint32_t FREQ_DETECTION_VERSION_3 = 0x60DC0DE1;
+
+// Test activators, see tests/conftest.py
+const uint32_t ACTIVATOR_ADDRESS_SPAN = 0x10000;
+const uint32_t ACT_STATUS_REG_OFFSET = 0x38;
+const uint32_t MAILBOX_REG_OFFSET = 0x3C;
+const uint32_t INC_EVENT_REG_OFFSET = 0x40;
+const uint32_t CNT_EVENT_REG_OFFSET = 0x44;
+const uint32_t INC_EVENT_MAGIC = 0x600DC0DE;
+const uint32_t UNMAPPED_VALUE = 0xDEADDEAD;
+
+const uint32_t MAILBOX_READ_WRITE_WORDS = 64;
+const uint32_t MAX_LICENSE_TIMERS = 2;
+
+/// Page 0 and status register differences between the supported HDK versions
+struct HdkLayout {
+    const char* version;
+    uint32_t versionValue;
+    uint32_t activatorNumberLsb;    // LSB of the number of activators in the status register
+    bool trng;                      // Adaptive proportion and repetition count test registers
+    bool securityAlert;
+    bool semaphore;                 // License timer init semaphore
+    uint32_t meteringAdditionalWords;
+};
+
+const HdkLayout HDK_LAYOUTS[] = {
+    { "3.1.0", 0x030100, 21, false, false, false, 2 },
+    { "3.2.0", 0x030200, 21, false, false, false, 3 },
+    { "3.2.1", 0x030201, 21, false, false, false, 3 },
+    { "3.2.2", 0x030202, 21, false, false, false, 3 },
+    { "4.0.0", 0x040000, 21, false, false, false, 3 },
+    { "4.0.1", 0x040001, 21, false, false, false, 3 },
+    { "4.1.0", 0x040100, 21, false, false, false, 3 },
+    { "4.2.0", 0x040200, 21, true,  false, false, 3 },
+    { "4.2.1", 0x040201, 22, true,  true,  false, 3 },
+    { "6.0.0", 0x060000, 22, true,  true,  false, 3 },
+    { "6.0.1", 0x060001, 22, true,  true,  false, 3 },
+    { "7.0.0", 0x070000, 23, true,  true,  true,  3 },
+};
+
+/// Product information of the reference design with the same number of activators
+std::string defaultProductInfo( uint32_t nb_activators ) {
+    return "{\"product_id\":{\"vendor\":\"accelize.com\",\"library\":\"refdesign\",\"name\":\"drm_"
+            + std::to_string( nb_activators ) + "activator\"}}";
+}
+
+// VLNV of the DRM Controller and of the activators: vendor, library, name, version
+const uint16_t CONTROLLER_VLNV[4] = { 0x0001, 0x0001, 0x0000, 0x0001 };
+const uint16_t ACTIVATOR_VLNV[4] = { 0x0001, 0x0001, 0x0001, 0x0001 };
+
+struct Activator {
+    uint32_t mailbox = 0;
+    uint32_t eventCount = 0;        // Counter of the IP, reset by the tests
+    uint64_t meteringCount = 0;     // Counter of the DRM Controller for the current session
+};
+
+}
+
+
+struct DrmControllerSim {
+
+    const HdkLayout& layout;
+    std::mutex mutex;
+    std::mt19937_64 random;
+
+    // Clocks
+    uint32_t drmFrequencyMHz = 125;
+    uint32_t axiFrequencyMHz = 250;
+    TClock::time_point freqDetectionStart;
+
+    // Registers
+    uint32_t page = PAGE_REGISTERS;
+    uint32_t command = 0;
+    uint32_t licenseStartAddress[2] = { 0, 0 };
+    uint32_t licenseTimer[NB_LICENSE_TIMER_WORDS] = {};
+    uint32_t dna[4] = {};
+    uint32_t saasChallenge[4] = {};
+    uint32_t sampledLicenseTimerCount[2] = { 0, 0 };
+    uint8_t activationError = ERR_NOT_READY;
+    uint8_t dnaError = ERR_NOT_READY;
+    uint8_t vlnvError = ERR_NOT_READY;
+    uint8_t licenseTimerLoadError = ERR_NOT_READY;
+
+    // Status
+    bool dnaReady = false;
+    bool vlnvReady = false;
+    bool activationDone = false;
+    bool endSessionMeteringReady = false;
+    bool asynchronousMeteringReady = false;
+    bool licenseTimerSampleReady = false;
+
+    // Session
+    bool activated = false;                 // A license key has been activated
+    bool meteringLicense = false;           // A license timer has been loaded since the activation
+    bool sessionRunning = false;
+    uint32_t sessionId[2] = { 0, 0 };
+    uint32_t licenseTimersLoaded = 0;       // Number of license timers loaded in the session
+    uint32_t meteringExtractions = 0;
+    std::deque<uint64_t> licenseTimers;     // Durations in DRM clock cycles, the current one first
+    TClock::time_point licenseTimerStart;   // Start of the current license timer
+    bool licenseTimerPending = false;       // A license timer waits for a free slot
+    uint64_t licenseTimerPendingValue = 0;
+
+    // Files
+    std::vector<uint32_t> licenseFile;
+    std::vector<uint32_t> meteringFile;
+    std::vector<uint32_t> mailboxReadOnly;
+    std::vector<uint32_t> mailboxReadWrite;
+
+    std::vector<Activator> activators;
+
+    DrmControllerSim( const HdkLayout& hdk_layout, uint32_t nb_activators )
+        : layout( hdk_layout ), random( std::random_device()() ), freqDetectionStart( TClock::now() ),
+          mailboxReadWrite( MAILBOX_READ_WRITE_WORDS, 0 ), activators( nb_activators ) {
+        for( uint32_t& word: dna )
+            word = (uint32_t)random();
+        newSaasChallenge();
+        setProductInfo( defaultProductInfo( nb_activators ).c_str() );
+        buildMeteringFile();
+    }
+
+    /// Return the duration of a number of DRM clock cycles
+    TClock::duration cyclesToDuration( uint64_t cycles ) const {
+        uint64_t max_cycles = UINT64_MAX / 1000;
+        if ( cycles > max_cycles )
+            cycles = max_cycles;
+        return std::chrono::duration_cast<TClock::duration>( std::chrono::nanoseconds( cycles * 1000 / drmFrequencyMHz ) );
+    }
+
+    /// Return the number of cycles of a clock during a duration, saturated to 32 bits
+    static uint32_t durationToCycles32( TClock::duration duration, uint32_t frequency_mhz ) {
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( duration ).count();
+        uint64_t cycles = ns / 1000 * frequency_mhz + ( ns % 1000 ) * frequency_mhz / 1000;
+        return cycles > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)cycles;
+    }
+
+    /// Expire the license timers which have elapsed and load the pending one
+    void updateLicenseTimers() {
+        TClock::time_point now = TClock::now();
+        while( !licenseTimers.empty() ) {
+            TClock::time_point end = licenseTimerStart + cyclesToDuration( licenseTimers.front() );
+            if ( end > now )
+                break;
+            licenseTimers.pop_front();
+            licenseTimerStart = end;
+            if ( licenseTimers.empty() && !licenseTimerPending )
+                break;
+            if ( licenseTimerPending ) {
+                licenseTimers.push_back( licenseTimerPendingValue );
+                licenseTimerPending = false;
+            }
+        }
+    }
+
+    uint64_t remainingLicenseCycles() const {
+        if ( licenseTimers.empty() )
+            return 0;
+        TClock::duration left = licenseTimerStart + cyclesToDuration( licenseTimers.front() ) - TClock::now();
+        if ( left.count() <= 0 )
+            return 0;
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( left ).count();
+        return ns * drmFrequencyMHz / 1000;
+    }
+
+    /// True if the activators are unlocked
+    bool licenseActive() const {
+        if ( !activated )
+            return false;
+        if ( !meteringLicense )
+            return true;    // Node-locked
+        return !licenseTimers.empty();
+    }
+
+    void newSaasChallenge() {
+        for( uint32_t& word: saasChallenge )
+            word = (uint32_t)random();
+    }
+
+    void setProductInfo( const char* product_info ) {
+        size_t len = strlen( product_info );
+        mailboxReadOnly.assign( len / 4 + 1, 0 );   // Keep a null terminator
+        memcpy( mailboxReadOnly.data(), product_info, len );
+    }
+
+    /// Build the metering file from the activator counters: header, license timer count,
+    /// one 128 bits word per activator and a checksum in place of the MAC
+    void buildMeteringFile() {
+        meteringFile.clear();
+        meteringFile.insert( meteringFile.end(), { sessionId[0], sessionId[1], 0, meteringExtractions++ } );
+        if ( layout.meteringAdditionalWords > 2 )
+            meteringFile.insert( meteringFile.end(), { 0, 0, 0, licenseTimersLoaded } );
+        for( uint32_t i = 0; i < activators.size(); i++ ) {
+            uint64_t count = activators[i].meteringCount;
+            meteringFile.insert( meteringFile.end(), { 0, i, (uint32_t)( count >> 32 ), (uint32_t)count } );
+        }
+        uint32_t checksum = 2166136261u;
+        for( uint32_t word: meteringFile ) {
+            checksum ^= word;
+            checksum *= 16777619u;
+        }
+        meteringFile.insert( meteringFile.end(), { checksum, ~checksum, checksum ^ 0xA5A5A5A5, ~checksum ^ 0xA5A5A5A5 } );
+    }
+
+    uint32_t readStatus() {
+        updateLicenseTimers();
+        bool active = licenseActive();
+        uint32_t status = 0;
+        status |= (uint32_t)dnaReady << ST_DNA_READY;
+        status |= (uint32_t)vlnvReady << ST_VLNV_READY;
+        status |= (uint32_t)activationDone << ST_ACTIVATION_DONE;
+        status |= 1u << ST_METERING_ENABLED;
+        status |= 1u << ST_METERING_READY;
+        status |= 1u << ST_SAAS_CHALLENGE_READY;
+        status |= 1u << ST_LICENSE_TIMER_ENABLED;
+        status |= (uint32_t)licenseTimerPending << ST_LICENSE_TIMER_INIT_LOADED;
+        status |= (uint32_t)endSessionMeteringReady << ST_END_SESSION_METERING_READY;
+        status |= (uint32_t)asynchronousMeteringReady << ST_ASYNCHRONOUS_METERING_READY;
+        status |= (uint32_t)licenseTimerSampleReady << ST_LICENSE_TIMER_SAMPLE_READY;
+        status |= (uint32_t)!active << ST_LICENSE_TIMER_COUNT_EMPTY;
+        status |= (uint32_t)sessionRunning << ST_SESSION_RUNNING;
+        status |= (uint32_t)active << ST_ACTIVATION_CODES_TRANSMITTED;
+        status |= (uint32_t)( activated && !meteringLicense ) << ST_LICENSE_NODE_LOCK;
+        status |= (uint32_t)( activated && meteringLicense ) << ST_LICENSE_METERING;
+        status |= (uint32_t)licenseTimers.size() << ST_LICENSE_TIMER_LOADED_NUMBER;
+        if ( layout.semaphore )
+            status |= ( ( command & CMD_SEMAPHORE_REQUEST ) ? 1u : 0u ) << ST_SEMAPHORE_ACKNOWLEDGE;
+        status |= (uint32_t)activators.size() << layout.activatorNumberLsb;
+        return status;
+    }
+
+    uint32_t readRegisterPage( uint32_t index ) {
+        switch( page ) {
+            case PAGE_REGISTERS:
+                if ( index == IDX_COMMAND )
+                    return command;
+                if ( index < IDX_LICENSE_TIMER )
+                    return licenseStartAddress[index - IDX_LICENSE_START_ADDRESS];
+                if ( index < IDX_STATUS )
+                    return licenseTimer[index - IDX_LICENSE_TIMER];
+                if ( index == IDX_STATUS )
+                    return readStatus();
+                if ( index == IDX_ERROR )
+                    return ( (uint32_t)licenseTimerLoadError << 24 ) | ( (uint32_t)vlnvError << 16 )
+                         | ( (uint32_t)dnaError << 8 ) | activationError;
+                if ( index < IDX_SAAS_CHALLENGE )
+                    return dna[index - IDX_DNA];
+                if ( index < IDX_SAMPLED_LICENSE_TIMER_COUNT )
+                    return saasChallenge[index - IDX_SAAS_CHALLENGE];
+                if ( index < IDX_VERSION )
+                    return sampledLicenseTimerCount[index - IDX_SAMPLED_LICENSE_TIMER_COUNT];
+                if ( index == IDX_VERSION )
+                    return layout.versionValue;
+                // Test failure counters of the TRNG, then logs: all 0
+                return 0;
+            case PAGE_VLNV: {
+                uint32_t word = index / 2;
+                if ( word > activators.size() )
+                    return 0;
+                const uint16_t* vlnv = word ? ACTIVATOR_VLNV : CONTROLLER_VLNV;
+                if ( index % 2 == 0 )
+                    return ( (uint32_t)vlnv[0] << 16 ) | vlnv[1];
+                return ( (uint32_t)vlnv[2] << 16 ) | (uint16_t)( vlnv[3] + ( word ? word - 1 : 0 ) );
+            }
+            case PAGE_LICENSE:
+                return index < licenseFile.size() ? licenseFile[index] : 0;
+            case PAGE_METERING:
+                if ( index == 0 && !endSessionMeteringReady && !asynchronousMeteringReady ) {
+                    // Synchronous extraction: the file is sampled when its first word is read
+                    updateLicenseTimers();
+                    buildMeteringFile();
+                    newSaasChallenge();
+                }
+                return index < meteringFile.size() ? meteringFile[index] : 0;
+            case PAGE_MAILBOX: {
+                if ( index == 0 )
+                    return ( (uint32_t)mailboxReadOnly.size() << 16 ) | (uint32_t)mailboxReadWrite.size();
+                index -= 1;
+                if ( index < mailboxReadOnly.size() )
+                    return mailboxReadOnly[index];
+                index -= (uint32_t)mailboxReadOnly.size();
+                return index < mailboxReadWrite.size() ? mailboxReadWrite[index] : 0;
+            }
+            default:
+                return 0;   // Trace file and unknown pages
+        }
+    }
+
+    void writeCommand( uint32_t value ) {
+        uint32_t started = value & ~command & CMD_OPERATION_MASK;
+        if ( !layout.semaphore )
+            value &= ~CMD_SEMAPHORE_REQUEST;
+        command = value;
+        updateLicenseTimers();
+
+        if ( value & CMD_NOP ) {
+            endSessionMeteringReady = false;
+            asynchronousMeteringReady = false;
+            licenseTimerSampleReady = false;
+        }
+        if ( started & CMD_EXTRACT_DNA ) {
+            dnaReady = true;
+            dnaError = ERR_NO_ERROR;
+        }
+        if ( started & CMD_EXTRACT_VLNV ) {
+            vlnvReady = true;
+            vlnvError = ERR_NO_ERROR;
+        }
+        if ( started & CMD_ACTIVATE ) {
+            // Start a new session with the license key
+            sessionId[0] = licenseFile.size() > 0 ? licenseFile[0] : 0;
+            sessionId[1] = licenseFile.size() > 1 ? licenseFile[1] : 0;
+            activated = true;
+            meteringLicense = false;
+            sessionRunning = false;
+            licenseTimers.clear();
+            licenseTimerPending = false;
+            licenseTimersLoaded = 0;
+            for( Activator& activator: activators )
+                activator.meteringCount = 0;
+            activationDone = true;
+            activationError = ERR_NO_ERROR;
+            newSaasChallenge();
+        }
+        if ( started & CMD_EXTRACT_METERING ) {
+            buildMeteringFile();
+            asynchronousMeteringReady = true;
+        }
+        if ( started & CMD_END_SESSION_EXTRACT_METERING ) {
+            buildMeteringFile();
+            endSessionMeteringReady = true;
+            activated = false;
+            meteringLicense = false;
+            sessionRunning = false;
+            licenseTimers.clear();
+            licenseTimerPending = false;
+        }
+        if ( started & CMD_SAMPLE_LICENSE_TIMER ) {
+            uint64_t remaining = remainingLicenseCycles();
+            sampledLicenseTimerCount[0] = (uint32_t)( remaining >> 32 );
+            sampledLicenseTimerCount[1] = (uint32_t)remaining;
+            licenseTimerSampleReady = true;
+        }
+    }
+
+    /// Load the license timer when its last word is written
+    void loadLicenseTimer() {
+        updateLicenseTimers();
+        uint64_t cycles = ( (uint64_t)licenseTimer[0] << 32 ) | licenseTimer[1];
+        meteringLicense = true;
+        sessionRunning = true;
+        licenseTimersLoaded++;
+        licenseTimerLoadError = ERR_NO_ERROR;
+        if ( licenseTimers.empty() )
+            licenseTimerStart = TClock::now();
+        if ( licenseTimers.size() < MAX_LICENSE_TIMERS ) {
+            licenseTimers.push_back( cycles );
+        } else {
+            licenseTimerPending = true;
+            licenseTimerPendingValue = cycles;
+        }
+    }
+
+    void writeRegisterPage( uint32_t index, uint32_t value ) {
+        switch( page ) {
+            case PAGE_REGISTERS:
+                if ( index == IDX_COMMAND ) {
+                    writeCommand( value );
+                } else if ( index < IDX_LICENSE_TIMER ) {
+                    licenseStartAddress[index - IDX_LICENSE_START_ADDRESS] = value;
+                } else if ( index < IDX_STATUS ) {
+                    licenseTimer[index - IDX_LICENSE_TIMER] = value;
+                    if ( index == IDX_LICENSE_TIMER + NB_LICENSE_TIMER_WORDS - 1 )
+                        loadLicenseTimer();
+                }
+                break;  // Other registers are read-only
+            case PAGE_LICENSE:
+                if ( index >= licenseFile.size() )
+                    licenseFile.resize( index + 1, 0 );
+                licenseFile[index] = value;
+                break;
+            case PAGE_MAILBOX:
+                if ( index > mailboxReadOnly.size() ) {
+                    index -= 1 + (uint32_t)mailboxReadOnly.size();
+                    if ( index < mailboxReadWrite.size() )
+                        mailboxReadWrite[index] = value;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    uint32_t readActivator( Activator& activator, uint32_t offset ) {
+        updateLicenseTimers();
+        switch( offset ) {
+            case ACT_STATUS_REG_OFFSET: return licenseActive() ? 3 : 0;
+            case MAILBOX_REG_OFFSET:    return activator.mailbox;
+            case INC_EVENT_REG_OFFSET:  return INC_EVENT_MAGIC;
+            case CNT_EVENT_REG_OFFSET:  return activator.eventCount;
+            default:                    return UNMAPPED_VALUE;
+        }
+    }
+
+    void writeActivator( Activator& activator, uint32_t offset, uint32_t value ) {
+        updateLicenseTimers();
+        bool active = licenseActive();
+        switch( offset ) {
+            case MAILBOX_REG_OFFSET:
+                if ( active )
+                    activator.mailbox = value;
+                break;
+            case INC_EVENT_REG_OFFSET:
+                if ( active ) {
+                    activator.eventCount++;
+                    activator.meteringCount++;
+                }
+                break;
+            case CNT_EVENT_REG_OFFSET:
+                activator.eventCount = 0;
+                break;
+            default:
+                break;
+        }
+    }
+
+    int read( uint32_t offset, uint32_t& value ) {
+        std::lock_guard<std::mutex> lock( mutex );
+        if ( offset & 0x3 )
+            return -1;
+        if ( offset >= ACTIVATOR_ADDRESS_SPAN ) {
+            uint32_t index = offset / ACTIVATOR_ADDRESS_SPAN - 1;
+            value = index < activators.size() ? readActivator( activators[index], offset % ACTIVATOR_ADDRESS_SPAN ) : 0;
+            return 0;
+        }
+        TClock::duration elapsed = TClock::now() - freqDetectionStart;
+        switch( offset ) {
+            case 0:                                   value = page; break;
+            case REG_FREQ_DETECTION_VERSION:          value = FREQ_DETECTION_VERSION_3; break;
+            case REG_FREQ_DETECTION_COUNTER_DRMACLK:  value = durationToCycles32( elapsed, drmFrequencyMHz ); break;
+            case REG_FREQ_DETECTION_COUNTER_AXIACLK:  value = durationToCycles32( elapsed, axiFrequencyMHz ); break;
+            default:
+                value = ( offset / 4 - 1 < MAX_PAGE_WORDS ) ? readRegisterPage( offset / 4 - 1 ) : 0;
+                break;
+        }
+        return 0;
+    }
+
+    int write( uint32_t offset, uint32_t value ) {
+        std::lock_guard<std::mutex> lock( mutex );
+        if ( offset & 0x3 )
+            return -1;
+        if ( offset >= ACTIVATOR_ADDRESS_SPAN ) {
+            uint32_t index = offset / ACTIVATOR_ADDRESS_SPAN - 1;
+            if ( index < activators.size() )
+                writeActivator( activators[index], offset % ACTIVATOR_ADDRESS_SPAN, value );
+            return 0;
+        }
+        if ( offset == 0 )
+            page = value;
+        else if ( offset == REG_FREQ_DETECTION_VERSION )
+            freqDetectionStart = TClock::now();     // Reset the frequency detection counters
+        else if ( offset / 4 - 1 < MAX_PAGE_WORDS )
+            writeRegisterPage( offset / 4 - 1, value );
+        return 0;
+    }
+};
+
+
+int DrmControllerSim_alloc( DrmControllerSim** p_sim, const char* hdk_version, uint32_t nb_activators ) {
+    if ( p_sim == nullptr || hdk_version == nullptr || nb_activators == 0 || nb_activators > 256 )
+        return -1;
+    for( const HdkLayout& layout: HDK_LAYOUTS ) {
+        if ( strcmp( layout.version, hdk_version ) == 0 ) {
+            *p_sim = new DrmControllerSim( layout, nb_activators );
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void DrmControllerSim_free( DrmControllerSim** p_sim ) {
+    if ( p_sim == nullptr )
+        return;
+    delete *p_sim;
+    *p_sim = nullptr;
+}
+
+int DrmControllerSim_read_register( DrmControllerSim* sim, uint32_t offset, uint32_t* value ) {
+    if ( sim == nullptr || value == nullptr )
+        return -1;
+    return sim->read( offset, *value );
+}
+
+int DrmControllerSim_write_register( DrmControllerSim* sim, uint32_t offset, uint32_t value ) {
+    if ( sim == nullptr )
+        return -1;
+    return sim->write( offset, value );
+}
+
+int DrmControllerSim_read_register_callback( uint32_t offset, uint32_t* value, void* user_p ) {
+    return DrmControllerSim_read_register( static_cast<DrmControllerSim*>( user_p ), offset, value );
+}
+
+int DrmControllerSim_write_register_callback( uint32_t offset, uint32_t value, void* user_p ) {
+    return DrmControllerSim_write_register( static_cast<DrmControllerSim*>( user_p ), offset, value );
+}
+
+int DrmControllerSim_set_dna( DrmControllerSim* sim, const char* dna ) {
+    if ( sim == nullptr || dna == nullptr || strlen( dna ) != 32 )
+        return -1;
+    uint32_t words[4];
+    for( uint32_t i = 0; i < 4; i++ ) {
+        std::string digits( dna + i * 8, 8 );
+        if ( digits.find_first_not_of( "0123456789abcdefABCDEF" ) != std::string::npos )
+            return -1;
+        words[i] = (uint32_t)std::stoul( digits, nullptr, 16 );
+    }
+    std::lock_guard<std::mutex> lock( sim->mutex );
+    memcpy( sim->dna, words, sizeof( words ) );
+    return 0;
+}
+
+int DrmControllerSim_set_product_info( DrmControllerSim* sim, const char* product_info ) {
+    if ( sim == nullptr || product_info == nullptr )
+        return -1;
+    std::lock_guard<std::mutex> lock( sim->mutex );
+    sim->setProductInfo( product_info );
+    return 0;
+}
+
+int DrmControllerSim_set_frequency( DrmControllerSim* sim, uint32_t drm_mhz, uint32_t axi_mhz ) {
+    if ( sim == nullptr || drm_mhz == 0 || axi_mhz == 0 )
+        return -1;
+    std::lock_guard<std::mutex> lock( sim->mutex );
+    sim->updateLicenseTimers();
+    sim->drmFrequencyMHz = drm_mhz;
+    sim->axiFrequencyMHz = axi_mhz;
+    return 0;
+}
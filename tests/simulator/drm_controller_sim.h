@@ -0,0 +1,109 @@
+/*
+Copyright (C) 2022, Accelize
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/** \brief Software model of the DRM Controller register map
+
+    The simulator answers the register accesses of the DRM library like a DRM
+    Controller of the selected HDK version, with the page 0 layout and the status
+    bits of the matching DrmControllerRegistersStrategy_v* class. It is meant to
+    be plugged in the read/write register callbacks to run the library without
+    FPGA.
+
+    Address map, relative to the DRM Controller base address:
+    - 0x0000: page register
+    - 0x0004-0xFFEC: register lines of the selected page
+    - 0xFFF0-0xFFF8: frequency detection registers (method 3)
+    - 0x10000 * (i+1): test activator #i, with the same register interface as
+      the activators of the reference designs (see tests/conftest.py)
+
+    The cryptographic parts of the protocol are not modeled: any license key is
+    accepted. The simulator takes the following fields of the license data:
+    - the session ID is the first 64 bits of the license key,
+    - the license duration in DRM clock cycles is the first 64 bits of the
+      license timer.
+    The license is node-locked when the key is activated without license timer.
+*/
+
+#ifndef _H_ACCELIZE_DRM_CONTROLLER_SIM
+#define _H_ACCELIZE_DRM_CONTROLLER_SIM
+
+#include <stdint.h>
+
+// The project is compiled with hidden visibility: export the C API explicitly
+#if defined(__GNUC__) || defined(__clang__)
+    #define DRM_SIM_EXPORT __attribute__((visibility("default")))
+#else
+    #define DRM_SIM_EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct DrmControllerSim DrmControllerSim;
+
+/** \brief Allocate a simulator
+
+    \param[out] p_sim : Simulator instance
+    \param[in] hdk_version : HDK version as "major.minor.patch", supported versions are 3.1.0 and later
+    \param[in] nb_activators : Number of activators behind the DRM Controller, from 1 to 256
+
+    \return 0 on success, -1 if the version or the number of activators is not supported
+*/
+DRM_SIM_EXPORT int DrmControllerSim_alloc( DrmControllerSim** p_sim, const char* hdk_version, uint32_t nb_activators );
+
+/** \brief Release a simulator
+*/
+DRM_SIM_EXPORT void DrmControllerSim_free( DrmControllerSim** p_sim );
+
+/** \brief Read a 32 bits register, return 0 on success
+*/
+DRM_SIM_EXPORT int DrmControllerSim_read_register( DrmControllerSim* sim, uint32_t offset, uint32_t* value );
+
+/** \brief Write a 32 bits register, return 0 on success
+*/
+DRM_SIM_EXPORT int DrmControllerSim_write_register( DrmControllerSim* sim, uint32_t offset, uint32_t value );
+
+/** \brief Read register callback with the signature of the C API, "user_p" is the simulator
+*/
+DRM_SIM_EXPORT int DrmControllerSim_read_register_callback( uint32_t offset, uint32_t* value, void* user_p );
+
+/** \brief Write register callback with the signature of the C API, "user_p" is the simulator
+*/
+DRM_SIM_EXPORT int DrmControllerSim_write_register_callback( uint32_t offset, uint32_t value, void* user_p );
+
+/** \brief Set the 128 bits device DNA given as 32 hexadecimal digits, return 0 on success
+
+    A random DNA is generated when the simulator is allocated.
+*/
+DRM_SIM_EXPORT int DrmControllerSim_set_dna( DrmControllerSim* sim, const char* dna );
+
+/** \brief Set the product information stored in the read-only mailbox, return 0 on success
+
+    The string is usually a JSON object with a "product_id" member. By default, it
+    is the product ID of the reference design with the same number of activators.
+*/
+DRM_SIM_EXPORT int DrmControllerSim_set_product_info( DrmControllerSim* sim, const char* product_info );
+
+/** \brief Set the frequencies in MHz of the DRM (drm_aclk) and AXI (s_axi_aclk) clocks, return 0 on success
+*/
+DRM_SIM_EXPORT int DrmControllerSim_set_frequency( DrmControllerSim* sim, uint32_t drm_mhz, uint32_t axi_mhz );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _H_ACCELIZE_DRM_CONTROLLER_SIM
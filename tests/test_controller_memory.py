@@ -175,6 +175,37 @@ def test_malformed_product_id(accelize_drm, conf_json, cred_json, async_handler)
         driver.program_fpga(fpga_image_bkp)
 
 
+def test_design_info_read_once(accelize_drm, conf_json, cred_json, async_handler):
+    """Test the design information is read from the DRM Controller only once"""
+    from tests.fault_bus import FaultInjectingBus
+    if accelize_drm.is_ctrl_sw:
+        pytest.skip("Test involves callbacks modification: skipped on SoM target (no callback provided for SoM)")
+
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    async_cb = async_handler.create()
+    async_cb.reset()
+    conf_json.reset()
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path,
+        bus.read_register_callback,
+        bus.write_register_callback,
+        async_cb.callback
+    )
+    try:
+        bus.reset_stats()
+        for _ in range(3):
+            assert drm_manager.get('num_activators') > 0
+            assert drm_manager.get('mailbox_size') > 0
+            assert drm_manager.get('controller_rom')
+            assert drm_manager.get('product_info')
+        stats = bus.stats()
+        assert stats['reads'] == 0
+        assert stats['writes'] == 0
+    finally:
+        drm_manager.free()
+    async_cb.assert_NoError()
+
+
 @pytest.mark.skip(reason='Two concurrent objects on the same board is not supported')
 def test_2_drm_manager_concurrently(accelize_drm, conf_json, cred_json, async_handler):
     """Test errors when 2 DrmManager instances are used."""
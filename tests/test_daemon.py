@@ -0,0 +1,268 @@
+# -*- coding: utf-8 -*-
+"""
+Test the DRM Manager shared between processes through the host-local daemon.
+"""
+import pytest
+import socket
+from os import stat
+from os.path import exists, join
+from shutil import rmtree
+from tempfile import mkdtemp
+
+from tests.conftest import wait_func_true
+from tests.fault_bus import FaultInjectingBus
+from tests.ws_mock import LicenseWSMock
+
+
+@pytest.fixture
+def daemon_conf(accelize_drm, conf_json):
+    """License Web Service mock and socket of the daemon"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Daemon tests require the "simulator" FPGA driver')
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    socket_dir = mkdtemp(prefix='drm_daemon_')
+    try:
+        with LicenseWSMock(license_timeout=10) as mock:
+            conf_json.reset()
+            conf_json['licensing']['url'] = mock.url
+            conf_json.save()
+            yield mock, join(socket_dir, 'drm.sock')
+    finally:
+        rmtree(socket_dir, ignore_errors=True)
+
+
+def _create_daemon(accelize_drm, conf_json, cred_json, async_cb, bus, socket_path):
+    """Create the DRM Manager owning the DRM Controller, then configure the clients"""
+    conf_json['settings']['daemon_server_socket'] = socket_path
+    conf_json.save()
+    daemon = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, bus.read_register_callback,
+        bus.write_register_callback, async_cb.callback)
+    del conf_json['settings']['daemon_server_socket']
+    conf_json['settings']['daemon_socket'] = socket_path
+    conf_json.save()
+    return daemon
+
+
+def _create_client(accelize_drm, conf_json, cred_json, async_cb, bus):
+    return accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, bus.read_register_callback,
+        bus.write_register_callback, async_cb.callback)
+
+
+def test_daemon_shared_session(accelize_drm, conf_json, cred_json, async_handler,
+                               daemon_conf):
+    """
+    Test the clients share the session of the daemon without accessing the
+    DRM Controller, and the session is closed by the last client
+    """
+    mock, socket_path = daemon_conf
+    async_cb = async_handler.create()
+    async_cb.reset()
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    daemon = _create_daemon(accelize_drm, conf_json, cred_json, async_cb, bus, socket_path)
+    try:
+        assert exists(socket_path)
+        bus.reset_stats()
+        client1 = _create_client(accelize_drm, conf_json, cred_json, async_cb, bus)
+        client2 = _create_client(accelize_drm, conf_json, cred_json, async_cb, bus)
+        stats = bus.stats()
+        assert stats['reads'] == 0
+        assert stats['writes'] == 0
+        try:
+            client1.activate()
+            session_id = client1.get('session_id')
+            assert session_id
+            assert daemon.get('session_id') == session_id
+            client2.activate()
+            assert client2.get('session_id') == session_id
+            assert client2.get('license_status')
+            assert client2.get('num_activators') == daemon.get('num_activators')
+            assert client2.get('metered_data') == daemon.get('metered_data')
+            assert mock.stats()['license_requests']['open'] == 1
+
+            client1.deactivate()
+            assert daemon.get('session_status')
+            assert mock.stats()['license_requests']['close'] == 0
+            client2.deactivate()
+            assert not daemon.get('session_status')
+            assert mock.stats()['license_requests']['close'] == 1
+        finally:
+            client2.free()
+            client1.free()
+    finally:
+        daemon.free()
+    assert not exists(socket_path)
+    assert mock.stats()['sessions_open'] == 0
+    async_cb.assert_NoError()
+
+
+def test_daemon_socket_access(accelize_drm, conf_json, cred_json, async_handler,
+                              daemon_conf):
+    """
+    Test the daemon socket is only accessible to the user of the daemon, and
+    a client can only set the parameters of the session
+    """
+    mock, socket_path = daemon_conf
+    async_cb = async_handler.create()
+    async_cb.reset()
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    daemon = _create_daemon(accelize_drm, conf_json, cred_json, async_cb, bus, socket_path)
+    try:
+        assert stat(socket_path).st_mode & 0o777 == 0o600
+        client = _create_client(accelize_drm, conf_json, cred_json, async_cb, bus)
+        try:
+            client.set(custom_field=0x1234)
+            assert daemon.get('custom_field') == 0x1234
+            log_verbosity = daemon.get('log_verbosity')
+            with pytest.raises(accelize_drm.exceptions.DRMBadArg) as excinfo:
+                client.set(log_verbosity=0)
+            assert "Parameter 'log_verbosity' cannot be set by a client of the DRM daemon" in str(excinfo.value)
+            async_cb.reset()
+            assert daemon.get('log_verbosity') == log_verbosity
+            # The metering buffer of the client is larger than the number of activators
+            client.activate()
+            assert len(client.read_metering()) == daemon.get('num_activators')
+            client.deactivate()
+        finally:
+            client.free()
+    finally:
+        daemon.free()
+    async_cb.assert_NoError()
+
+
+def test_daemon_socket_in_use(accelize_drm, conf_json, cred_json, async_handler,
+                              daemon_conf):
+    """
+    Test the daemon does not take over a socket served by another process,
+    and removes a stale socket
+    """
+    mock, socket_path = daemon_conf
+    async_cb = async_handler.create()
+    async_cb.reset()
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        server.bind(socket_path)
+        server.listen(1)
+        conf_json['settings']['metrics'] = True
+        with pytest.raises(accelize_drm.exceptions.DRMBadUsage) as excinfo:
+            _create_daemon(accelize_drm, conf_json, cred_json, async_cb, bus, socket_path)
+        assert 'Socket %s is already served by another process' % socket_path in str(excinfo.value)
+        assert exists(socket_path)
+    finally:
+        server.close()
+    # The socket file is left by the closed server
+    assert exists(socket_path)
+    conf_json.reset()
+    conf_json['licensing']['url'] = mock.url
+    conf_json['settings']['metrics'] = True
+    daemon = _create_daemon(accelize_drm, conf_json, cred_json, async_cb, bus, socket_path)
+    # The daemon which failed to start is not left registered in the metrics
+    metrics = daemon.get('metrics')
+    assert len([line for line in metrics.splitlines()
+                if line.startswith('drm_license_time_left_seconds{')]) == 1
+    daemon.free()
+    assert not exists(socket_path)
+    async_cb.reset()
+
+
+def test_daemon_timeout(accelize_drm, conf_json, cred_json, async_handler,
+                        daemon_conf):
+    """Test a client does not wait forever for a daemon which does not reply"""
+    mock, socket_path = daemon_conf
+    async_cb = async_handler.create()
+    async_cb.reset()
+    driver = accelize_drm.pytest_fpga_driver[0]
+    server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        server.bind(socket_path)
+        server.listen(1)
+        conf_json['settings']['daemon_socket'] = socket_path
+        conf_json['settings']['daemon_timeout'] = 1
+        conf_json.save()
+        client = accelize_drm.DrmManager(
+            conf_json.path, cred_json.path, driver.read_register_callback,
+            driver.write_register_callback, async_cb.callback)
+        try:
+            with pytest.raises(accelize_drm.exceptions.DRMExternFail) as excinfo:
+                client.get('session_id')
+            assert 'Timeout on request to DRM daemon on %s after 1000 ms' % socket_path in str(excinfo.value)
+            with pytest.raises(accelize_drm.exceptions.DRMExternFail) as excinfo:
+                client.get('session_id')
+            assert 'Connection to DRM daemon on %s is closed' % socket_path in str(excinfo.value)
+        finally:
+            client.free()
+    finally:
+        server.close()
+    async_cb.reset()
+
+
+def test_daemon_keeps_paused_session(accelize_drm, conf_json, cred_json, async_handler,
+                                     daemon_conf):
+    """
+    Test a session paused by the last client is kept running by the daemon
+    and reused by the next client, and the session of a client exiting
+    without deactivation is closed
+    """
+    mock, socket_path = daemon_conf
+    async_cb = async_handler.create()
+    async_cb.reset()
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    daemon = _create_daemon(accelize_drm, conf_json, cred_json, async_cb, bus, socket_path)
+    try:
+        client = _create_client(accelize_drm, conf_json, cred_json, async_cb, bus)
+        try:
+            client.activate()
+            session_id = client.get('session_id')
+            client.deactivate(True)
+        finally:
+            client.free()
+        assert daemon.get('session_status')
+
+        client = _create_client(accelize_drm, conf_json, cred_json, async_cb, bus)
+        try:
+            client.activate(True)
+            assert client.get('session_id') == session_id
+            assert mock.stats()['license_requests']['open'] == 1
+        finally:
+            client.free()
+        # The daemon releases the session when it detects the disconnection
+        wait_func_true(lambda: mock.stats()['license_requests']['close'] == 1,
+                       timeout=5, sleep_time=0.1)
+        assert not daemon.get('session_status')
+
+        # An error raised by the daemon is raised by the client
+        client = _create_client(accelize_drm, conf_json, cred_json, async_cb, bus)
+        try:
+            with pytest.raises(accelize_drm.exceptions.DRMBadArg) as excinfo:
+                client.get('unknown_parameter')
+            assert 'Cannot find parameter: unknown_parameter' in str(excinfo.value)
+
+            # The credentials and the registers of the daemon cannot be read by a client
+            for key in ('token_string', 'dump_all', 'page_ctrlreg', 'hw_report'):
+                with pytest.raises(accelize_drm.exceptions.DRMBadArg) as excinfo:
+                    client.get(key)
+                assert "Parameter '%s' cannot be read by a client of the DRM daemon" % key in str(excinfo.value)
+        finally:
+            client.free()
+    finally:
+        daemon.free()
+    async_cb.reset()
+
+
+def test_daemon_not_running(accelize_drm, conf_json, cred_json, async_handler,
+                            daemon_conf):
+    """Test the client construction fails when the daemon is not running"""
+    mock, socket_path = daemon_conf
+    async_cb = async_handler.create()
+    async_cb.reset()
+    driver = accelize_drm.pytest_fpga_driver[0]
+    conf_json['settings']['daemon_socket'] = socket_path
+    conf_json.save()
+    with pytest.raises(accelize_drm.exceptions.DRMExternFail) as excinfo:
+        accelize_drm.DrmManager(
+            conf_json.path, cred_json.path, driver.read_register_callback,
+            driver.write_register_callback, async_cb.callback)
+    assert 'Failed to connect to DRM daemon on %s' % socket_path in str(excinfo.value)
+    async_cb.reset()
@@ -0,0 +1,198 @@
+# -*- coding: utf-8 -*-
+"""
+Test the warm start of the DRM Manager from the device profile.
+"""
+import pytest
+from json import load, dump, dumps
+from os.path import isfile
+from time import time
+
+from tests.fault_bus import FaultInjectingBus
+from tests.ws_mock import LicenseWSMock
+
+
+@pytest.fixture
+def device_profile(accelize_drm, conf_json, tmpdir):
+    """Device profile file set in the configuration file"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Device profile tests require the "simulator" FPGA driver')
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    with LicenseWSMock(license_timeout=30) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json['settings']['device_profile_file'] = str(tmpdir.join('device_profile.json'))
+        conf_json.save()
+        yield conf_json['settings']['device_profile_file']
+
+
+def _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb, bus=None):
+    driver = bus or accelize_drm.pytest_fpga_driver[0]
+    start = time()
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, driver.read_register_callback,
+        driver.write_register_callback, async_cb.callback)
+    return drm_manager, time() - start
+
+
+def _register_accesses(bus):
+    stats = bus.stats()
+    return stats['reads'] + stats['writes']
+
+
+def _device_info(drm_manager):
+    return drm_manager.get('drm_frequency', 'product_info', 'mailbox_size',
+                           'num_activators', 'controller_version', 'controller_rom')
+
+
+def test_warm_start(accelize_drm, conf_json, cred_json, async_handler,
+                    device_profile, record_property):
+    """
+    Test the first instance saves the device profile, and the next ones
+    skip the register auto-test
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    assert not isfile(device_profile)
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+
+    drm_manager, cold_duration = _new_drm_manager(
+        accelize_drm, conf_json, cred_json, async_cb, bus)
+    cold_accesses = _register_accesses(bus)
+    try:
+        cold_info = _device_info(drm_manager)
+    finally:
+        drm_manager.free()
+    assert isfile(device_profile)
+    with open(device_profile) as f:
+        profile = load(f)
+    assert profile['num_activators'] == cold_info['num_activators']
+    assert profile['frequency']['drm_aclk'] == cold_info['drm_frequency']
+
+    bus.reset_stats()
+    drm_manager, warm_duration = _new_drm_manager(
+        accelize_drm, conf_json, cred_json, async_cb, bus)
+    warm_accesses = _register_accesses(bus)
+    try:
+        assert _device_info(drm_manager) == cold_info
+        drm_manager.activate()
+        assert drm_manager.get('license_status')
+        drm_manager.deactivate()
+    finally:
+        drm_manager.free()
+    record_property('cold_start_duration', cold_duration)
+    record_property('warm_start_duration', warm_duration)
+    record_property('cold_start_register_accesses', cold_accesses)
+    record_property('warm_start_register_accesses', warm_accesses)
+    assert warm_accesses < cold_accesses
+    async_cb.assert_NoError()
+
+
+def test_stale_profile(accelize_drm, conf_json, cred_json, async_handler,
+                       device_profile):
+    """
+    Test a profile that does not match the device is ignored and replaced
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+
+    drm_manager, _ = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        product_info = drm_manager.get('product_info')
+    finally:
+        drm_manager.free()
+    with open(device_profile) as f:
+        profile = load(f)
+    dna = profile['dna']
+    profile['dna'] = '0' * len(dna)
+    profile['design']['mailbox_read_only'] = 'stale'
+    with open(device_profile, 'wt') as f:
+        dump(profile, f)
+
+    drm_manager, _ = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        assert drm_manager.get('product_info') == product_info
+    finally:
+        drm_manager.free()
+    with open(device_profile) as f:
+        profile = load(f)
+    assert profile['dna'] == dna
+    async_cb.assert_NoError()
+
+
+def test_stale_drm_version(accelize_drm, conf_json, cred_json, async_handler,
+                           device_profile):
+    """
+    Test a profile saved for another DRM Controller version is ignored and
+    replaced, and the register auto-test is run again
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+
+    drm_manager, _ = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb, bus)
+    cold_accesses = _register_accesses(bus)
+    drm_manager.free()
+    with open(device_profile) as f:
+        profile = load(f)
+    drm_version = profile['drm_version']
+    profile['drm_version'] = '0' * len(drm_version)
+    with open(device_profile, 'wt') as f:
+        dump(profile, f)
+
+    bus.reset_stats()
+    drm_manager, _ = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb, bus)
+    assert _register_accesses(bus) >= cold_accesses
+    drm_manager.free()
+    with open(device_profile) as f:
+        assert load(f)['drm_version'] == drm_version
+    async_cb.assert_NoError()
+
+
+def test_restored_profile(accelize_drm, conf_json, cred_json, async_handler,
+                          device_profile):
+    """
+    Test the design information and the DRM frequency are restored from a
+    profile matching the DRM Controller version and the DNA, instead of being
+    read and measured again
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+
+    drm_manager, _ = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    drm_manager.free()
+    with open(device_profile) as f:
+        profile = load(f)
+    product_info = {'product_id': {'vendor': 'profile', 'library': 'profile',
+                                   'name': 'profile'}}
+    profile['design']['mailbox_read_only'] = dumps(product_info)
+    profile['frequency']['drm_aclk'] += 1
+    with open(device_profile, 'wt') as f:
+        dump(profile, f)
+
+    drm_manager, _ = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        assert drm_manager.get('product_info') == product_info['product_id']
+        assert drm_manager.get('drm_frequency') == profile['frequency']['drm_aclk']
+    finally:
+        drm_manager.free()
+    async_cb.assert_NoError()
+
+
+def test_invalid_profile(accelize_drm, conf_json, cred_json, async_handler,
+                         device_profile):
+    """
+    Test an unreadable profile is ignored and replaced
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    with open(device_profile, 'wt') as f:
+        f.write('{"dna": ')
+
+    drm_manager, _ = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        num_activators = drm_manager.get('num_activators')
+    finally:
+        drm_manager.free()
+    with open(device_profile) as f:
+        assert load(f)['num_activators'] == num_activators
+    async_cb.assert_NoError()
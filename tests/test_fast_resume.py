@@ -0,0 +1,161 @@
+# -*- coding: utf-8 -*-
+"""
+Test the fast resume of a pending session after a restart of the process.
+"""
+import pytest
+from time import time
+
+from tests.conftest import wait_func_true
+from tests.fault_bus import FaultInjectingBus
+from tests.ws_mock import LicenseWSMock
+
+
+@pytest.fixture
+def license_ws_mock(accelize_drm, conf_json):
+    """License Web Service mock and fast resume set in the configuration file"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Fast resume tests require the "simulator" FPGA driver')
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    with LicenseWSMock(license_timeout=10) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json['settings']['fast_resume'] = True
+        conf_json.save()
+        yield mock
+
+
+def _assert_frequency(drm_manager, conf_json):
+    """Check the measured frequency matches the configuration within the detection threshold"""
+    frequency = drm_manager.get('drm_frequency')
+    threshold = drm_manager.get('frequency_detection_threshold')
+    assert abs(conf_json['drm']['frequency_mhz'] - frequency) * 100.0 / frequency < threshold
+
+
+def _pause_session(accelize_drm, conf_json, cred_json, async_cb, bus, mock):
+    """Start a session, pause it while its second license is requested, and
+    destroy the DRM Manager as a process restart would"""
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, bus.read_register_callback,
+        bus.write_register_callback, async_cb.callback)
+    try:
+        mock.configure(latency=2)
+        drm_manager.activate()
+        session_id = drm_manager.get('session_id')
+        drm_manager.deactivate(True)
+        assert drm_manager.get('session_status')
+        assert drm_manager.get('num_license_loaded') == 1
+    finally:
+        drm_manager.free()
+    return session_id
+
+
+def test_fast_resume(accelize_drm, conf_json, cred_json, async_handler,
+                     license_ws_mock, record_property):
+    """
+    Test the pending session is resumed without probing the device nor
+    requesting a license, then the licensing thread renews the license
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    mock = license_ws_mock
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    session_id = _pause_session(accelize_drm, conf_json, cred_json, async_cb, bus, mock)
+    running_requests = mock.stats()['license_requests']['running']
+
+    bus.reset_stats()
+    start = time()
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, bus.read_register_callback,
+        bus.write_register_callback, async_cb.callback)
+    try:
+        drm_manager.activate(True)
+        duration = time() - start
+        stats = bus.stats()
+        assert mock.stats()['license_requests']['running'] == running_requests
+        assert drm_manager.get('session_id') == session_id
+        assert drm_manager.get('license_status')
+        # The deferred frequency measure is completed by activate
+        _assert_frequency(drm_manager, conf_json)
+
+        # The licensing thread renews the license
+        wait_func_true(lambda: mock.stats()['license_requests']['running'] > running_requests,
+                       timeout=10, sleep_time=0.1)
+        wait_func_true(lambda: drm_manager.get('num_license_loaded') == 2,
+                       timeout=10, sleep_time=0.1)
+        drm_manager.deactivate()
+        assert not drm_manager.get('session_status')
+    finally:
+        drm_manager.free()
+    record_property('resume_duration', duration)
+    record_property('resume_register_accesses', stats['reads'] + stats['writes'])
+    assert duration < 1
+    assert mock.stats()['sessions_open'] == 0
+    async_cb.assert_NoError()
+
+
+def test_fast_resume_new_session(accelize_drm, conf_json, cred_json, async_handler,
+                                 license_ws_mock):
+    """
+    Test the pending session is replaced when the resume is not requested
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    mock = license_ws_mock
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    session_id = _pause_session(accelize_drm, conf_json, cred_json, async_cb, bus, mock)
+
+    mock.configure(latency=0)
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, bus.read_register_callback,
+        bus.write_register_callback, async_cb.callback)
+    try:
+        drm_manager.activate()
+        assert drm_manager.get('session_id') != session_id
+        assert drm_manager.get('license_status')
+        _assert_frequency(drm_manager, conf_json)
+        drm_manager.deactivate()
+    finally:
+        drm_manager.free()
+    assert mock.stats()['license_requests']['close'] == 2
+    assert mock.stats()['sessions_open'] == 0
+    async_cb.assert_NoError()
+
+
+def test_fast_resume_bad_frequency(accelize_drm, conf_json, cred_json, async_handler,
+                                   license_ws_mock):
+    """
+    Test a frequency out of range is reported by the activation resuming the session
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    mock = license_ws_mock
+    bus = FaultInjectingBus(accelize_drm.pytest_fpga_driver[0])
+    _pause_session(accelize_drm, conf_json, cred_json, async_cb, bus, mock)
+    running_requests = mock.stats()['license_requests']['running']
+    frequency = conf_json['drm']['frequency_mhz']
+
+    mock.configure(latency=0)
+    conf_json['drm']['frequency_mhz'] = frequency * 2
+    conf_json.save()
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, bus.read_register_callback,
+        bus.write_register_callback, async_cb.callback)
+    try:
+        with pytest.raises(accelize_drm.exceptions.DRMBadFrequency) as excinfo:
+            drm_manager.activate(True)
+        assert 'differs from' in str(excinfo.value)
+        assert mock.stats()['license_requests']['running'] == running_requests
+    finally:
+        drm_manager.free()
+    async_cb.reset()
+
+    # Close the pending session with the right frequency
+    conf_json['drm']['frequency_mhz'] = frequency
+    conf_json.save()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path, bus.read_register_callback,
+            bus.write_register_callback, async_cb.callback) as drm_manager:
+        drm_manager.activate()
+        drm_manager.deactivate()
+    assert mock.stats()['sessions_open'] == 0
+    async_cb.assert_NoError()
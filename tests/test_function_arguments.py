@@ -579,6 +579,11 @@ def test_c_unittests(accelize_drm, exec_func):
     assert exec_lib.returncode == 0
     assert exec_lib.asyncmsg is None
 
+    # Test the lookup of each parameter key by ID and by name, and the typed get functions
+    exec_lib.run('test_parameter_key_lookup')
+    assert exec_lib.returncode == 0
+    assert 'Cannot find parameter: unknown_parameter' in exec_lib.asyncmsg
+
     # Test out of range of get function
     exec_lib.run('test_get_function_out_of_range')
     assert exec_lib.returncode == accelize_drm.exceptions.DRMBadArg.error_code
@@ -311,6 +311,36 @@ def test_versions_displayed_in_log_file(accelize_drm, conf_json, cred_json, asyn
     logfile.remove()
 
 
+def test_async_log_file_flushed_on_error(accelize_drm, conf_json, cred_json, async_handler,
+                                         log_file_factory):
+    """Test the asynchronous logging writes the error message before the error is reported"""
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    logfile = log_file_factory.create(2, type=1)
+    conf_json.reset()
+    conf_json['settings'].update(logfile.json)
+    conf_json['settings']['log_async'] = True
+    conf_json['settings']['log_async_queue_size'] = 16
+    conf_json.save()
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                driver.read_register_callback,
+                driver.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        assert drm_manager.get('log_async')
+        with pytest.raises(accelize_drm.exceptions.DRMBadArg):
+            drm_manager.set(ws_request_timeout=0)
+        # The manager is still alive: the message must already be in the file
+        log_content = logfile.read()
+        assert "Parameter 'ws_request_timeout' cannot be overwritten" in log_content
+    async_cb.assert_Error(accelize_drm.exceptions.DRMBadArg.error_code,
+                          "Parameter 'ws_request_timeout' cannot be overwritten")
+    logfile.remove()
+
+
 def test_log_file_parameters_modifiability(accelize_drm, conf_json, cred_json, async_handler, request,
                                         log_file_factory):
     """Once the log file has been created, test the parameters cannot be modified except verbosity and format """
@@ -126,6 +126,128 @@ def test_metered_start_stop_short_time_in_debug(accelize_drm, conf_json, cred_js
     logfile.remove()
 
 
+@pytest.mark.minimum
+@pytest.mark.hwtst
+def test_read_metering(accelize_drm, conf_json, cred_json, async_handler, log_file_factory):
+    """
+    Test the lightweight metering read returns the same counters as the metered_data parameter
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    activators = accelize_drm.pytest_fpga_activators[0]
+    activators.reset_coin()
+    activators.autotest()
+    cred_json.set_user('accelize_accelerator_test_02')
+
+    async_cb.reset()
+    conf_json.reset()
+    logfile = log_file_factory.create(1)
+    conf_json['settings'].update(logfile.json)
+    conf_json.save()
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                driver.read_register_callback,
+                driver.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        assert drm_manager.read_metering() == []
+        drm_manager.activate()
+        nb_activators = drm_manager.get('num_activators')
+        assert drm_manager.read_metering() == [0] * nb_activators
+        activators.generate_coin()
+        for _ in range(10):
+            activators.check_coin(drm_manager.read_metering())
+        assert drm_manager.read_metering() == drm_manager.get('metered_data')
+        drm_manager.deactivate()
+        assert drm_manager.read_metering() == []
+        async_cb.assert_NoError()
+    logfile.remove()
+
+
+@pytest.mark.hwtst
+def test_read_metering_with_cache(accelize_drm, conf_json, cred_json, async_handler, log_file_factory):
+    """
+    Test the metering snapshot is shared until it is older than the metering_cache_period parameter
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    activators = accelize_drm.pytest_fpga_activators[0]
+    activators.reset_coin()
+    activators.autotest()
+    cred_json.set_user('accelize_accelerator_test_02')
+    cache_period = 3
+
+    async_cb.reset()
+    conf_json.reset()
+    conf_json['settings']['metering_cache_period'] = cache_period * 1000
+    logfile = log_file_factory.create(1)
+    conf_json['settings'].update(logfile.json)
+    conf_json.save()
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                driver.read_register_callback,
+                driver.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        drm_manager.activate()
+        # Wait the licensing thread has provisioned the next license
+        wait_func_true(lambda: drm_manager.get('num_license_loaded') == 2, 10)
+        snapshot = drm_manager.read_metering()
+        activators.generate_coin()
+        # Snapshot is still fresh: counters are not updated yet
+        assert drm_manager.read_metering() == snapshot
+        assert drm_manager.get('metered_data') == snapshot
+        sleep(cache_period + 1)
+        # Snapshot is outdated: counters are updated
+        activators.check_coin(drm_manager.read_metering())
+        activators.check_coin(drm_manager.get('metered_data'))
+        drm_manager.deactivate()
+        async_cb.assert_NoError()
+    logfile.remove()
+
+
+@pytest.mark.hwtst
+def test_status_snapshot(accelize_drm, conf_json, cred_json, async_handler, log_file_factory):
+    """
+    Test the status parameters are read from the snapshot published by the background threads
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    cred_json.set_user('accelize_accelerator_test_02')
+
+    async_cb.reset()
+    conf_json.reset()
+    conf_json['settings']['status_cached'] = True
+    logfile = log_file_factory.create(1)
+    conf_json['settings'].update(logfile.json)
+    conf_json.save()
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                driver.read_register_callback,
+                driver.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        assert not drm_manager.get('session_status')
+        version = drm_manager.get('status_version')
+        drm_manager.activate()
+        assert drm_manager.get('status_version') > version
+        assert drm_manager.get('session_status')
+        assert drm_manager.get('license_status')
+        assert drm_manager.get('drm_license_type') == 'Floating/Metering'
+        # Wait the licensing thread has published the next license
+        wait_func_true(lambda: drm_manager.get('num_license_loaded') == 2, 10)
+        version = drm_manager.get('status_version')
+        assert drm_manager.get('status_version') == version
+        drm_manager.deactivate()
+        assert drm_manager.get('status_version') > version
+        assert not drm_manager.get('session_status')
+        async_cb.assert_NoError()
+    logfile.remove()
+
+
 @pytest.mark.long_run
 @pytest.mark.hwtst
 def test_metered_start_stop_long_time(accelize_drm, conf_json, cred_json, async_handler, log_file_factory):
@@ -4,8 +4,9 @@ Test node-locked behavior of DRM Library.
 """
 import pytest
 from os import remove, getpid, environ
-from os.path import isfile, realpath
-from re import match, search, finditer, IGNORECASE
+from os.path import isfile, realpath, exists
+from re import match, search, finditer, IGNORECASE, MULTILINE
+from socket import socket, AF_UNIX, SOCK_STREAM
 from time import sleep, time
 from random import choice
 
@@ -77,7 +78,14 @@ _PARAM_LIST = ('license_type',
                'log_ctrl_verbosity',
                'is_drm_software',
                'controller_version',
-               'controller_rom'
+               'controller_rom',
+               'metering_cache_period',
+               'status_cached',
+               'status_version',
+               'log_async',
+               'register_trace_dump',
+               'metrics',
+               'controller_latency'
 )
 
 
@@ -430,6 +438,55 @@ def test_parameter_key_modification_with_config_file(accelize_drm, conf_json, cr
     async_cb.assert_NoError()
     print("Test parameter 'ws_api_retry_duration': PASS")
 
+    # Test parameter: metering_cache_period
+    async_cb.reset()
+    conf_json.reset()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        assert drm_manager.get('metering_cache_period') == 0
+    async_cb.reset()
+    conf_json.reset()
+    exp_value = 1500
+    conf_json['settings']['metering_cache_period'] = exp_value
+    conf_json.save()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        assert drm_manager.get('metering_cache_period') == exp_value
+    async_cb.assert_NoError()
+    print("Test parameter 'metering_cache_period': PASS")
+
+    # Test parameter: status_cached
+    async_cb.reset()
+    conf_json.reset()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        assert not drm_manager.get('status_cached')
+    async_cb.reset()
+    conf_json.reset()
+    conf_json['settings']['status_cached'] = True
+    conf_json.save()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        assert drm_manager.get('status_cached')
+    async_cb.assert_NoError()
+    print("Test parameter 'status_cached': PASS")
+
     # Test parameter: ws_request_timeout
     async_cb.reset()
     conf_json.reset()
@@ -516,6 +573,144 @@ def test_parameter_key_modification_with_config_file(accelize_drm, conf_json, cr
     async_cb.assert_NoError()
     print("Test parameter 'log_file_append': PASS")
 
+    # Test parameter: log_async
+    async_cb.reset()
+    conf_json.reset()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        assert not drm_manager.get('log_async')
+    conf_json.reset()
+    conf_json['settings']['log_async'] = True
+    conf_json.save()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        assert drm_manager.get('log_async')
+    async_cb.assert_NoError()
+    print("Test parameter 'log_async': PASS")
+
+    # Test parameter: register_trace_dump
+    async_cb.reset()
+    conf_json.reset()
+    trace_path = realpath('register_trace_%d.trace' % getpid())
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        with pytest.raises(accelize_drm.exceptions.DRMBadUsage) as excinfo:
+            drm_manager.set(register_trace_dump=trace_path)
+        assert 'Register trace is disabled' in str(excinfo.value)
+    async_cb.reset()
+    assert not isfile(trace_path)
+    conf_json['settings']['register_trace_size'] = 1024
+    conf_json.save()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        drm_manager.set(register_trace_dump=trace_path)
+    assert isfile(trace_path)
+    with open(trace_path, 'rb') as f:
+        assert f.read(8) == b'DRMTRACE'
+    remove(trace_path)
+    async_cb.assert_NoError()
+    print("Test parameter 'register_trace_dump': PASS")
+
+    # Test parameter: metrics
+    async_cb.reset()
+    conf_json.reset()
+    metrics_socket = realpath('metrics_%d.sock' % getpid())
+    conf_json['settings']['metrics'] = True
+    conf_json['settings']['metrics_endpoint'] = 'unix:' + metrics_socket
+    conf_json.save()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        # The design information is read at construction: read a status register
+        drm_manager.get('license_status')
+        metrics = drm_manager.get('metrics')
+        assert metrics.startswith('# TYPE ')
+        assert metrics.endswith('# EOF\n')
+        m = search(r'^drm_register_reads_total (\d+)$', metrics, MULTILINE)
+        assert m and int(m.group(1)) > 0
+        assert search(r'^drm_license_time_left_seconds\{instance="\d+"\} 0$', metrics, MULTILINE)
+        with socket(AF_UNIX, SOCK_STREAM) as client:
+            client.connect(metrics_socket)
+            client.sendall(b'GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n')
+            response = b''
+            while True:
+                data = client.recv(4096)
+                if not data:
+                    break
+                response += data
+        assert response.startswith(b'HTTP/1.1 200 OK')
+        assert b'application/openmetrics-text' in response
+        assert response.endswith(b'# EOF\n')
+    assert not exists(metrics_socket)
+    async_cb.assert_NoError()
+    # A path which is not a socket is not replaced by the endpoint
+    with open(metrics_socket, 'w') as f:
+        f.write('not a socket')
+    with pytest.raises(accelize_drm.exceptions.DRMBadUsage) as excinfo:
+        accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        )
+    assert 'is not a socket' in str(excinfo.value)
+    assert isfile(metrics_socket)
+    remove(metrics_socket)
+    async_cb.reset()
+    print("Test parameter 'metrics': PASS")
+
+    # Test parameter: controller_latency
+    async_cb.reset()
+    conf_json.reset()
+    conf_json['settings']['metrics'] = True
+    conf_json.save()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        drm_manager.get('license_status')
+        latency = drm_manager.get('controller_latency')
+        assert isinstance(latency, dict)
+        op_latency = latency['readLicenseTimerCountEmptyStatusRegister']
+        assert op_latency['count'] > 0
+        assert 0 < op_latency['p50_us'] <= op_latency['p99_us'] <= op_latency['max_us']
+        metrics = drm_manager.get('metrics')
+        assert 'drm_controller_operation_seconds_count{operation="readLicenseTimerCountEmptyStatusRegister"}' in metrics
+    # The latency is not recorded while the metrics are disabled
+    conf_json.reset()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path,
+            driver.read_register_callback,
+            driver.write_register_callback,
+            async_cb.callback
+        ) as drm_manager:
+        count = drm_manager.get('controller_latency')['readLicenseTimerCountEmptyStatusRegister']['count']
+        drm_manager.get('license_status')
+        assert drm_manager.get('controller_latency')['readLicenseTimerCountEmptyStatusRegister']['count'] == count
+    async_cb.assert_NoError()
+    print("Test parameter 'controller_latency': PASS")
+
     # Test parameter: ws_verbosity
     async_cb.reset()
     conf_json.reset()
@@ -961,6 +1156,25 @@ def test_parameter_key_modification_with_get_set(accelize_drm, conf_json, cred_j
         async_cb.assert_NoError()
         print("Test parameter 'ws_api_retry_duration': PASS")
 
+        # Test parameter: metering_cache_period
+        orig_cache_period = drm_manager.get('metering_cache_period')  # Save original value
+        exp_value = 2000
+        drm_manager.set(metering_cache_period=exp_value)
+        assert drm_manager.get('metering_cache_period') == exp_value
+        drm_manager.set(metering_cache_period=orig_cache_period)  # Restore original value
+        assert drm_manager.get('metering_cache_period') == orig_cache_period
+        async_cb.assert_NoError()
+        print("Test parameter 'metering_cache_period': PASS")
+
+        # Test parameter: status_cached
+        orig_status_cached = drm_manager.get('status_cached')  # Save original value
+        drm_manager.set(status_cached=True)
+        assert drm_manager.get('status_cached')
+        drm_manager.set(status_cached=orig_status_cached)  # Restore original value
+        assert drm_manager.get('status_cached') == orig_status_cached
+        async_cb.assert_NoError()
+        print("Test parameter 'status_cached': PASS")
+
         # Test parameter: ws_request_timeout
         orig_request_timeout = drm_manager.get('ws_request_timeout') + 100
         with pytest.raises(accelize_drm.exceptions.DRMBadArg) as excinfo:
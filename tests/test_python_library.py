@@ -81,6 +81,184 @@ def test_get_api_version(accelize_drm):
         accelize_drm._get_api_version = accelize_drm__get_api_version
 
 
+def test_native_registers(accelize_drm, conf_json, cred_json, async_handler):
+    """
+    Test a session with a native register backend that does not call back Python.
+    """
+    from threading import Thread
+    from time import time
+    from tests.ws_mock import LicenseWSMock
+
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Native register test requires the "simulator" FPGA driver')
+    driver = accelize_drm.pytest_fpga_driver[0]
+    driver.reset_fpga()
+    async_cb = async_handler.create()
+    async_cb.reset()
+    registers = driver.native_registers
+
+    # Write register callback must be None with a native register backend
+    with pytest.raises(accelize_drm.exceptions.DRMBadArg):
+        accelize_drm.DrmManager(conf_json.path, cred_json.path, registers,
+                                driver.write_register_callback, async_cb.callback)
+    with pytest.raises(TypeError):
+        accelize_drm.registers.NativeRegisters(lambda: 0, None)
+
+    # A Python thread keeps running while the DRM Library accesses the registers
+    ticks = []
+    running = [True]
+
+    def tick():
+        while running[0]:
+            ticks.append(time())
+
+    with LicenseWSMock() as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json.save()
+        thread = Thread(target=tick)
+        thread.start()
+        try:
+            with accelize_drm.DrmManager(conf_json.path, cred_json.path, registers,
+                                         None, async_cb.callback) as drm_manager:
+                drm_manager.activate()
+                assert drm_manager.get('license_status')
+                drm_manager.deactivate()
+                assert not drm_manager.get('license_status')
+        finally:
+            running[0] = False
+            thread.join()
+    async_cb.assert_NoError()
+    assert ticks
+
+
+def test_mapped_registers(accelize_drm, conf_json, cred_json, async_handler, tmpdir):
+    """
+    Test the memory mapped register backend on a file without DRM Controller.
+    """
+    bar = tmpdir.join('resource0')
+    bar.write_binary(b'\xaa' * 0x4000)
+    async_cb = async_handler.create()
+    with accelize_drm.registers.MappedRegisters(
+            str(bar), base_address=0x1000, size=0x2000) as registers:
+        with pytest.raises(accelize_drm.exceptions.DRMCtlrError):
+            accelize_drm.DrmManager(conf_json.path, cred_json.path, registers,
+                                    None, async_cb.callback)
+
+    # Page register selected in the DRM Controller address range only
+    data = bar.read_binary()
+    assert data[0x1000:0x1004] == b'\0' * 4
+    assert data[:0x1000] + data[0x3000:] == b'\xaa' * 0x2000
+
+
+def test_typed_getters(accelize_drm, conf_json, cred_json, async_handler):
+    """
+    Test the typed getters return the same values as "get".
+    """
+    from tests.ws_mock import LicenseWSMock
+
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Typed getters test requires the "simulator" FPGA driver')
+    driver = accelize_drm.pytest_fpga_driver[0]
+    driver.reset_fpga()
+    async_cb = async_handler.create()
+    async_cb.reset()
+
+    def check(drm_manager):
+        assert drm_manager.get_license_status() is drm_manager.get('license_status')
+        assert drm_manager.get_session_status() is drm_manager.get('session_status')
+        assert drm_manager.get_session_id() == drm_manager.get('session_id')
+        assert drm_manager.get_num_license_loaded() == drm_manager.get('num_license_loaded')
+
+    with LicenseWSMock() as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json.save()
+        with accelize_drm.DrmManager(
+                conf_json.path, cred_json.path, driver.read_register_callback,
+                driver.write_register_callback, async_cb.callback) as drm_manager:
+            check(drm_manager)
+            assert drm_manager.get_metered_data() == []
+            drm_manager.activate()
+            check(drm_manager)
+            assert drm_manager.get_license_status()
+            assert drm_manager.get_session_id()
+            metered_data = drm_manager.get_metered_data()
+            assert all(isinstance(value, int) for value in metered_data)
+            assert metered_data == drm_manager.read_metering()
+            drm_manager.deactivate()
+            check(drm_manager)
+            assert not drm_manager.get_session_status()
+    async_cb.assert_NoError()
+
+
+def test_read_metering_during_renewals(accelize_drm, conf_json, cred_json, async_handler):
+    """
+    Test read_metering never returns outdated counters while the licensing thread holds
+    the metering access for its license requests, and does not wait for these requests
+    when the snapshot is within the cache period
+    """
+    from threading import Thread
+    from time import sleep, time
+    from tests.ws_mock import LicenseWSMock
+
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Metering read test requires the "simulator" FPGA driver')
+    driver = accelize_drm.pytest_fpga_driver[0]
+    driver.reset_fpga()
+    activators = accelize_drm.pytest_fpga_activators[0]
+    activators.reset_coin()
+    async_cb = async_handler.create()
+    async_cb.reset()
+    latency = 0.5
+
+    with LicenseWSMock(license_timeout=2) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json.save()
+        with accelize_drm.DrmManager(
+                conf_json.path, cred_json.path, driver.read_register_callback,
+                driver.write_register_callback, async_cb.callback) as drm_manager:
+            drm_manager.activate()
+            nb_renewals = mock.stats()['license_requests']['running']
+            mock.configure(latency=latency)
+
+            # Cache disabled: each read returns the current counters, even during a license request
+            end = time() + 5
+            while time() < end:
+                activators.generate_coin(1)
+                activators.check_coin(drm_manager.read_metering())
+            assert mock.stats()['license_requests']['running'] > nb_renewals
+
+            # Cache enabled: the reads within the cache period do not wait for the license requests
+            drm_manager.set(metering_cache_period=10000)
+            drm_manager.read_metering()
+            durations = []
+            errors = []
+
+            def poll():
+                end = time() + 3
+                while time() < end:
+                    start = time()
+                    try:
+                        drm_manager.read_metering()
+                    except Exception as exception:
+                        errors.append(exception)
+                    durations.append(time() - start)
+                    sleep(0.01)
+
+            threads = [Thread(target=poll) for _ in range(4)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            assert not errors
+            assert max(durations) < latency
+            mock.configure(latency=0)
+            drm_manager.deactivate()
+    async_cb.assert_NoError()
+
+
 @pytest.mark.packages
 def test_packages_import(pytestconfig):
     """
@@ -0,0 +1,398 @@
+# -*- coding: utf-8 -*-
+"""
+Test the recovery and failure times of the DRM Library on a slow or glitchy
+register bus.
+
+The faults are injected by tests.fault_bus.FaultInjectingBus. The sessions run
+on the DRM Controller simulator with the local License Web Service mock, so the
+license renewal period can be short. The measured durations are recorded as
+test properties ("--junitxml" report) to tune the
+DRM_CONTROLLER_TIMEOUT_IN_MICRO_SECONDS and DRM_CONTROLLER_SLEEP_IN_MICRO_SECONDS
+environment variables.
+"""
+import pytest
+from time import time, sleep
+
+from tests.conftest import wait_func_true
+from tests.fault_bus import FaultInjectingBus, constant, uniform, lognormal, spikes
+from tests.ws_mock import LicenseWSMock
+
+LICENSE_TIMEOUT = 6
+
+LATENCY_PROFILES = {
+    'no_latency': None,
+    'uniform': uniform(10e-6, 100e-6),
+    'heavy_tail': lognormal(50e-6, 1.5),
+    'spikes': spikes(constant(20e-6), 0.005, uniform(5e-3, 20e-3)),
+}
+
+
+@pytest.fixture
+def license_ws_mock(accelize_drm, conf_json):
+    """License Web Service mock set in the configuration file"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Fault injection tests require the "simulator" FPGA driver')
+    # Start each test with a DRM Controller in its initial state
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    with LicenseWSMock(license_timeout=LICENSE_TIMEOUT) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json['settings']['ws_api_retry_duration'] = 0
+        conf_json.save()
+        yield mock
+
+
+def _timed(func, *args):
+    """Run a function, return its duration in seconds"""
+    start = time()
+    func(*args)
+    return time() - start
+
+
+@pytest.mark.parametrize('profile', LATENCY_PROFILES)
+def test_latency_recovery(accelize_drm, conf_json, cred_json, async_handler,
+                          license_ws_mock, record_property, profile):
+    """
+    Measure activation, renewal and deactivation durations with register access latency
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    latency = LATENCY_PROFILES[profile]
+    bus = FaultInjectingBus(driver, read_latency=latency, write_latency=latency)
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                bus.read_register_callback,
+                bus.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        activate_s = _timed(drm_manager.activate)
+        assert drm_manager.get('license_status')
+
+        # Wait for 2 renewals
+        start = time()
+        wait_func_true(
+            lambda: license_ws_mock.stats()['license_requests']['running'] >= 2,
+            timeout=4 * LICENSE_TIMEOUT, sleep_time=0.1)
+        renewal_s = (time() - start) / 2
+        assert drm_manager.get('license_status')
+
+        deactivate_s = _timed(drm_manager.deactivate)
+        assert not drm_manager.get('license_status')
+    async_cb.assert_NoError()
+
+    stats = bus.stats()
+    for name, value in (('activate_s', activate_s), ('renewal_s', renewal_s),
+                        ('deactivate_s', deactivate_s), ('register_accesses', stats['reads'] + stats['writes']),
+                        ('max_register_latency_s', stats['max_delay_s'])):
+        record_property(name, value)
+    print('%s: activate=%.3fs, renewal=%.3fs, deactivate=%.3fs, %s' % (
+        profile, activate_s, renewal_s, deactivate_s, stats))
+
+
+def test_sporadic_read_errors(accelize_drm, conf_json, cred_json, async_handler,
+                              license_ws_mock, record_property):
+    """
+    Test sporadic read errors either pass unnoticed or fail fast with a DRM Controller error
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    nb_cycles = 10
+    failures = []
+    for _ in range(nb_cycles):
+        driver.reset_fpga()
+        async_cb = async_handler.create()
+        bus = FaultInjectingBus(driver, read_error_rate=0.002)
+        start = time()
+        try:
+            with accelize_drm.DrmManager(
+                        conf_json.path,
+                        cred_json.path,
+                        bus.read_register_callback,
+                        bus.write_register_callback,
+                        async_cb.callback
+                    ) as drm_manager:
+                drm_manager.activate()
+                drm_manager.deactivate()
+        except accelize_drm.exceptions.DRMCtlrError:
+            failures.append(time() - start)
+            assert bus.stats()['read_errors']
+        else:
+            # The background thread may have hit an error too
+            if async_cb.was_called:
+                async_cb.assert_Error(accelize_drm.exceptions.DRMCtlrError.error_code)
+    record_property('failed_cycles', len(failures))
+    if failures:
+        record_property('max_time_to_fail_s', max(failures))
+        # A failing register access must not wait for a controller timeout
+        assert max(failures) < 10
+    print('%d/%d cycles failed, times to fail: %s' % (len(failures), nb_cycles, failures))
+
+
+def test_bus_down_during_session(accelize_drm, conf_json, cred_json, async_handler,
+                                 license_ws_mock, record_property):
+    """
+    Test a register bus failing while the session is running is reported asynchronously
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    bus = FaultInjectingBus(driver)
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                bus.read_register_callback,
+                bus.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        drm_manager.activate()
+        bus.configure(read_error_rate=1.0)
+        start = time()
+        wait_func_true(lambda: async_cb.was_called, timeout=2 * LICENSE_TIMEOUT, sleep_time=0.1)
+        detection_s = time() - start
+        async_cb.assert_Error(accelize_drm.exceptions.DRMCtlrError.error_code, 'failed with error code')
+
+        # The session can be closed once the bus has recovered
+        bus.clear()
+        sleep(1)
+        drm_manager.deactivate()
+    record_property('time_to_detect_s', detection_s)
+    print('Bus failure reported after %.3fs' % detection_s)
+
+
+def test_status_snapshot_read_error(accelize_drm, conf_json, cred_json, async_handler,
+                                    license_ws_mock):
+    """
+    Test a read error while a status snapshot is published is reported instead of
+    blocking the DRM Controller lock forever
+    """
+    from threading import Thread
+
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    license_duration = 2
+    license_ws_mock.configure(license_timeout=license_duration)
+    conf_json['settings']['status_cached'] = True
+    conf_json.save()
+    bus = FaultInjectingBus(driver)
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                bus.read_register_callback,
+                bus.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        drm_manager.activate()
+        wait_func_true(lambda: drm_manager.get('num_license_loaded') == 2,
+                       timeout=license_duration * 2, sleep_time=0.1)
+        license_ws_mock.configure(error_rate=1, error_codes=[503], error_endpoints=['license'])
+        # Once the licenses have expired, the next status read publishes a new snapshot
+        sleep(license_duration * 2 + 1)
+        bus.configure(read_error_rate=1.0)
+        errors = []
+
+        def read_status():
+            try:
+                drm_manager.get('license_status')
+            except accelize_drm.exceptions.DRMCtlrError as exception:
+                errors.append(exception)
+
+        thread = Thread(target=read_status, daemon=True)
+        thread.start()
+        thread.join(timeout=10)
+        assert not thread.is_alive()
+        assert errors
+        bus.clear()
+        assert not drm_manager.get('license_status')
+        license_ws_mock.configure(error_rate=0)
+        drm_manager.deactivate()
+    async_cb.reset()
+
+
+@pytest.mark.parametrize('bit, value, step, error_msg', [
+    ('dna_ready', 0, 'init', r'DNA Extraction is in timeout'),
+    ('activation_codes_transmitted', 0, 'activate', r'could not transmit Licence'),
+])
+def test_stuck_status_bit(accelize_drm, conf_json, cred_json, async_handler,
+                          license_ws_mock, monkeypatch, record_property,
+                          bit, value, step, error_msg):
+    """
+    Test a stuck status bit makes the operation fail after the DRM Controller timeout
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    timeout_us = 100000
+    monkeypatch.setenv('DRM_CONTROLLER_TIMEOUT_IN_MICRO_SECONDS', str(timeout_us))
+    # The activation code transmission timeout is 20 times the controller timeout
+    max_duration = 20 * timeout_us / 1e6 + 3
+
+    bus = FaultInjectingBus(driver)
+    bus.stick(bit, value)
+    start = time()
+    with pytest.raises(accelize_drm.exceptions.DRMCtlrError) as excinfo:
+        drm_manager = accelize_drm.DrmManager(
+            conf_json.path,
+            cred_json.path,
+            bus.read_register_callback,
+            bus.write_register_callback,
+            async_cb.callback
+        )
+        assert step != 'init'
+        start = time()
+        try:
+            drm_manager.activate()
+        finally:
+            bus.clear()
+            del drm_manager
+    duration = time() - start
+    assert async_handler.get_error_code(str(excinfo.value)) == accelize_drm.exceptions.DRMCtlrError.error_code
+    assert excinfo.match(error_msg)
+    assert bus.stats()['stuck_reads']
+    assert duration < max_duration
+    record_property('time_to_fail_s', duration)
+    print('Stuck %s=%d: %s failed after %.3fs' % (bit, value, step, duration))
+
+
+@pytest.mark.parametrize('concurrent', [False, True])
+def test_register_access_concurrency(accelize_drm, conf_json, cred_json, async_handler,
+                                     license_ws_mock, concurrent):
+    """
+    Test the register callbacks are serialized unless concurrent accesses are
+    allowed, and the status reads sharing the DRM Controller never run during
+    the exclusive sequences switching the page
+    """
+    from threading import Thread
+
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    conf_json['settings']['concurrent_register_access'] = concurrent
+    conf_json.save()
+    bus = FaultInjectingBus(driver, read_latency=constant(1e-3))
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                bus.read_register_callback,
+                bus.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        drm_manager.activate()
+        bus.reset_stats()
+        statuses = []
+        errors = []
+
+        def poll(func):
+            end = time() + 2
+            while time() < end:
+                try:
+                    statuses.append(func())
+                except Exception as exception:
+                    errors.append(exception)
+
+        threads = [Thread(target=poll, args=(lambda: drm_manager.get('session_status'),))
+                   for _ in range(4)]
+        # Metering extractions switch the page of the DRM Controller
+        threads.append(Thread(target=poll, args=(lambda: bool(drm_manager.read_metering()),)))
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        assert not errors
+        assert statuses and all(statuses)
+        if concurrent:
+            assert bus.stats()['max_concurrency'] > 1
+        else:
+            assert bus.stats()['max_concurrency'] == 1
+        drm_manager.deactivate()
+    async_cb.assert_NoError()
+
+
+def test_writer_progress_under_readers(accelize_drm, conf_json, cred_json, async_handler,
+                                      license_ws_mock):
+    """
+    Test the licenses are renewed while status reads share the DRM Controller
+    continuously: the queued exclusive accesses are not starved by the readers
+    """
+    from threading import Thread
+
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    license_duration = 3
+    license_ws_mock.configure(license_timeout=license_duration)
+    conf_json['settings']['concurrent_register_access'] = True
+    conf_json.save()
+    bus = FaultInjectingBus(driver, read_latency=constant(2e-3))
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                bus.read_register_callback,
+                bus.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        drm_manager.activate()
+        renewals = license_ws_mock.stats()['license_requests']['running']
+        errors = []
+        statuses = []
+
+        def poll():
+            end = time() + 4 * license_duration
+            while time() < end:
+                try:
+                    statuses.append(drm_manager.get('license_status'))
+                except Exception as exception:
+                    errors.append(exception)
+
+        threads = [Thread(target=poll) for _ in range(8)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        assert not errors
+        assert statuses and all(statuses)
+        assert bus.stats()['max_concurrency'] > 1
+        # A license is provisioned each license duration
+        assert license_ws_mock.stats()['license_requests']['running'] - renewals >= 3
+        assert drm_manager.get('license_status')
+        drm_manager.deactivate()
+    async_cb.assert_NoError()
+
+
+@pytest.mark.parametrize('cached', [False, True])
+def test_page_register_cache(accelize_drm, conf_json, cred_json, async_handler,
+                             license_ws_mock, cached):
+    """
+    Test the page register is written before each status read unless it is
+    cached, and a page selected outside the library is restored by default
+    """
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    conf_json['settings']['page_register_cached'] = cached
+    conf_json.save()
+    bus = FaultInjectingBus(driver)
+    with accelize_drm.DrmManager(
+                conf_json.path,
+                cred_json.path,
+                bus.read_register_callback,
+                bus.write_register_callback,
+                async_cb.callback
+            ) as drm_manager:
+        drm_manager.activate()
+        assert drm_manager.get('session_status')
+        # Wait the licensing thread has provisioned the next license, so it does not access the registers
+        wait_func_true(lambda: drm_manager.get('num_license_loaded') == 2,
+                       timeout=LICENSE_TIMEOUT, sleep_time=0.1)
+        bus.reset_stats()
+        for _ in range(10):
+            assert drm_manager.get('session_status')
+        stats = bus.stats()
+        assert stats['writes'] == (0 if cached else 10)
+        if not cached:
+            # Another software selects a page of the DRM Controller
+            driver.write_register_callback(0, 1)
+            assert drm_manager.get('session_status')
+        drm_manager.deactivate()
+    async_cb.assert_NoError()
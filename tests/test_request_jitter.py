@@ -0,0 +1,117 @@
+# -*- coding: utf-8 -*-
+"""
+Test the random jitter of the license renewals and of the health requests.
+"""
+import pytest
+from time import sleep
+
+from tests.conftest import wait_func_true
+from tests.fpga_drivers import get_driver
+from tests.ws_mock import LicenseWSMock
+
+
+@pytest.fixture
+def license_ws_mock(accelize_drm, conf_json):
+    """License Web Service mock with short licenses"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Request jitter tests require the "simulator" FPGA driver')
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    with LicenseWSMock(license_timeout=4) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json.save()
+        yield mock
+
+
+def _request_times(mock, endpoint):
+    """Return the time of the requests of each board"""
+    boards = {}
+    for entry in mock.timeline():
+        if entry['endpoint'] == endpoint:
+            boards.setdefault(entry['dna'], []).append(entry['time'])
+    return boards
+
+
+def test_license_renewal_jitter(accelize_drm, conf_json, cred_json, async_handler,
+                                license_ws_mock):
+    """Test the renewals of boards started together are spread"""
+    mock = license_ws_mock
+    nb_boards = 8
+    # Licenses long enough for the jitter to exceed the timing noise
+    mock.configure(license_timeout=10)
+    license_duration = mock.config['license_timeout']
+    jitter = 0.1
+    conf_json['settings']['license_renewal_jitter'] = jitter
+    conf_json.save()
+    async_cb = async_handler.create()
+    async_cb.reset()
+    drivers = [get_driver('simulator')(fpga_slot_id=i, drm_ctrl_base_addr=0)
+               for i in range(nb_boards)]
+    drm_managers = [accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, driver.read_register_callback,
+        driver.write_register_callback, async_cb.callback) for driver in drivers]
+    try:
+        mock.reset_stats()
+        for drm_manager in drm_managers:
+            drm_manager.activate()
+        # Open, first renewal as soon as the session starts, then renewal when a license expires
+        wait_func_true(lambda: mock.stats()['license_requests']['running'] == 2 * nb_boards,
+                       timeout=license_duration * 2 + 2, sleep_time=0.2)
+        assert all(drm_manager.get('license_status') for drm_manager in drm_managers)
+    finally:
+        for drm_manager in drm_managers:
+            drm_manager.free()
+
+    boards = _request_times(mock, 'license')
+    assert len(boards) == nb_boards
+    delays = [times[2] - times[0] - license_duration for times in boards.values()]
+    assert max(delays) - min(delays) > 0.3
+    assert max(delays) <= 1 + jitter * license_duration + 1
+    async_cb.assert_NoError()
+
+
+def test_health_period_jitter(accelize_drm, conf_json, cred_json, async_handler,
+                              license_ws_mock):
+    """Test the health period is randomly reduced by at most the jitter"""
+    mock = license_ws_mock
+    health_period = 2
+    mock.configure(license_timeout=30, health_period=health_period)
+    conf_json['settings']['health_period_jitter'] = 0.5
+    conf_json.save()
+    async_cb = async_handler.create()
+    async_cb.reset()
+    driver = accelize_drm.pytest_fpga_driver[0]
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, driver.read_register_callback,
+        driver.write_register_callback, async_cb.callback)
+    try:
+        mock.reset_stats()
+        drm_manager.activate()
+        sleep(health_period * 5)
+        drm_manager.deactivate()
+    finally:
+        drm_manager.free()
+
+    times = list(_request_times(mock, 'health').values())[0]
+    assert len(times) >= 5
+    intervals = [current - previous for previous, current in zip(times, times[1:])]
+    assert min(intervals) >= health_period * 0.5 - 0.1
+    assert max(intervals) <= health_period + 0.5
+    assert max(intervals) - min(intervals) > 0.05
+    async_cb.assert_NoError()
+
+
+def test_license_renewal_jitter_bound(accelize_drm, conf_json, cred_json, async_handler,
+                                      license_ws_mock):
+    """Test a renewal jitter taking too much of the retry budget is rejected"""
+    conf_json['settings']['license_renewal_jitter'] = 0.2
+    conf_json.save()
+    async_cb = async_handler.create()
+    async_cb.reset()
+    driver = accelize_drm.pytest_fpga_driver[0]
+    with pytest.raises(accelize_drm.exceptions.DRMBadArg) as excinfo:
+        accelize_drm.DrmManager(
+            conf_json.path, cred_json.path, driver.read_register_callback,
+            driver.write_register_callback, async_cb.callback)
+    assert 'must be in [0, 0.1]' in str(excinfo.value)
+    async_cb.reset()
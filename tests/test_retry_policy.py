@@ -0,0 +1,137 @@
+# -*- coding: utf-8 -*-
+"""
+Test the exponential backoff of the requests to the License Web Service.
+"""
+import pytest
+from threading import Thread, Timer
+
+from tests.fpga_drivers import get_driver
+from tests.ws_mock import LicenseWSMock
+
+
+@pytest.fixture
+def license_ws_mock(accelize_drm, conf_json):
+    """License Web Service mock and license retry policy set in the configuration file"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Retry policy tests require the "simulator" FPGA driver')
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    with LicenseWSMock(license_timeout=30) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json['settings']['ws_api_retry_duration'] = 20
+        conf_json['settings']['license_retry_policy'] = {
+            'base_period': 1, 'max_period': 4, 'multiplier': 2}
+        conf_json.save()
+        yield mock
+
+
+def _start_outage(mock, duration, retry_after=None):
+    """Reply to the license requests with errors for the specified duration"""
+    mock.configure(error_rate=1, error_codes=[503], error_endpoints=['license'],
+                   retry_after=retry_after)
+    timer = Timer(duration, lambda: mock.configure(error_rate=0))
+    timer.start()
+    return timer
+
+
+def _license_attempts(mock, dna=None):
+    """Return the time of the license requests of a board"""
+    return [entry['time'] for entry in mock.timeline()
+            if entry['endpoint'] == 'license' and (dna is None or entry['dna'] == dna)]
+
+
+def test_retry_after(accelize_drm, conf_json, cred_json, async_handler, license_ws_mock):
+    """Test the "Retry-After" delay returned with an error is respected"""
+    mock = license_ws_mock
+    async_cb = async_handler.create()
+    async_cb.reset()
+    driver = accelize_drm.pytest_fpga_driver[0]
+    drm_manager = accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, driver.read_register_callback,
+        driver.write_register_callback, async_cb.callback)
+    try:
+        mock.reset_stats()
+        timer = _start_outage(mock, 5, retry_after=2)
+        try:
+            drm_manager.activate()
+        finally:
+            timer.cancel()
+        assert drm_manager.get('license_status')
+        drm_manager.deactivate()
+    finally:
+        drm_manager.free()
+    attempts = _license_attempts(mock)
+    # Failed attempts at least 2 seconds apart, then the open and close requests
+    assert 4 <= len(attempts) <= 6
+    assert mock.stats()['errors']['license'] == len(attempts) - 2
+    failed = attempts[:len(attempts) - 2]
+    for previous, current in zip(failed, failed[1:] + [attempts[-2]]):
+        assert current - previous >= 1.9
+    async_cb.assert_NoError()
+
+
+def test_invalid_retry_policy(accelize_drm, conf_json, cred_json, async_handler, license_ws_mock):
+    """Test an invalid retry policy is rejected"""
+    async_cb = async_handler.create()
+    async_cb.reset()
+    driver = accelize_drm.pytest_fpga_driver[0]
+    conf_json['settings']['license_retry_policy'] = {'base_period': 2, 'max_period': 1}
+    conf_json.save()
+    with pytest.raises(accelize_drm.exceptions.DRMBadArg) as excinfo:
+        accelize_drm.DrmManager(
+            conf_json.path, cred_json.path, driver.read_register_callback,
+            driver.write_register_callback, async_cb.callback)
+    assert 'Invalid value for license_retry_policy.max_period' in str(excinfo.value)
+    async_cb.reset()
+
+
+def test_fleet_outage(accelize_drm, conf_json, cred_json, async_handler, license_ws_mock):
+    """
+    Test a fleet of boards failing at the same time does not retry in lockstep,
+    and recovers when the outage ends
+    """
+    mock = license_ws_mock
+    nb_boards = 8
+    async_cb = async_handler.create()
+    async_cb.reset()
+    drivers = [get_driver('simulator')(fpga_slot_id=i, drm_ctrl_base_addr=0)
+               for i in range(nb_boards)]
+    drm_managers = [accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, driver.read_register_callback,
+        driver.write_register_callback, async_cb.callback) for driver in drivers]
+    errors = []
+
+    def activate(drm_manager):
+        try:
+            drm_manager.activate()
+        except Exception as exception:
+            errors.append(exception)
+
+    try:
+        mock.reset_stats()
+        timer = _start_outage(mock, 6)
+        try:
+            threads = [Thread(target=activate, args=(drm_manager,)) for drm_manager in drm_managers]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+        finally:
+            timer.cancel()
+        assert not errors
+        assert all(drm_manager.get('license_status') for drm_manager in drm_managers)
+        assert mock.stats()['sessions_open'] == nb_boards
+    finally:
+        for drm_manager in drm_managers:
+            drm_manager.free()
+
+    # The second attempts of the boards are spread over the first backoff period
+    timeline = [entry for entry in mock.timeline() if entry['endpoint'] == 'license']
+    boards = {}
+    for entry in timeline:
+        boards.setdefault(entry['dna'], []).append(entry['time'])
+    assert len(boards) == nb_boards
+    delays = [times[1] - times[0] for times in boards.values()]
+    assert max(delays) - min(delays) > 0.2
+    assert max(delays) <= 1.5
+    async_cb.assert_NoError()
@@ -0,0 +1,141 @@
+# -*- coding: utf-8 -*-
+"""
+Test the deferred session close through the session spool.
+"""
+import pytest
+from os import listdir
+from time import time
+
+from tests.conftest import wait_func_true
+from tests.ws_mock import LicenseWSMock
+
+
+@pytest.fixture
+def license_ws_mock(accelize_drm, conf_json, tmpdir):
+    """License Web Service mock and session spool set in the configuration file"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Session spool tests require the "simulator" FPGA driver')
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    with LicenseWSMock(license_timeout=30) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json['settings']['session_spool_dir'] = str(tmpdir.join('spool'))
+        conf_json['settings']['ws_api_retry_duration'] = 10
+        conf_json.save()
+        mock.spool_dir = conf_json['settings']['session_spool_dir']
+        yield mock
+
+
+def _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb):
+    driver = accelize_drm.pytest_fpga_driver[0]
+    return accelize_drm.DrmManager(
+        conf_json.path, cred_json.path, driver.read_register_callback,
+        driver.write_register_callback, async_cb.callback)
+
+
+def test_deferred_close(accelize_drm, conf_json, cred_json, async_handler,
+                        license_ws_mock):
+    """
+    Test the close request is posted in background after deactivate
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    mock = license_ws_mock
+    drm_manager = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        drm_manager.activate()
+        assert drm_manager.get('session_status')
+        drm_manager.deactivate()
+        assert not drm_manager.get('session_status')
+        wait_func_true(lambda: mock.stats()['license_requests']['close'] == 1,
+                       timeout=10, sleep_time=0.1)
+        wait_func_true(lambda: not listdir(mock.spool_dir), timeout=10, sleep_time=0.1)
+    finally:
+        drm_manager.free()
+    assert mock.stats()['sessions_open'] == 0
+    async_cb.assert_NoError()
+
+
+def test_deferred_close_on_ws_outage(accelize_drm, conf_json, cred_json,
+                                     async_handler, license_ws_mock, record_property):
+    """
+    Test deactivate does not wait for an unavailable Web Service, and the next
+    DrmManager using the spool posts the close request
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    mock = license_ws_mock
+    drm_manager = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        drm_manager.activate()
+        mock.configure(error_rate=1.0, error_codes=[503], error_endpoints=['license'])
+        start = time()
+        drm_manager.deactivate()
+        duration = time() - start
+    finally:
+        drm_manager.free()
+    record_property('deactivate_duration', duration)
+    assert duration < 2
+    assert len(listdir(mock.spool_dir)) == 1
+    assert mock.stats()['license_requests']['close'] == 0
+
+    # The Web Service is back: the next instance posts the pending request
+    mock.configure(error_rate=0.0)
+    drm_manager = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        wait_func_true(lambda: not listdir(mock.spool_dir), timeout=10, sleep_time=0.1)
+    finally:
+        drm_manager.free()
+    assert mock.stats()['license_requests']['close'] == 1
+    assert mock.stats()['sessions_open'] == 0
+    async_cb.assert_NoError()
+
+
+def test_deferred_close_retry(accelize_drm, conf_json, cred_json, async_handler,
+                              license_ws_mock):
+    """
+    Test the close request is retried in background until the Web Service is back
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    mock = license_ws_mock
+    conf_json['settings']['license_retry_policy'] = {'base_period': 0.2, 'max_period': 0.5}
+    conf_json.save()
+    drm_manager = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        drm_manager.activate()
+        mock.configure(error_rate=1.0, error_codes=[503], error_endpoints=['license'])
+        drm_manager.deactivate()
+        wait_func_true(lambda: mock.stats()['errors']['license'] >= 3, timeout=10, sleep_time=0.1)
+        assert len(listdir(mock.spool_dir)) == 1
+        mock.configure(error_rate=0.0)
+        wait_func_true(lambda: not listdir(mock.spool_dir), timeout=10, sleep_time=0.1)
+    finally:
+        drm_manager.free()
+    assert mock.stats()['license_requests']['close'] == 1
+    assert mock.stats()['sessions_open'] == 0
+    async_cb.assert_NoError()
+
+
+def test_deferred_close_rejected(accelize_drm, conf_json, cred_json, async_handler,
+                                 license_ws_mock):
+    """
+    Test a close request rejected by the Web Service is dropped and reported
+    """
+    async_cb = async_handler.create()
+    async_cb.reset()
+    mock = license_ws_mock
+    drm_manager = _new_drm_manager(accelize_drm, conf_json, cred_json, async_cb)
+    try:
+        drm_manager.activate()
+        session_id = drm_manager.get('session_id')
+        mock.configure(error_rate=1.0, error_codes=[400], error_endpoints=['license'])
+        drm_manager.deactivate()
+        wait_func_true(lambda: not listdir(mock.spool_dir), timeout=10, sleep_time=0.1)
+        wait_func_true(lambda: async_cb.was_called, timeout=10, sleep_time=0.1)
+    finally:
+        drm_manager.free()
+    async_cb.assert_Error(accelize_drm.exceptions.DRMWSError.error_code,
+                          'close request of session %s was rejected' % session_id)
+    assert mock.stats()['license_requests']['close'] == 0
+    async_cb.reset()
@@ -0,0 +1,52 @@
+# -*- coding: utf-8 -*-
+"""
+Test the status snapshot read by the status parameters when "status_cached" is enabled.
+"""
+import pytest
+from time import sleep
+
+from tests.conftest import wait_func_true
+from tests.ws_mock import LicenseWSMock
+
+
+@pytest.fixture
+def license_ws_mock(accelize_drm, conf_json):
+    """License Web Service mock with short licenses"""
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('Status snapshot tests require the "simulator" FPGA driver')
+    accelize_drm.pytest_fpga_driver[0].reset_fpga()
+    with LicenseWSMock(license_timeout=3) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json['settings']['status_cached'] = True
+        conf_json.save()
+        yield mock
+
+
+def test_status_snapshot_expiration(accelize_drm, conf_json, cred_json, async_handler,
+                                    license_ws_mock):
+    """
+    Test the cached license status is not reported active after the expiration
+    of the license, when no snapshot has been published since
+    """
+    mock = license_ws_mock
+    license_duration = mock.config['license_timeout']
+    driver = accelize_drm.pytest_fpga_driver[0]
+    async_cb = async_handler.create()
+    async_cb.reset()
+    with accelize_drm.DrmManager(
+            conf_json.path, cred_json.path, driver.read_register_callback,
+            driver.write_register_callback, async_cb.callback) as drm_manager:
+        drm_manager.activate()
+        # Wait the licensing thread has provisioned the next license, then fail the renewals
+        wait_func_true(lambda: drm_manager.get('num_license_loaded') == 2,
+                       timeout=license_duration * 2, sleep_time=0.1)
+        mock.configure(error_rate=1, error_codes=[503], error_endpoints=['license'])
+        assert drm_manager.get('license_status')
+        version = drm_manager.get('status_version')
+        sleep(license_duration * 2 + 1)
+        assert not drm_manager.get('license_status')
+        assert drm_manager.get('status_version') > version
+        mock.configure(error_rate=0)
+        drm_manager.deactivate()
+    async_cb.reset()
@@ -89,3 +89,54 @@ def test_request_timeout(accelize_drm, conf_json, cred_json, async_handler,
     async_cb.assert_Error(accelize_drm.exceptions.DRMWSMayRetry.error_code, 'Failed to perform HTTP request to Accelize webservice')
     async_cb.assert_Error(accelize_drm.exceptions.DRMWSMayRetry.error_code, HTTP_TIMEOUT_ERR_MSG)
     async_cb.reset()
+
+
+@pytest.mark.parametrize('stop', ['deactivate', 'free'])
+def test_inflight_request_abort(accelize_drm, conf_json, cred_json, async_handler,
+                                record_property, stop):
+    """
+    Test deactivate and the DrmManager destructor abort a pending license
+    request instead of waiting for its timeout
+    """
+    from time import time, sleep
+    from tests.ws_mock import LicenseWSMock
+
+    if accelize_drm.pytest_fpga_driver_name != 'simulator':
+        pytest.skip('In-flight request abort test requires the "simulator" FPGA driver')
+    driver = accelize_drm.pytest_fpga_driver[0]
+    driver.reset_fpga()
+    async_cb = async_handler.create()
+    async_cb.reset()
+    request_timeout = 20
+    license_timeout = 8
+    with LicenseWSMock(license_timeout=license_timeout) as mock:
+        conf_json.reset()
+        conf_json['licensing']['url'] = mock.url
+        conf_json['settings']['ws_request_timeout'] = request_timeout
+        conf_json.save()
+        drm_manager = accelize_drm.DrmManager(
+            conf_json.path, cred_json.path, driver.read_register_callback,
+            driver.write_register_callback, async_cb.callback)
+        try:
+            drm_manager.activate()
+            assert drm_manager.get('license_status')
+            # Wait the license queue is full
+            wait_func_true(lambda: mock.stats()['requests']['license'] >= 2,
+                           timeout=5, sleep_time=0.1)
+            sleep(1)
+
+            # The next license request of the background thread hangs on the server
+            mock.configure(latency=request_timeout + 10)
+            wait_func_true(lambda: mock.stats()['requests']['license'] >= 3,
+                           timeout=license_timeout + 5, sleep_time=0.1)
+            sleep(0.5)
+            mock.configure(latency=0)
+
+            start = time()
+            getattr(drm_manager, stop)()
+            duration = time() - start
+        finally:
+            drm_manager.free()
+    record_property('%s_duration' % stop, duration)
+    assert duration < 3
+    async_cb.assert_NoError()
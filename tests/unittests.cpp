@@ -620,6 +620,14 @@ int test_types_of_get_and_set_functions() {
         double db = sDrm->get_double(cpp::ParameterKey::frequency_detection_threshold);
         CHECK_VALUE(db, d)
 
+        sDrm->set_uint(cpp::ParameterKey::metering_cache_period, 1500);
+        ui32 = sDrm->get_uint(cpp::ParameterKey::metering_cache_period);
+        CHECK_VALUE(ui32, 1500)
+        Json::Value jvs;
+        jvs["metering_cache_period"] = Json::nullValue;
+        sDrm->get_json_value(jvs);
+        CHECK_VALUE(jvs["metering_cache_period"].asUInt(), ui32)
+
         sDrm->set_string(cpp::ParameterKey::log_message, "My test string");
         str = sDrm->get_string(cpp::ParameterKey::license_type);
         CHECK_STRING(str, "Floating/Metering")
@@ -660,6 +668,104 @@ int test_types_of_get_and_set_functions() {
     return ret;
 }
 
+// Test the lookup of each parameter key by ID and by name, and the typed get functions
+int test_parameter_key_lookup() {
+    static const char* const key_names[] = {
+    #   define PARAMETERKEY_ITEM(id) #id,
+    #   include "accelize/drm/ParameterKey.def"
+    #   undef PARAMETERKEY_ITEM
+    };
+    int ret = -1;
+    string str;
+
+    sDrm->create();
+    try {
+        // Lookup by ID: the parameter list is ordered by ID
+        Json::Value jvl;
+        jvl["list_all"] = Json::nullValue;
+        sDrm->get_json_value(jvl);
+        CHECK_VALUE(jvl["list_all"].size(), (unsigned int)cpp::ParameterKey::ParameterKeyCount)
+        for (int i = 0; i < cpp::ParameterKey::ParameterKeyCount; i++) {
+            CHECK_VALUE(jvl["list_all"][i].asString(), string(key_names[i]))
+        }
+
+        // Lookup by name: every name is found, even if the parameter cannot be read
+        for (int i = 0; i < cpp::ParameterKey::ParameterKeyCount; i++) {
+            Json::Value jv;
+            jv[key_names[i]] = Json::nullValue;
+            try {
+                sDrm->get_json_value(jv);
+            } catch( const cpp::Exception& e ) {
+                str = e.what();
+                if (str.find("Cannot find parameter") != string::npos) {
+                    cout << __FUNCTION__ << ", " << __LINE__ << " - ERROR - parameter not found: " << key_names[i] << endl;
+                    return -1;
+                }
+            }
+        }
+
+        // Lookup of an unknown name
+        try {
+            Json::Value jv;
+            jv["unknown_parameter"] = Json::nullValue;
+            sDrm->get_json_value(jv);
+            cout << __FUNCTION__ << ", " << __LINE__ << " - ERROR - unknown parameter found" << endl;
+            return -1;
+        } catch( const cpp::Exception& e ) {
+            CHECK_VALUE(e.getErrCode(), DRM_ErrorCode::DRM_BadArg)
+            str = e.what();
+            CHECK_STRING(str, "Cannot find parameter: unknown_parameter")
+        }
+
+        // Typed get functions return the same value as the JSON get
+        const cpp::ParameterKey uint_keys[] = {
+            cpp::ParameterKey::license_duration, cpp::ParameterKey::num_activators,
+            cpp::ParameterKey::num_license_loaded, cpp::ParameterKey::status_version,
+            cpp::ParameterKey::metering_cache_period, cpp::ParameterKey::drm_frequency,
+            cpp::ParameterKey::health_period, cpp::ParameterKey::health_retry,
+            cpp::ParameterKey::health_retry_sleep, cpp::ParameterKey::ws_retry_period_long,
+            cpp::ParameterKey::ws_retry_period_short, cpp::ParameterKey::ws_api_retry_duration,
+            cpp::ParameterKey::log_verbosity, cpp::ParameterKey::log_file_verbosity,
+            cpp::ParameterKey::log_file_type, cpp::ParameterKey::log_file_rotating_num,
+            cpp::ParameterKey::log_file_rotating_size, cpp::ParameterKey::log_ctrl_verbosity,
+            cpp::ParameterKey::log_message_level, cpp::ParameterKey::host_data_verbosity,
+            cpp::ParameterKey::frequency_detection_method, cpp::ParameterKey::frequency_detection_period,
+            cpp::ParameterKey::custom_field
+        };
+        for (const cpp::ParameterKey key : uint_keys) {
+            uint64_t ui64 = sDrm->get_uint64(key);
+            Json::Value jv;
+            jv[key_names[key]] = Json::nullValue;
+            sDrm->get_json_value(jv);
+            CHECK_VALUE(ui64, jv[key_names[key]].asUInt64())
+        }
+        const cpp::ParameterKey bool_keys[] = {
+            cpp::ParameterKey::session_status, cpp::ParameterKey::license_status,
+            cpp::ParameterKey::status_cached, cpp::ParameterKey::log_file_append,
+            cpp::ParameterKey::log_async, cpp::ParameterKey::bypass_frequency_detection,
+            cpp::ParameterKey::is_drm_software
+        };
+        for (const cpp::ParameterKey key : bool_keys) {
+            bool b = sDrm->get_bool(key);
+            Json::Value jv;
+            jv[key_names[key]] = Json::nullValue;
+            sDrm->get_json_value(jv);
+            CHECK_VALUE(b, jv[key_names[key]].asBool())
+        }
+        double d = sDrm->get_double(cpp::ParameterKey::frequency_detection_threshold);
+        Json::Value jvd;
+        jvd["frequency_detection_threshold"] = Json::nullValue;
+        sDrm->get_json_value(jvd);
+        CHECK_VALUE(d, jvd["frequency_detection_threshold"].asDouble())
+
+        ret = 0;
+    } catch( const cpp::Exception& e ) {
+        ret = e.getErrCode();
+    }
+    sDrm->destroy();
+    return ret;
+}
+
 // Test out_of_range on get function
 int test_get_function_out_of_range() {
     int ret = -1;
@@ -852,6 +958,9 @@ int main(int argc, char **argv) {
         if (test_name == "test_types_of_get_and_set_functions")
             ret = test_types_of_get_and_set_functions();
 
+        if (test_name == "test_parameter_key_lookup")
+            ret = test_parameter_key_lookup();
+
         if (test_name == "test_get_function_out_of_range")
             ret = test_get_function_out_of_range();
 
@@ -0,0 +1,319 @@
+# coding=utf-8
+"""
+Local mock of the Accelize License Web Service.
+
+Serves "/o/token/", "/auth/metering/genlicense/" and "/auth/metering/health/"
+without contacting the real service, with configurable latency, error injection
+and license timeout. The licenses follow the conventions of the DRM Controller
+simulator (tests/simulator): the session ID is the first 64 bits of the license
+key and the license duration in DRM clock cycles is the first 64 bits of the
+license timer. They are only accepted by the simulator.
+
+Additional routes:
+    GET /stats/: Return the request statistics as JSON.
+    GET /timeline/: Return the time, endpoint, HTTP code and DNA of each request as JSON.
+    POST /config/: Update the configuration with the JSON body.
+
+Usage:
+    python3 tests/ws_mock.py --port 8080 --latency 0.05 --error-rate 0.01
+"""
+from argparse import ArgumentParser as _ArgumentParser
+from http.server import ThreadingHTTPServer as _ThreadingHTTPServer, \
+    BaseHTTPRequestHandler as _BaseHTTPRequestHandler
+from json import dumps as _dumps, loads as _loads
+from random import random as _random, uniform as _uniform, choice as _choice, \
+    getrandbits as _getrandbits
+from threading import Lock as _Lock, Thread as _Thread
+from time import sleep as _sleep, monotonic as _monotonic
+
+__all__ = ['LicenseWSMock', 'RETRYABLE_ERROR_CODES']
+
+# HTTP codes retried by the DRM library, see CurlEasyPost::is_error_retryable
+RETRYABLE_ERROR_CODES = (408, 429, 470, 495, 500, 502, 503, 504, 505, 507,
+                         520, 521, 522, 524, 525, 526, 527, 530)
+
+# Size in 32 bits words of the license header and of each IP block
+_LICENSE_HEADER_WORDS = 7 * 4
+_LICENSE_IP_BLOCK_WORDS = 4 * 4
+
+_DEFAULT_CONFIG = {
+    'latency': 0.0,             # Mean response time in seconds
+    'latency_jitter': 0.0,      # Response time varies uniformly by +/- this value
+    'error_rate': 0.0,          # Probability to reply with an error
+    'error_codes': [408, 429, 500, 502, 503, 504],  # HTTP codes of the injected errors
+    'error_endpoints': ['token', 'license', 'health'],  # Endpoints with injected errors
+    'retry_after': None,        # "Retry-After" delay in seconds sent with the injected errors
+    'license_timeout': 30,      # Duration in seconds of each license
+    'health_period': 0,         # Health period in seconds, 0 disables the health requests
+    'health_retry': 0,
+    'health_retry_sleep': 1,
+    'token_validity': 3600,     # OAuth2 token validity in seconds
+}
+
+
+def _random_hex(nb_digits):
+    """Return a random upper case hexadecimal string"""
+    return '%0*X' % (nb_digits, _getrandbits(nb_digits * 4))
+
+
+class LicenseWSMock(_ThreadingHTTPServer):
+    """
+    Mock of the License Web Service running in a background thread.
+
+    Args:
+        host (str): Listening address.
+        port (int): Listening port, 0 selects a free port.
+        config: Values overriding the default configuration.
+    """
+    daemon_threads = True
+    request_queue_size = 1024
+
+    def __init__(self, host='127.0.0.1', port=0, **config):
+        _ThreadingHTTPServer.__init__(self, (host, port), _Handler)
+        self._lock = _Lock()
+        self._config = dict(_DEFAULT_CONFIG)
+        self._thread = None
+        self.configure(**config)
+        self.reset_stats()
+
+    @property
+    def url(self):
+        """Base URL to set in the "licensing" section of the configuration file"""
+        return 'http://%s:%d' % self.server_address[:2]
+
+    def configure(self, **config):
+        """Update the configuration"""
+        unknown = set(config) - set(_DEFAULT_CONFIG)
+        if unknown:
+            raise ValueError('Unknown mock configuration: %s' % ', '.join(sorted(unknown)))
+        with self._lock:
+            self._config.update(config)
+
+    @property
+    def config(self):
+        """Current configuration"""
+        with self._lock:
+            return dict(self._config)
+
+    def reset_stats(self):
+        """Reset the request statistics"""
+        with self._lock:
+            self._stats = {
+                'requests': {'token': 0, 'license': 0, 'health': 0},
+                'errors': {'token': 0, 'license': 0, 'health': 0},
+                'license_requests': {'open': 0, 'running': 0, 'close': 0},
+                'sessions_open': 0,
+                'max_concurrency': 0,
+            }
+            self._timeline_start = _monotonic()
+            self._concurrency = 0
+            self._timeline = []
+
+    def stats(self):
+        """Return the request statistics"""
+        with self._lock:
+            return _loads(_dumps(self._stats))
+
+    def timeline(self):
+        """Return the requests in arrival order: time in seconds since the last statistics
+        reset, endpoint, HTTP code of the reply and DNA of the license requests"""
+        with self._lock:
+            return [dict(entry) for entry in self._timeline]
+
+    def start(self):
+        """Serve the requests in a background thread"""
+        self._thread = _Thread(target=self.serve_forever, daemon=True)
+        self._thread.start()
+        return self
+
+    def stop(self):
+        """Stop serving and close the socket"""
+        self.shutdown()
+        self.server_close()
+        if self._thread:
+            self._thread.join()
+
+    def __enter__(self):
+        return self.start()
+
+    def __exit__(self, *_):
+        self.stop()
+
+    def _begin(self, endpoint, request):
+        """Account a request, return the configuration and an injected error code or None"""
+        with self._lock:
+            config = dict(self._config)
+            self._stats['requests'][endpoint] += 1
+            self._concurrency += 1
+            self._stats['max_concurrency'] = max(self._stats['max_concurrency'], self._concurrency)
+            error = None
+            if endpoint in config['error_endpoints'] and _random() < config['error_rate']:
+                error = _choice(config['error_codes'])
+                self._stats['errors'][endpoint] += 1
+            self._timeline.append({
+                'time': _monotonic() - self._timeline_start, 'endpoint': endpoint,
+                'code': error or 200, 'dna': request.get('dna')})
+        return config, error
+
+    def _end(self):
+        with self._lock:
+            self._concurrency -= 1
+
+    def _license(self, request, config):
+        """Build the response to a license request"""
+        request_type = request.get('request', 'open')
+        with self._lock:
+            self._stats['license_requests'][request_type] = \
+                self._stats['license_requests'].get(request_type, 0) + 1
+            if request_type == 'open':
+                self._stats['sessions_open'] += 1
+            elif request_type == 'close':
+                self._stats['sessions_open'] -= 1
+
+        metering = self._metering(config)
+        if request_type == 'open':
+            session_id = _random_hex(16)
+        else:
+            session_id = request.get('sessionId', '').upper()
+        metering['sessionId'] = session_id
+        metering['timeoutSecond'] = config['license_timeout']
+        if request_type == 'close':
+            return {'metering': metering}
+
+        nb_ips = max(len(request.get('vlnvFile', {})) - 1, 1)
+        key_words = _LICENSE_HEADER_WORDS + _LICENSE_IP_BLOCK_WORDS * nb_ips
+        frequency = request.get('drm_frequency') or request.get('drm_frequency_init') or 125
+        cycles = int(config['license_timeout'] * frequency * 1000000)
+        dna_node = {
+            'key': session_id + _random_hex(key_words * 8 - 16),
+            # Random trailing bits so that consecutive timers differ
+            'licenseTimer': '%016X' % cycles + _random_hex(80),
+        }
+        return {'metering': metering, 'license': {request.get('dna', ''): dna_node}}
+
+    @staticmethod
+    def _metering(config):
+        return {
+            'healthPeriod': config['health_period'],
+            'healthRetry': config['health_retry'],
+            'healthRetrySleep': config['health_retry_sleep'],
+        }
+
+
+class _Handler(_BaseHTTPRequestHandler):
+    """Request handler of LicenseWSMock"""
+    protocol_version = 'HTTP/1.1'
+
+    _ROUTES = {
+        '/o/token/': 'token',
+        '/auth/metering/genlicense/': 'license',
+        '/auth/metering/health/': 'health',
+    }
+
+    def log_message(self, *_):
+        """Do not log each request"""
+
+    def _reply(self, code, content, headers=None):
+        body = _dumps(content).encode()
+        self.send_response(code)
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def _read_json(self):
+        length = int(self.headers.get('Content-Length', 0))
+        data = self.rfile.read(length) if length else b''
+        try:
+            return _loads(data) if data else {}
+        except ValueError:
+            return {}
+
+    def do_GET(self):
+        if self.path.rstrip('/') == '/stats':
+            return self._reply(200, self.server.stats())
+        if self.path.rstrip('/') == '/timeline':
+            return self._reply(200, self.server.timeline())
+        self._reply(404, {'detail': 'Not found'})
+
+    def do_POST(self):
+        if self.path.rstrip('/') == '/config':
+            try:
+                self.server.configure(**self._read_json())
+            except ValueError as exception:
+                return self._reply(400, {'detail': str(exception)})
+            return self._reply(200, self.server.config)
+
+        endpoint = self._ROUTES.get(self.path)
+        if endpoint is None:
+            return self._reply(404, {'detail': 'Not found'})
+        # The token request is form encoded and its credentials are not checked
+        request = self._read_json()
+
+        start = _monotonic()
+        config, error = self.server._begin(endpoint, request)
+        try:
+            delay = config['latency']
+            if config['latency_jitter']:
+                delay += _uniform(-config['latency_jitter'], config['latency_jitter'])
+            if delay > 0:
+                _sleep(max(0.0, delay - (_monotonic() - start)))
+
+            if error is not None:
+                headers = None
+                if config['retry_after'] is not None:
+                    headers = {'Retry-After': str(config['retry_after'])}
+                return self._reply(error, {'detail': 'Error injected by the mock'}, headers)
+            if endpoint == 'token':
+                return self._reply(200, {
+                    'access_token': _random_hex(30).lower(),
+                    'expires_in': config['token_validity'],
+                    'token_type': 'Bearer', 'scope': 'read write'})
+            if endpoint == 'license':
+                return self._reply(200, self.server._license(request, config))
+            return self._reply(200, {'metering': LicenseWSMock._metering(config)})
+        finally:
+            self.server._end()
+
+
+def _main():
+    parser = _ArgumentParser(description='Local mock of the Accelize License Web Service')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--latency', type=float, default=0.0, help='Mean response time in seconds')
+    parser.add_argument('--latency-jitter', type=float, default=0.0,
+                        help='Uniform variation of the response time in seconds')
+    parser.add_argument('--error-rate', type=float, default=0.0,
+                        help='Probability to reply with an error')
+    parser.add_argument('--error-codes', default='408,429,500,502,503,504',
+                        help='Comma separated HTTP codes of the injected errors')
+    parser.add_argument('--retry-after', type=int, default=None,
+                        help='"Retry-After" delay in seconds sent with the injected errors')
+    parser.add_argument('--license-timeout', type=int, default=30,
+                        help='Duration in seconds of each license')
+    parser.add_argument('--health-period', type=int, default=0,
+                        help='Health period in seconds, 0 disables the health requests')
+    parser.add_argument('--token-validity', type=int, default=3600,
+                        help='OAuth2 token validity in seconds')
+    args = parser.parse_args()
+
+    server = LicenseWSMock(
+        args.host, args.port, latency=args.latency, latency_jitter=args.latency_jitter,
+        error_rate=args.error_rate, error_codes=[int(c) for c in args.error_codes.split(',')],
+        retry_after=args.retry_after,
+        license_timeout=args.license_timeout, health_period=args.health_period,
+        token_validity=args.token_validity)
+    print('License Web Service mock listening on %s' % server.url, flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+        print(_dumps(server.stats(), indent=4))
+
+
+if __name__ == '__main__':
+    _main()
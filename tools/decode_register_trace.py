@@ -0,0 +1,131 @@
+#! /usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Decode a DRM Controller register trace dumped by the DRM library.
+
+The trace is enabled with the "register_trace_size" setting of the configuration
+file and dumped with the "register_trace_dump" parameter or on asynchronous error.
+Register offsets are translated into register names using the layout of the
+DRM Controller version stored in the trace.
+
+Usage: decode_register_trace.py TRACE_FILE [--csv]
+"""
+from argparse import ArgumentParser
+from struct import Struct
+
+_HEADER = Struct('<8sIIIIQQ')
+_ENTRY = Struct('<QIIIIBBHI')
+_MAGIC = b'DRMTRACE'
+
+_PAGE_NAMES = {
+    1: 'VlnvFile',
+    2: 'LicenseFile',
+    3: 'TraceFile',
+    4: 'MeteringFile',
+    5: 'Mailbox',
+}
+
+
+def registers_page_layout(ctrl_version):
+    """
+    Return the list of (name, number of words) of the registers page.
+
+    Args:
+        ctrl_version (int): DRM Controller version register value, 0 if unknown.
+
+    Returns:
+        list of tuple: Registers in address order.
+    """
+    version = ((ctrl_version >> 16) & 0xFF, (ctrl_version >> 8) & 0xFF)
+    layout = [('Command', 1), ('LicenseStartAddress', 2), ('LicenseTimer', 12),
+              ('Status', 1), ('Error', 1), ('DeviceDna', 4), ('SaasChallenge', 4)]
+    if ctrl_version == 0 or version >= (3, 1):
+        layout.append(('SampledLicenseTimerCount', 2))
+    layout.append(('Version', 1))
+    if ctrl_version == 0 or version >= (4, 2):
+        layout += [('AdaptiveProportionTestFailures', 1), ('RepetitionCountTestFailures', 1)]
+    return layout
+
+
+def register_name(layout, page, offset):
+    """
+    Return the name of the register at the specified offset.
+
+    Args:
+        layout (list of tuple): Registers page layout.
+        page (int): Page selected when the register was accessed, 0xFF if unknown.
+        offset (int): Register offset.
+
+    Returns:
+        str: Register name.
+    """
+    if offset == 0:
+        return 'DrmPageRegister'
+    line = (offset - 4) // 4
+    if page == 0:
+        index = 0
+        for name, size in layout:
+            if line < index + size:
+                return name if size == 1 else '%s[%d]' % (name, line - index)
+            index += size
+        return 'Logs[%d]' % (line - index)
+    if page in _PAGE_NAMES:
+        return '%s[%d]' % (_PAGE_NAMES[page], line)
+    return 'Page%s.DrmRegisterLine%d' % ('?' if page == 0xFF else page, line)
+
+
+def read_trace(file_path):
+    """
+    Read a register trace file.
+
+    Args:
+        file_path (str): Path to the trace file.
+
+    Returns:
+        tuple: DRM Controller version, number of lost entries and list of entries.
+    """
+    with open(file_path, 'rb') as trace_file:
+        content = trace_file.read()
+    magic, fmt_version, entry_size, ctrl_version, _, count, overwritten = \
+        _HEADER.unpack_from(content, 0)
+    if magic != _MAGIC:
+        raise ValueError('%s is not a register trace file' % file_path)
+    if fmt_version != 1 or entry_size != _ENTRY.size:
+        raise ValueError('Unsupported trace format version %d' % fmt_version)
+    entries = [_ENTRY.unpack_from(content, _HEADER.size + i * entry_size)
+               for i in range(count)]
+    return ctrl_version, overwritten, entries
+
+
+def main():
+    """Decode the trace file and print one access per line"""
+    parser = ArgumentParser(description='Decode a DRM Controller register trace')
+    parser.add_argument('trace_file', help='Path to the trace file')
+    parser.add_argument('--csv', action='store_true', help='Print as CSV')
+    args = parser.parse_args()
+
+    ctrl_version, overwritten, entries = read_trace(args.trace_file)
+    layout = registers_page_layout(ctrl_version)
+    if not args.csv:
+        print('DRM Controller version: %d.%d.%d, %d entries, %d lost' % (
+            (ctrl_version >> 16) & 0xFF, (ctrl_version >> 8) & 0xFF, ctrl_version & 0xFF,
+            len(entries), overwritten))
+    else:
+        print('time_us,thread,access,page,offset,register,value,latency_ns,errcode')
+    start = entries[0][0] if entries else 0
+    for timestamp, thread, offset, value, latency, access, page, errcode, _ in entries:
+        time_us = (timestamp - start) / 1000.0
+        access_str = 'W' if access else 'R'
+        page_str = '?' if page == 0xFF else str(page)
+        name = register_name(layout, page, offset)
+        if args.csv:
+            print('%.3f,%d,%s,%s,0x%X,%s,0x%08X,%d,%d' % (
+                time_us, thread, access_str, page_str, offset, name, value, latency, errcode))
+        else:
+            print('%12.3f us  tid=%-7d %s  page=%s  0x%03X %-32s 0x%08X  %6d ns%s' % (
+                time_us, thread, access_str, page_str, offset, name, value, latency,
+                '  err=%d' % errcode if errcode else ''))
+
+
+if __name__ == '__main__':
+    main()